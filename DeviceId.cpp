@@ -14,7 +14,6 @@
 // limitations under the License.
 ////////////////////////////////////////////////////////////////////////////////
 
-#include <cassert>
 #include "DeviceId.h"
 
 
@@ -61,101 +60,39 @@ namespace GPUDetect
 		case IGFX_UNKNOWN:
 		case IGFX_MAX_PRODUCT:
 		default:
-			assert(false);
 			return "Unknown";
 		}
 	}
 
-	INTEL_GPU_ARCHITECTURE GetIntelGPUArchitecture( unsigned int deviceId )
-	{
-		const unsigned int idhi = deviceId & 0xFF00;
-		const unsigned int idlo = deviceId & 0x00FF;
-
-		if( idhi == 0x0100 )
-		{
-			if( ( idlo & 0xFFF0 ) == 0x0050 || ( idlo & 0xFFF0 ) == 0x0060 )
-			{
-				return IGFX_IVYBRIDGE;
-			}
-			return IGFX_SANDYBRIDGE;
-		}
-
-		if( idhi == 0x0400 || idhi == 0x0A00 || idhi == 0x0D00 || idhi == 0x0C00 )
-		{
-			return IGFX_HASWELL;
-		}
-
-		if( idhi == 0x1600 || idhi == 0x0B00 )
-		{
-			return IGFX_BROADWELL;
-		}
-
-		if( idhi == 0x1900 || idhi == 0x0900 )
-		{
-			return IGFX_SKYLAKE;
-		}
-
-		if( idhi == 0x5900 )
-		{
-			return IGFX_KABYLAKE;
-		}
-
-		if( idhi == 0x3100 )
-		{
-			return IGFX_GEMINILAKE;
-		}
-
-		if( idhi == 0x5A00 )
-		{
-			return IGFX_CANNONLAKE;
-		}
-
-		if( idhi == 0x3E00 )
-		{
-			if( idlo == 0x00A0 || idlo == 0x00A1 )
-			{
-				return IGFX_WHISKEYLAKE;
-			}
-			return IGFX_COFFEELAKE;
-		}
-
-		if ( idhi == 0x8A00 )
-		{
-			return IGFX_ICELAKE_LP;
-		}
-
-		if( idhi == 0x9A00 )
-		{
-			return IGFX_TIGERLAKE_LP;
-		}
-
-		if( idhi == 0x4900 )
-		{
-			return IGFX_DG1;
-		}
-
-		if (idhi == 0x4C00)
-		{
-			return IGFX_ROCKETLAKE;
-		}
-
-		if (idhi == 0x9B00)
-		{
-			return IGFX_COMETLAKE;
-		}
-
-		if (idhi == 0x4600)
-		{
-			return IGFX_ADL;
-		}
-
-		if (idhi == 0x5600)
-		{
-			return DGFX_ACM;
-		}
-
-		assert(false);
-		return IGFX_UNKNOWN;
-	}
+	// Spot checks of the compile-time decoder, including both sides of every
+	// override range. GPUDetectBench -archcheck compares all 65,536 ids
+	// against the original if-chain.
+	static_assert( GetIntelGPUArchitecture( 0x0102 ) == IGFX_SANDYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x014F ) == IGFX_SANDYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0150 ) == IGFX_IVYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0166 ) == IGFX_IVYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x016F ) == IGFX_IVYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0170 ) == IGFX_SANDYBRIDGE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0412 ) == IGFX_HASWELL, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0D26 ) == IGFX_HASWELL, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x1616 ) == IGFX_BROADWELL, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x1912 ) == IGFX_SKYLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x5916 ) == IGFX_KABYLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x3185 ) == IGFX_GEMINILAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x5A52 ) == IGFX_CANNONLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x3E9F ) == IGFX_COFFEELAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x3EA0 ) == IGFX_WHISKEYLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x3EA1 ) == IGFX_WHISKEYLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x3EA2 ) == IGFX_COFFEELAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x8A52 ) == IGFX_ICELAKE_LP, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x9A49 ) == IGFX_TIGERLAKE_LP, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x4905 ) == IGFX_DG1, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x4C8A ) == IGFX_ROCKETLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x9BC5 ) == IGFX_COMETLAKE, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x4680 ) == IGFX_ADL, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x56A0 ) == DGFX_ACM, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x2982 ) == IGFX_UNKNOWN, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0x0000 ) == IGFX_UNKNOWN, "device id decode mismatch" );
+	static_assert( GetIntelGPUArchitecture( 0xFFFF ) == IGFX_UNKNOWN, "device id decode mismatch" );
 
 }
@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <stddef.h>
+
 
 namespace GPUDetect
 {
@@ -64,23 +66,112 @@ namespace GPUDetect
 
 	};
 
+	/*******************************************************************************
+	 * IntelArchitectureTable
+	 *
+	 *      Maps the high byte of a device id to its architecture. Built at
+	 *      compile time by MakeIntelArchitectureTable.
+	 *
+	 ******************************************************************************/
+	struct IntelArchitectureTable
+	{
+		INTEL_GPU_ARCHITECTURE byHighByte[ 256 ];
+	};
+
+	constexpr IntelArchitectureTable MakeIntelArchitectureTable()
+	{
+		IntelArchitectureTable table = {};
+
+		table.byHighByte[ 0x01 ] = IGFX_SANDYBRIDGE;
+
+		table.byHighByte[ 0x04 ] = IGFX_HASWELL;
+		table.byHighByte[ 0x0A ] = IGFX_HASWELL;
+		table.byHighByte[ 0x0C ] = IGFX_HASWELL;
+		table.byHighByte[ 0x0D ] = IGFX_HASWELL;
+
+		table.byHighByte[ 0x0B ] = IGFX_BROADWELL;
+		table.byHighByte[ 0x16 ] = IGFX_BROADWELL;
+
+		table.byHighByte[ 0x09 ] = IGFX_SKYLAKE;
+		table.byHighByte[ 0x19 ] = IGFX_SKYLAKE;
+
+		table.byHighByte[ 0x59 ] = IGFX_KABYLAKE;
+		table.byHighByte[ 0x31 ] = IGFX_GEMINILAKE;
+		table.byHighByte[ 0x5A ] = IGFX_CANNONLAKE;
+		table.byHighByte[ 0x3E ] = IGFX_COFFEELAKE;
+		table.byHighByte[ 0x8A ] = IGFX_ICELAKE_LP;
+		table.byHighByte[ 0x9A ] = IGFX_TIGERLAKE_LP;
+		table.byHighByte[ 0x49 ] = IGFX_DG1;
+		table.byHighByte[ 0x4C ] = IGFX_ROCKETLAKE;
+		table.byHighByte[ 0x9B ] = IGFX_COMETLAKE;
+		table.byHighByte[ 0x46 ] = IGFX_ADL;
+		table.byHighByte[ 0x56 ] = DGFX_ACM;
+
+		return table;
+	}
+
+	constexpr IntelArchitectureTable kIntelArchitectureTable = MakeIntelArchitectureTable();
+
+	/*******************************************************************************
+	 * IntelArchitectureOverride
+	 *
+	 *      Device id ranges that belong to a different architecture than the
+	 *      rest of their high byte. Sorted by firstDeviceId.
+	 *
+	 ******************************************************************************/
+	struct IntelArchitectureOverride
+	{
+		unsigned int firstDeviceId;
+		unsigned int lastDeviceId;
+		INTEL_GPU_ARCHITECTURE architecture;
+	};
+
+	constexpr IntelArchitectureOverride kIntelArchitectureOverrides[] =
+	{
+		{ 0x0150, 0x016F, IGFX_IVYBRIDGE },    // inside Sandy Bridge's 0x01xx
+		{ 0x3EA0, 0x3EA1, IGFX_WHISKEYLAKE },  // inside Coffee Lake's 0x3Exx
+	};
+
 	/*******************************************************************************
 	 * getIntelGPUArchitecture
 	 *
 	 *      Returns the architecture of an Intel GPU by parsing the device id.  It
 	 *      assumes that it is indeed an Intel GPU device ID (i.e., that VendorID
-	 *      was INTEL_VENDOR_ID).
+	 *      was INTEL_VENDOR_ID). Unrecognized device ids return IGFX_UNKNOWN.
+	 *
+	 *      Only the low 16 bits of deviceId are used. The lookup is a table
+	 *      index plus a scan of the short override list, and can be evaluated
+	 *      at compile time.
 	 *
 	 *      You cannot generally compare device IDs to compare architectures; for
 	 *      example, a newer architecture may have an lower deviceID.
 	 *
 	 ******************************************************************************/
-	INTEL_GPU_ARCHITECTURE GetIntelGPUArchitecture(unsigned int deviceId);
+	constexpr INTEL_GPU_ARCHITECTURE GetIntelGPUArchitecture( unsigned int deviceId )
+	{
+		const unsigned int id = deviceId & 0xFFFF;
+
+		for( size_t i = 0; i < sizeof( kIntelArchitectureOverrides ) / sizeof( kIntelArchitectureOverrides[ 0 ] ); ++i )
+		{
+			const IntelArchitectureOverride& entry = kIntelArchitectureOverrides[ i ];
+			if( id < entry.firstDeviceId )
+			{
+				break;
+			}
+			if( id <= entry.lastDeviceId )
+			{
+				return entry.architecture;
+			}
+		}
+
+		return kIntelArchitectureTable.byHighByte[ id >> 8 ];
+	}
 
 	/*******************************************************************************
 	 * getIntelGPUArchitectureString
 	 *
-	 *     Convert A INTEL_GPU_ARCHITECTURE to a string.
+	 *     Convert A INTEL_GPU_ARCHITECTURE to a string. IGFX_UNKNOWN, and any
+	 *     value without a name, return "Unknown".
 	 *
 	 ******************************************************************************/
 	char const* GetIntelGPUArchitectureString(INTEL_GPU_ARCHITECTURE arch);
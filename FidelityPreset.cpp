@@ -0,0 +1,834 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#else
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#endif // _WIN32
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "GPUDetect.h"
+#include "GPUDetectBackend.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+struct PresetTableEntry
+{
+	uint32_t key;    // ( vendorID << 16 ) | deviceID, 0 for an empty slot
+	PresetLevel preset;
+};
+
+enum PresetRuleCondition
+{
+	RULE_VENDOR         = 0x01,
+	RULE_ARCHITECTURE   = 0x02,
+	RULE_GENERATION     = 0x04,
+	RULE_EU_COUNT       = 0x08,
+	RULE_MAX_FREQUENCY  = 0x10,
+	RULE_VIDEO_MEMORY   = 0x20,
+	RULE_DRIVER_VERSION = 0x40,
+};
+
+struct PresetRange
+{
+	uint32_t min;
+	uint32_t max;
+};
+
+struct PresetRule
+{
+	uint32_t conditions;  // RULE_* flags of the fields that are checked
+	unsigned int vendorID;
+	INTEL_GPU_ARCHITECTURE architecture;
+	IntelGraphicsGeneration generation;
+	PresetRange euCount;
+	PresetRange maxFrequency;   // MHz
+	PresetRange videoMemoryMB;
+	PresetRange driverVersion;  // ( driverReleaseRevision << 16 ) | driverBuildNumber
+	PresetLevel preset;
+};
+
+}
+
+}
+
+// Generated from the .cfg files by GeneratePresetTable.py
+#include "IntelGfxPresets.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+// Must match mix() in GeneratePresetTable.py
+uint32_t Mix( uint32_t x )
+{
+	x ^= x >> 16;
+	x *= 0x7FEB352D;
+	x ^= x >> 15;
+	x *= 0x846CA68B;
+	x ^= x >> 16;
+	return x;
+}
+
+//
+// What the preset lookup knows about a device. Batches of bare device IDs
+// leave everything but the IDs and the architecture at 0.
+//
+struct PresetQuery
+{
+	unsigned int vendorID;
+	unsigned int deviceID;
+	INTEL_GPU_ARCHITECTURE architecture;
+	unsigned int euCount;
+	unsigned int maxFrequency;
+	unsigned int videoMemoryMB;
+	bool driverVersionAvailability;
+	uint32_t driverVersion;
+};
+
+PresetQuery MakePresetQuery( unsigned int vendorID, unsigned int deviceID )
+{
+	PresetQuery query = {};
+	query.vendorID = vendorID;
+	query.deviceID = deviceID;
+	query.architecture = vendorID == INTEL_VENDOR_ID ? GetIntelGPUArchitecture( deviceID ) : IGFX_UNKNOWN;
+	return query;
+}
+
+// Whether architecture is a value of INTEL_GPU_ARCHITECTURE that the
+// rules can name. The counter reports the driver's value, which is outside
+// the enum for parts newer than this library.
+bool IsKnownArchitecture( INTEL_GPU_ARCHITECTURE architecture )
+{
+	switch( architecture )
+	{
+	case IGFX_SANDYBRIDGE:
+	case IGFX_IVYBRIDGE:
+	case IGFX_HASWELL:
+	case IGFX_VALLEYVIEW:
+	case IGFX_BROADWELL:
+	case IGFX_CHERRYVIEW:
+	case IGFX_SKYLAKE:
+	case IGFX_KABYLAKE:
+	case IGFX_COFFEELAKE:
+	case IGFX_WILLOWVIEW:
+	case IGFX_BROXTON:
+	case IGFX_GEMINILAKE:
+	case IGFX_CANNONLAKE:
+	case IGFX_ICELAKE:
+	case IGFX_ICELAKE_LP:
+	case IGFX_LAKEFIELD:
+	case IGFX_TIGERLAKE_LP:
+	case IGFX_ROCKETLAKE:
+	case IGFX_ADL:
+	case IGFX_ADL_LP:
+	case DGFX_ACM:
+	case IGFX_DG1:
+	case IGFX_WHISKEYLAKE:
+	case IGFX_COMETLAKE:
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+PresetQuery MakePresetQuery( const GPUData& gpuData )
+{
+	PresetQuery query = MakePresetQuery( gpuData.vendorID, gpuData.deviceID );
+
+	// An architecture this library does not know is left to the device ID
+	// table, which has IGFX_UNKNOWN for parts newer than it, so the rules for
+	// those parts apply
+	if( IsKnownArchitecture( gpuData.architecture ) )
+	{
+		query.architecture = gpuData.architecture;
+	}
+	query.euCount = gpuData.euCount;
+	query.maxFrequency = gpuData.maxFrequency;
+	query.videoMemoryMB = (unsigned int) std::min< uint64_t >( gpuData.videoMemory / ( 1024 * 1024 ), UINT32_MAX );
+	query.driverVersionAvailability = gpuData.d3dRegistryDataAvailability;
+	query.driverVersion = ( gpuData.driverInfo.driverReleaseRevision << 16 ) | ( gpuData.driverInfo.driverBuildNumber & 0xFFFF );
+	return query;
+}
+
+bool InRange( const PresetRange& range, uint32_t value )
+{
+	return value >= range.min && value <= range.max;
+}
+
+// The rules are sorted by priority, so the first one that matches applies
+PresetLevel GetRulePreset( const PresetQuery& query )
+{
+	const IntelGraphicsGeneration generation = GetIntelGraphicsGeneration( query.architecture );
+
+	for( unsigned int i = 0; i < kPresetRuleCount; ++i )
+	{
+		const PresetRule& rule = kPresetRules[ i ];
+		const uint32_t conditions = rule.conditions;
+
+		if( ( ( conditions & RULE_VENDOR ) && rule.vendorID != query.vendorID ) ||
+			( ( conditions & RULE_ARCHITECTURE ) && rule.architecture != query.architecture ) ||
+			( ( conditions & RULE_GENERATION ) && rule.generation != generation ) ||
+			( ( conditions & RULE_EU_COUNT ) && !InRange( rule.euCount, query.euCount ) ) ||
+			( ( conditions & RULE_MAX_FREQUENCY ) && !InRange( rule.maxFrequency, query.maxFrequency ) ) ||
+			( ( conditions & RULE_VIDEO_MEMORY ) && !InRange( rule.videoMemoryMB, query.videoMemoryMB ) ) ||
+			( ( conditions & RULE_DRIVER_VERSION ) && ( !query.driverVersionAvailability || !InRange( rule.driverVersion, query.driverVersion ) ) ) )
+		{
+			continue;
+		}
+
+		return rule.preset;
+	}
+
+	return Undefined;
+}
+
+PresetLevel GetCompiledPreset( unsigned int vendorID, unsigned int deviceID )
+{
+	if( vendorID > 0xFFFF || deviceID > 0xFFFF )
+	{
+		return Undefined;
+	}
+
+	const uint32_t key = ( vendorID << 16 ) | deviceID;
+	const uint32_t displacement = kPresetDisplacements[ Mix( key ) & ( kPresetBucketCount - 1 ) ];
+	const PresetTableEntry& entry = kPresetTable[ Mix( key ^ displacement ) & ( kPresetTableSize - 1 ) ];
+
+	return entry.key == key ? entry.preset : Undefined;
+}
+
+//
+// Read-only view of a whole file, memory-mapped so the tokenizer can work on
+// it in place.
+//
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile( const MappedFile& ) = delete;
+	MappedFile& operator=( const MappedFile& ) = delete;
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if( m_data != nullptr )
+		{
+			::UnmapViewOfFile( m_data );
+		}
+#else
+		if( m_data != nullptr )
+		{
+			::munmap( const_cast<char*>( m_data ), m_size );
+		}
+#endif
+	}
+
+	bool Open( const char* fileName )
+	{
+#ifdef _WIN32
+		const HANDLE file = ::CreateFileA( fileName, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr );
+		if( file == INVALID_HANDLE_VALUE )
+		{
+			return false;
+		}
+
+		LARGE_INTEGER size = {};
+		const bool sizeValid = ::GetFileSizeEx( file, &size ) != FALSE;
+		m_size = sizeValid ? (size_t) size.QuadPart : 0;
+
+		// An empty file cannot be mapped, but is still a valid file
+		if( sizeValid && m_size > 0 )
+		{
+			const HANDLE mapping = ::CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+			if( mapping != nullptr )
+			{
+				m_data = static_cast<const char*>( ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 ) );
+				::CloseHandle( mapping );
+			}
+		}
+
+		::CloseHandle( file );
+		return sizeValid && ( m_size == 0 || m_data != nullptr );
+#else
+		const int fd = ::open( fileName, O_RDONLY | O_CLOEXEC );
+		if( fd < 0 )
+		{
+			return false;
+		}
+
+		struct stat info = {};
+		const bool sizeValid = ::fstat( fd, &info ) == 0;
+		m_size = sizeValid ? (size_t) info.st_size : 0;
+
+		if( sizeValid && m_size > 0 )
+		{
+			void* data = ::mmap( nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+			m_data = data != MAP_FAILED ? static_cast<const char*>( data ) : nullptr;
+		}
+
+		::close( fd );
+		return sizeValid && ( m_size == 0 || m_data != nullptr );
+#endif
+	}
+
+	const char* Begin() const { return m_data; }
+	const char* End() const { return m_data + m_size; }
+
+private:
+	const char* m_data = nullptr;
+	size_t m_size = 0;
+};
+
+bool IsBlank( char c )
+{
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+const char* SkipBlanks( const char* p, const char* end )
+{
+	while( p < end && IsBlank( *p ) )
+	{
+		++p;
+	}
+	return p;
+}
+
+// Parses a hex number with an optional 0x prefix. Returns the position after
+// the number, or nullptr if there is none.
+const char* ParseHex( const char* p, const char* end, unsigned int* value )
+{
+	if( end - p >= 2 && p[ 0 ] == '0' && ( p[ 1 ] == 'x' || p[ 1 ] == 'X' ) )
+	{
+		p += 2;
+	}
+
+	unsigned int result = 0;
+	int digits = 0;
+	for( ; p < end; ++p, ++digits )
+	{
+		const char c = *p;
+		unsigned int digit = 0;
+		if( c >= '0' && c <= '9' )
+			digit = c - '0';
+		else if( c >= 'a' && c <= 'f' )
+			digit = c - 'a' + 10;
+		else if( c >= 'A' && c <= 'F' )
+			digit = c - 'A' + 10;
+		else
+			break;
+
+		result = ( result << 4 ) | digit;
+	}
+
+	if( digits == 0 || digits > 8 )
+	{
+		return nullptr;
+	}
+
+	*value = result;
+	return p;
+}
+
+bool TokenEquals( const char* token, size_t length, const char* name )
+{
+	for( size_t i = 0; i < length; ++i )
+	{
+		const char a = token[ i ] >= 'A' && token[ i ] <= 'Z' ? token[ i ] - 'A' + 'a' : token[ i ];
+		const char b = name[ i ] >= 'A' && name[ i ] <= 'Z' ? name[ i ] - 'A' + 'a' : name[ i ];
+		if( b == '\0' || a != b )
+		{
+			return false;
+		}
+	}
+	return name[ length ] == '\0';
+}
+
+PresetLevel ParsePresetName( const char* token, size_t length )
+{
+	if( TokenEquals( token, length, "Low" ) )
+		return Low;
+	if( TokenEquals( token, length, "Medium" ) )
+		return Medium;
+	if( TokenEquals( token, length, "Medium+" ) )
+		return MediumPlus;
+	if( TokenEquals( token, length, "High" ) )
+		return High;
+	return NotCompatible;
+}
+
+//
+// Tokenizes one line (without its newline) of the form
+//
+// VendorIDHex, DeviceIDHex, PresetName      ;Commented name of card
+//
+// Returns false for a malformed line. Blank and comment-only lines succeed
+// with *hasEntry set to false.
+//
+bool ParsePresetLine( const char* p, const char* end, bool* hasEntry, unsigned int* vendorID, unsigned int* deviceID, PresetLevel* preset )
+{
+	const char* comment = static_cast<const char*>( memchr( p, ';', end - p ) );
+	if( comment != nullptr )
+	{
+		end = comment;
+	}
+
+	p = SkipBlanks( p, end );
+	*hasEntry = p < end;
+	if( !*hasEntry )
+	{
+		return true;
+	}
+
+	// Rules are only compiled in, so an override file's rules are ignored
+	const char* keyword = p;
+	while( p < end && !IsBlank( *p ) && *p != ',' )
+	{
+		++p;
+	}
+	if( TokenEquals( keyword, p - keyword, "Rule" ) )
+	{
+		*hasEntry = false;
+		return true;
+	}
+	p = keyword;
+
+	p = ParseHex( p, end, vendorID );
+	if( p == nullptr || ( p = SkipBlanks( p, end ) ) == end || *p != ',' )
+	{
+		return false;
+	}
+
+	p = ParseHex( SkipBlanks( p + 1, end ), end, deviceID );
+	if( p == nullptr || ( p = SkipBlanks( p, end ) ) == end || *p != ',' )
+	{
+		return false;
+	}
+
+	const char* token = SkipBlanks( p + 1, end );
+	const char* tokenEnd = token;
+	while( tokenEnd < end && !IsBlank( *tokenEnd ) && *tokenEnd != ',' )
+	{
+		++tokenEnd;
+	}
+	if( tokenEnd == token )
+	{
+		return false;
+	}
+
+	*preset = ParsePresetName( token, tokenEnd - token );
+	return true;
+}
+
+//
+// Calls visitor( vendorID, deviceID, preset ) for every entry of the cfg file
+// until it returns false. The file is mapped and tokenized in place, so there
+// is no per-line copy or allocation and no limit on the line length.
+// Malformed lines are reported with their line number and skipped. Returns
+// false if the file could not be opened.
+//
+template< typename Visitor >
+bool ForEachPresetEntry( const char* cfgFileName, Visitor visitor )
+{
+	MappedFile file;
+	if( !file.Open( cfgFileName ) )
+	{
+		fprintf( stderr, "Error: %s not found! Fallback to compiled presets.\n", cfgFileName );
+		return false;
+	}
+
+	const char* const end = file.End();
+	unsigned int lineNumber = 0;
+	for( const char* line = file.Begin(); line < end; )
+	{
+		++lineNumber;
+
+		const char* lineEnd = static_cast<const char*>( memchr( line, '\n', end - line ) );
+		if( lineEnd == nullptr )
+		{
+			lineEnd = end;
+		}
+
+		bool hasEntry = false;
+		unsigned int vendorID = 0;
+		unsigned int deviceID = 0;
+		PresetLevel preset = Undefined;
+		if( !ParsePresetLine( line, lineEnd, &hasEntry, &vendorID, &deviceID, &preset ) )
+		{
+			fprintf( stderr, "Error: %s(%u): malformed preset entry, skipped.\n", cfgFileName, lineNumber );
+		}
+		else if( hasEntry && !visitor( vendorID, deviceID, preset ) )
+		{
+			break;
+		}
+
+		line = lineEnd < end ? lineEnd + 1 : end;
+	}
+
+	return true;
+}
+
+//
+// In-memory copies of override cfg files, one per file name. Each is filled
+// on the first call that passes its file and is read-only afterwards. They
+// are published on a list that only grows at its head, so lookups walk it
+// without a lock; the mutex is only taken to add a file that was not found.
+// A file that could not be opened is not cached, and is tried again on the
+// next call.
+//
+typedef std::unordered_map< uint32_t, PresetLevel > PresetMap;
+
+struct PresetFileIndex
+{
+	std::string cfgFileName;
+	PresetMap presets;
+	const PresetFileIndex* next;
+};
+
+bool LoadPresetMap( const char* cfgFileName, PresetMap* presets )
+{
+	return ForEachPresetEntry( cfgFileName, [ presets ]( unsigned int vendorID, unsigned int deviceID, PresetLevel preset )
+	{
+		// The first entry for a device wins, as in a linear scan of the file
+		if( vendorID <= 0xFFFF && deviceID <= 0xFFFF )
+		{
+			presets->emplace( ( vendorID << 16 ) | deviceID, preset );
+		}
+		return true;
+	} );
+}
+
+// A process passes one or two override files at most, so a list compared
+// with strcmp finds them without building a key string on every lookup.
+// The nodes live for the rest of the process, as readers may hold them.
+std::atomic< const PresetFileIndex* > g_presetFileIndex( nullptr );
+std::mutex g_presetFileIndexMutex;
+
+const PresetFileIndex* FindPresetFileIndex( const PresetFileIndex* index, const char* cfgFileName )
+{
+	for( ; index != nullptr; index = index->next )
+	{
+		if( index->cfgFileName == cfgFileName )
+		{
+			return index;
+		}
+	}
+	return nullptr;
+}
+
+// Returns the presets of cfgFileName, or nullptr if it could not be opened
+const PresetMap* GetPresetFileIndex( const char* cfgFileName )
+{
+	const PresetFileIndex* head = g_presetFileIndex.load( std::memory_order_acquire );
+	const PresetFileIndex* found = FindPresetFileIndex( head, cfgFileName );
+	if( found != nullptr )
+	{
+		return &found->presets;
+	}
+
+	// Parse before locking, so a slow file does not hold up lookups of others
+	std::unique_ptr< PresetFileIndex > index( new PresetFileIndex );
+	if( !LoadPresetMap( cfgFileName, &index->presets ) )
+	{
+		return nullptr;
+	}
+	index->cfgFileName = cfgFileName;
+
+	std::lock_guard< std::mutex > lock( g_presetFileIndexMutex );
+
+	// Another thread may have added the file while it was parsed; only the
+	// nodes added since head was read need to be searched
+	const PresetFileIndex* latest = g_presetFileIndex.load( std::memory_order_relaxed );
+	for( const PresetFileIndex* added = latest; added != head; added = added->next )
+	{
+		if( added->cfgFileName == cfgFileName )
+		{
+			return &added->presets;
+		}
+	}
+
+	index->next = latest;
+	g_presetFileIndex.store( index.get(), std::memory_order_release );
+	return &index.release()->presets;
+}
+
+PresetLevel FindPreset( const PresetMap& presets, unsigned int vendorID, unsigned int deviceID )
+{
+	if( vendorID > 0xFFFF || deviceID > 0xFFFF )
+	{
+		return Undefined;
+	}
+
+	const auto entry = presets.find( ( vendorID << 16 ) | deviceID );
+	return entry != presets.end() ? entry->second : Undefined;
+}
+
+PresetLevel GetFilePreset( const char* cfgFileName, unsigned int vendorID, unsigned int deviceID )
+{
+	const PresetMap* presets = GetPresetFileIndex( cfgFileName );
+	return presets != nullptr ? FindPreset( *presets, vendorID, deviceID ) : Undefined;
+}
+
+//
+// The presets for each vendor are compiled in from a config file with one
+// line per recognized graphics device in the following format:
+//
+// VendorIDHex, DeviceIDHex, CapabilityEnum      ;Commented name of card
+//
+bool HasPresets( unsigned int vendorID )
+{
+	switch( vendorID )
+	{
+	case INTEL_VENDOR_ID:
+		return true;
+
+		// Add other cases in this fashion to allow for additional vendors, and
+		// pass their cfg files to GeneratePresetTable.py as well
+		//case SOME_VENDOR_ID:
+		//    return true;
+
+	default:
+		return false;
+	}
+}
+
+// Falls back from the override file to the compiled table, then to the
+// rules, then to Low.
+PresetLevel ResolvePreset( const PresetQuery& query, PresetLevel overridePreset )
+{
+	PresetLevel presets = overridePreset;
+
+	if( presets == Undefined )
+	{
+		presets = GetCompiledPreset( query.vendorID, query.deviceID );
+	}
+
+	if( presets == Undefined )
+	{
+		presets = GetRulePreset( query );
+	}
+
+	//
+	// If the current graphics device was not listed in the compiled table or
+	// the override file, and no rule matched it, use Low settings as default.
+	// This should be changed to reflect the desired behavior for unknown
+	// graphics devices.
+	//
+	if( presets == Undefined )
+	{
+		presets = Low;
+	}
+
+	return presets;
+}
+
+//
+// Resolves count presets, splitting large batches across worker threads.
+// getDevice( i, &query ) returns false for records without adapter data,
+// which resolve to Undefined.
+//
+template< typename GetDevice >
+void ResolvePresets( size_t count, PresetLevel* const outPresets, const PresetMap* overrides, GetDevice getDevice )
+{
+	const auto resolveRange = [ = ]( size_t first, size_t last )
+	{
+		for( size_t i = first; i < last; ++i )
+		{
+			PresetQuery query = {};
+			if( !getDevice( i, &query ) || !HasPresets( query.vendorID ) )
+			{
+				outPresets[ i ] = Undefined;
+				continue;
+			}
+
+			const PresetLevel overridePreset = overrides != nullptr
+				? FindPreset( *overrides, query.vendorID, query.deviceID )
+				: Undefined;
+			outPresets[ i ] = ResolvePreset( query, overridePreset );
+		}
+	};
+
+	// Below this many records per thread, starting threads costs more than it saves
+	const size_t kMinRecordsPerThread = 16 * 1024;
+
+	const size_t threadCount = std::min< size_t >( std::max( std::thread::hardware_concurrency(), 1u ), count / kMinRecordsPerThread );
+	if( threadCount <= 1 )
+	{
+		resolveRange( 0, count );
+		return;
+	}
+
+	const size_t chunkSize = ( count + threadCount - 1 ) / threadCount;
+
+	std::vector< std::thread > workers;
+	workers.reserve( threadCount - 1 );
+	for( size_t first = chunkSize; first < count; first += chunkSize )
+	{
+		workers.emplace_back( resolveRange, first, std::min( first + chunkSize, count ) );
+	}
+
+	resolveRange( 0, chunkSize );
+
+	for( std::thread& worker : workers )
+	{
+		worker.join();
+	}
+}
+
+//
+// Looks the override index up once for a whole batch
+//
+const PresetMap* GetBatchOverrides( const char* overrideCfgFileName )
+{
+	return overrideCfgFileName != nullptr ? GetPresetFileIndex( overrideCfgFileName ) : nullptr;
+}
+
+}
+
+int ScanPresetFile( const char* cfgFileName, bool buildIndex, size_t* entryCount )
+{
+	if( cfgFileName == nullptr || entryCount == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	bool opened = false;
+	if( buildIndex )
+	{
+		PresetMap presets;
+		opened = LoadPresetMap( cfgFileName, &presets );
+		*entryCount = presets.size();
+	}
+	else
+	{
+		size_t count = 0;
+		opened = ForEachPresetEntry( cfgFileName, [ &count ]( unsigned int, unsigned int, PresetLevel )
+		{
+			++count;
+			return true;
+		} );
+		*entryCount = count;
+	}
+
+	return opened ? EXIT_SUCCESS : GPUDETECT_ERROR_GENERIC;
+}
+
+PresetLevel GetDefaultFidelityPreset( const GPUData* const gpuData )
+{
+	return GetDefaultFidelityPreset( gpuData, nullptr );
+}
+
+PresetLevel GetDefaultFidelityPreset( const GPUData* const gpuData, const char* overrideCfgFileName )
+{
+	// Return if prerequisite info is not met
+	if( !gpuData->dxAdapterAvailability || !HasPresets( gpuData->vendorID ) )
+	{
+		return PresetLevel::Undefined;
+	}
+
+	//
+	// Entries in an override file take precedence over the compiled table,
+	// so presets can be patched in the field without a rebuild.
+	//
+	const PresetLevel overridePreset = overrideCfgFileName != nullptr
+		? GetFilePreset( overrideCfgFileName, gpuData->vendorID, gpuData->deviceID )
+		: Undefined;
+
+	return ResolvePreset( MakePresetQuery( *gpuData ), overridePreset );
+}
+
+int GetDefaultFidelityPresets( const GPUData* const gpuData, size_t count, PresetLevel* const outPresets, const char* overrideCfgFileName )
+{
+	if( ( gpuData == nullptr || outPresets == nullptr ) && count > 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	const PresetMap* overrides = GetBatchOverrides( overrideCfgFileName );
+
+	ResolvePresets( count, outPresets, overrides, [ gpuData ]( size_t i, PresetQuery* query )
+	{
+		*query = MakePresetQuery( gpuData[ i ] );
+		return gpuData[ i ].dxAdapterAvailability;
+	} );
+
+	return EXIT_SUCCESS;
+}
+
+int GetDefaultFidelityPresets( const DeviceKey* const devices, size_t count, PresetLevel* const outPresets, const char* overrideCfgFileName )
+{
+	if( ( devices == nullptr || outPresets == nullptr ) && count > 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	const PresetMap* overrides = GetBatchOverrides( overrideCfgFileName );
+
+	ResolvePresets( count, outPresets, overrides, [ devices ]( size_t i, PresetQuery* query )
+	{
+		*query = MakePresetQuery( devices[ i ].vendorID, devices[ i ].deviceID );
+		return true;
+	} );
+
+	return EXIT_SUCCESS;
+}
+
+}
@@ -15,6 +15,8 @@
 ////////////////////////////////////////////////////////////////////////////////
 
 
+#ifdef _WIN32
+
 #ifndef STRICT
 #define STRICT
 #endif
@@ -44,510 +46,1767 @@
 #include <winreg.h>
 #include <tchar.h>
 
+#endif // _WIN32
+
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
 
-#include "GPUDetect.h"
+#include "GPUDetectBackend.h"
 
 
 // These should only be needed for reading data from the counter
 struct IntelDeviceInfo1
 {
-	DWORD GPUMaxFreq;
-	DWORD GPUMinFreq;
+	uint32_t GPUMaxFreq;
+	uint32_t GPUMinFreq;
 };
 static_assert( sizeof(IntelDeviceInfo1) == 8, "struct size mismatch" );
 
 struct IntelDeviceInfo2 : public IntelDeviceInfo1
 {
-	DWORD GPUArchitecture;   // should match INTEL_GPU_ARCHITECTURE
-	DWORD EUCount;
-	DWORD PackageTDP;
-	DWORD MaxFillRate;
+	uint32_t GPUArchitecture;   // should match INTEL_GPU_ARCHITECTURE
+	uint32_t EUCount;
+	uint32_t PackageTDP;
+	uint32_t MaxFillRate;
 };
 static_assert( sizeof(IntelDeviceInfo2) == 24, "struct size mismatch" );
 
+// ID3D10::EXTENSION_INTERFACE_VERSION_1_0, which is also needed where
+// ID3D10Extensions.h is not available
+const unsigned int kExtensionInterfaceVersion1_0 = 0x00010000;
+#ifdef _WIN32
+static_assert( kExtensionInterfaceVersion1_0 == ID3D10::EXTENSION_INTERFACE_VERSION_1_0, "extension version mismatch" );
+#endif
 
 namespace GPUDetect
 {
 
-// Returns EXIT_SUCCESS if successfully initialized
-int GetIntelDeviceInfo( IntelDeviceInfo2* deviceInfo, ID3D11Device* device );
+#ifdef _WIN32
 
+// Queries the device-level fields used by InitExtensionInfo
+void GetDxgiDeviceCaps( IDXGIAdapter* adapter, ID3D11Device* device, bool queryIntelExtension, DeviceCaps* caps );
 
-int InitAll( GPUData* const gpuData, int adapterIndex )
+// Loads dxgi.dll and creates a factory. On success the caller owns both.
+int LoadDxgiFactory( HMODULE* dxgiModule, IDXGIFactory** factory );
+
+int GetDxgiAdapterDesc( IDXGIAdapter* adapter, AdapterDesc* desc );
+
+namespace
 {
-	if( gpuData == nullptr || adapterIndex < 0 )
+
+//
+// Adapter source that loads DXGI and creates the factory once, and keeps the
+// enumerated adapters until it is destroyed.
+//
+class DxgiAdapterSource : public IAdapterSource
+{
+public:
+	DxgiAdapterSource() = default;
+	DxgiAdapterSource( const DxgiAdapterSource& ) = delete;
+	DxgiAdapterSource& operator=( const DxgiAdapterSource& ) = delete;
+
+	~DxgiAdapterSource()
 	{
-		return GPUDETECT_ERROR_BAD_DATA;
+		Release();
+	}
+
+	void Release()
+	{
+		for( IDXGIAdapter* adapter : m_adapters )
+		{
+			adapter->Release();
+		}
+		m_adapters.clear();
+
+		if( m_factory != nullptr )
+		{
+			m_factory->Release();
+			m_factory = nullptr;
+		}
+
+		if( m_dxgiModule != nullptr )
+		{
+			::FreeLibrary( m_dxgiModule );
+			m_dxgiModule = nullptr;
+		}
+	}
+
+	bool IsInitialized() const
+	{
+		return m_factory != nullptr;
+	}
+
+	int Init()
+	{
+		const int returnCode = LoadDxgiFactory( &m_dxgiModule, &m_factory );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		StageTimer timer( Timings::STAGE_ENUM_ADAPTERS );
+
+		IDXGIAdapter* adapter = nullptr;
+		while( SUCCEEDED( m_factory->EnumAdapters( (UINT) m_adapters.size(), &adapter ) ) )
+		{
+			m_adapters.push_back( adapter );
+		}
+
+		return EXIT_SUCCESS;
+	}
+
+	int GetAdapterCount() override
+	{
+		return (int) m_adapters.size();
+	}
+
+	int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) override
+	{
+		if( adapterIndex < 0 || adapterIndex >= GetAdapterCount() )
+		{
+			return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+		}
+
+		return GetDxgiAdapterDesc( m_adapters[ adapterIndex ], desc );
+	}
+
+	IDXGIAdapter* GetAdapter( int adapterIndex ) const
+	{
+		return m_adapters[ adapterIndex ];
+	}
+
+private:
+	HMODULE m_dxgiModule = nullptr;
+	IDXGIFactory* m_factory = nullptr;
+	std::vector< IDXGIAdapter* > m_adapters;
+};
+
+class D3D11CounterSource : public ICounterSource
+{
+public:
+	explicit D3D11CounterSource( ID3D11Device* device )
+		: m_device( device )
+	{
+	}
+
+	int GetCounterCount() override
+	{
+		D3D11_COUNTER_INFO counterInfo = {};
+		m_device->CheckCounterInfo( &counterInfo );
+		if( counterInfo.LastDeviceDependentCounter < D3D11_COUNTER_DEVICE_DEPENDENT_0 )
+		{
+			return 0;
+		}
+		return counterInfo.LastDeviceDependentCounter - D3D11_COUNTER_DEVICE_DEPENDENT_0 + 1;
+	}
+
+	bool CheckCounter( int counterIndex, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength ) override
+	{
+		D3D11_COUNTER_DESC counterDesc = {};
+		counterDesc.Counter = static_cast<D3D11_COUNTER>( D3D11_COUNTER_DEVICE_DEPENDENT_0 + counterIndex );
+
+		D3D11_COUNTER_TYPE counterType = {};
+		UINT slotsRequired = 0;
+		UINT unitsLength = 0;
+		return SUCCEEDED( m_device->CheckCounter( &counterDesc, &counterType, &slotsRequired, name, nameLength, nullptr, &unitsLength, description, descriptionLength ) );
+	}
+
+	int GetCounterData( int counterIndex, void* data, unsigned int dataSize ) override
+	{
+		D3D11_COUNTER_DESC counterDesc = {};
+		counterDesc.Counter = static_cast<D3D11_COUNTER>( D3D11_COUNTER_DEVICE_DEPENDENT_0 + counterIndex );
+
+		//
+		// Create the information counter, and query it to get the data. GetData()
+		// returns a pointer to the data, not the actual data.
+		//
+		ID3D11Counter* counter = nullptr;
+		if( FAILED( m_device->CreateCounter( &counterDesc, &counter ) ) )
+		{
+			return GPUDETECT_ERROR_DXGI_COUNTER_CREATION;
+		}
+
+		ID3D11DeviceContext* deviceContext = nullptr;
+		m_device->GetImmediateContext( &deviceContext );
+
+		deviceContext->Begin( counter );
+		deviceContext->End( counter );
+
+		uintptr_t dataAddress = 0;
+		const bool gotData = deviceContext->GetData( counter, reinterpret_cast<void*>(&dataAddress), sizeof( dataAddress ), 0 ) == S_OK;
+		if( gotData )
+		{
+			memcpy( data, reinterpret_cast<const void*>( dataAddress ), dataSize );
+		}
+
+		counter->Release();
+		deviceContext->Release();
+		return gotData ? EXIT_SUCCESS : GPUDETECT_ERROR_DXGI_COUNTER_GET_DATA;
+	}
+
+private:
+	ID3D11Device* m_device;
+};
+
+// Reads the user-mode driver version of device, for the counter cache. It is
+// left unchanged if it cannot be queried.
+void GetDeviceDriverVersion( ID3D11Device* device, uint64_t* driverVersion )
+{
+	IDXGIDevice* dxgiDevice = nullptr;
+	if( FAILED( device->QueryInterface( __uuidof( IDXGIDevice ), (void**) &dxgiDevice ) ) )
+	{
+		return;
 	}
 
 	IDXGIAdapter* adapter = nullptr;
-	int returnCode = InitAdapter( &adapter, adapterIndex );
+	if( SUCCEEDED( dxgiDevice->GetAdapter( &adapter ) ) )
+	{
+		LARGE_INTEGER umdVersion = {};
+		if( SUCCEEDED( adapter->CheckInterfaceSupport( __uuidof( IDXGIDevice ), &umdVersion ) ) )
+		{
+			*driverVersion = (uint64_t) umdVersion.QuadPart;
+		}
+		adapter->Release();
+	}
+
+	dxgiDevice->Release();
+}
+
+}
+
+struct Context::Impl
+{
+	DxgiAdapterSource adapterSource;
+	std::vector< ID3D11Device* > devices;  // indexed like the adapters, created on demand
+};
+
+Context::Context()
+	: m_impl( new Impl )
+{
+}
+
+Context::~Context()
+{
+	Reset();
+	delete m_impl;
+}
+
+void Context::Reset()
+{
+	for( ID3D11Device* device : m_impl->devices )
+	{
+		if( device != nullptr )
+		{
+			device->Release();
+		}
+	}
+	m_impl->devices.clear();
+
+	m_impl->adapterSource.Release();
+}
+
+int Context::GetAdapterCount( int* count )
+{
+	if( count == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	if( !m_impl->adapterSource.IsInitialized() )
+	{
+		const int returnCode = m_impl->adapterSource.Init();
+		if( returnCode != EXIT_SUCCESS )
+		{
+			m_impl->adapterSource.Release();
+			return returnCode;
+		}
+
+		m_impl->devices.assign( m_impl->adapterSource.GetAdapterCount(), nullptr );
+	}
+
+	*count = m_impl->adapterSource.GetAdapterCount();
+	return EXIT_SUCCESS;
+}
+
+int Context::GetAdapter( int adapterIndex, IDXGIAdapter** adapter )
+{
+	if( adapter == nullptr || adapterIndex < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	int adapterCount = 0;
+	const int returnCode = GetAdapterCount( &adapterCount );
 	if( returnCode != EXIT_SUCCESS )
 	{
 		return returnCode;
 	}
 
-	ID3D11Device* device = nullptr;
-	returnCode = InitDevice( adapter, &device );
+	if( adapterIndex >= adapterCount )
+	{
+		return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+	}
+
+	*adapter = m_impl->adapterSource.GetAdapter( adapterIndex );
+	return EXIT_SUCCESS;
+}
+
+int Context::GetDevice( int adapterIndex, ID3D11Device** device )
+{
+	if( device == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	IDXGIAdapter* adapter = nullptr;
+	const int returnCode = GetAdapter( adapterIndex, &adapter );
 	if( returnCode != EXIT_SUCCESS )
 	{
-		adapter->Release();
 		return returnCode;
 	}
 
-	returnCode = InitAll( gpuData, adapter, device );
+	ID3D11Device*& cachedDevice = m_impl->devices[ adapterIndex ];
+	if( cachedDevice == nullptr )
+	{
+		const int deviceReturnCode = InitDevice( adapter, &cachedDevice );
+		if( deviceReturnCode != EXIT_SUCCESS )
+		{
+			cachedDevice = nullptr;
+			return deviceReturnCode;
+		}
+	}
 
-	adapter->Release();
-	device->Release();
-	return returnCode;
+	*device = cachedDevice;
+	return EXIT_SUCCESS;
 }
 
-int InitAll( GPUData* const gpuData, IDXGIAdapter* adapter, ID3D11Device* device )
+int EnumerateAdapters( Context* context, std::vector< GPUData >* gpuData )
 {
-	int returnCode = InitExtensionInfo( gpuData, adapter, device );
+	if( context == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	int adapterCount = 0;
+	const int returnCode = context->GetAdapterCount( &adapterCount );
 	if( returnCode != EXIT_SUCCESS )
 	{
 		return returnCode;
 	}
 
-	returnCode = InitDxDriverVersion( gpuData );
-	if( returnCode != EXIT_SUCCESS )
+	return EnumerateAdapters( &context->m_impl->adapterSource, gpuData );
+}
+
+int EnumerateAdapters( std::vector< GPUData >* gpuData )
+{
+	Context context;
+	return EnumerateAdapters( &context, gpuData );
+}
+
+namespace
+{
+
+//
+// Detector that shares the adapters of one context between threads, and
+// gives each adapter its own short-lived device. DXGI adapters are
+// free-threaded, and the context is fully enumerated before any thread starts.
+//
+class DxgiAdapterDetector : public IAdapterDetector
+{
+public:
+	int GetAdapterCount( int* count ) override
+	{
+		return m_context.GetAdapterCount( count );
+	}
+
+	int InitAll( GPUData* const gpuData, int adapterIndex ) override
 	{
+		IDXGIAdapter* adapter = nullptr;
+		int returnCode = m_context.GetAdapter( adapterIndex, &adapter );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		ID3D11Device* device = nullptr;
+		returnCode = InitDevice( adapter, &device );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		returnCode = GPUDetect::InitAll( gpuData, adapter, device );
+
+		device->Release();
 		return returnCode;
 	}
 
-	returnCode = InitCounterInfo( gpuData, device );
+private:
+	Context m_context;
+};
 
-	return returnCode;
 }
 
-int InitExtensionInfo( GPUData* const gpuData, int adapterIndex )
+int InitAllAdapters( std::vector< GPUData >* gpuData, std::vector< int >* returnCodes, unsigned int maxThreads )
+{
+	DxgiAdapterDetector detector;
+	return InitAllAdapters( &detector, gpuData, returnCodes, maxThreads );
+}
+
+int InitAll( GPUData* const gpuData, int adapterIndex )
 {
 	if( gpuData == nullptr || adapterIndex < 0 )
 	{
 		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	IDXGIAdapter* adapter = nullptr;
-	int returnCode = InitAdapter( &adapter, adapterIndex );
-	if( returnCode != EXIT_SUCCESS )
+	Context context;
+	return InitAll( gpuData, &context, adapterIndex );
+}
+
+int InitAll( GPUData* const gpuData, Context* context, int adapterIndex )
+{
+	if( gpuData == nullptr || context == nullptr || adapterIndex < 0 )
 	{
-		return returnCode;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	ID3D11Device* device = nullptr;
-	returnCode = InitDevice( adapter, &device );
+	// The adapter source can only report a failed DXGI load as no adapters
+	int adapterCount = 0;
+	const int returnCode = context->GetAdapterCount( &adapterCount );
 	if( returnCode != EXIT_SUCCESS )
 	{
-		adapter->Release();
 		return returnCode;
 	}
 
-	returnCode = InitExtensionInfo( gpuData, adapter, device );
+	DxgiBackend backend( context );
+	return InitAll( gpuData, backend.GetSources(), adapterIndex );
+}
+
+int InitAll( GPUData* const gpuData, Context* context, int adapterIndex, Timings* const timings )
+{
+	if( timings == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*timings = {};
+	timings->adapterIndex = adapterIndex;
 
-	adapter->Release();
-	device->Release();
-	return returnCode;
+	TimingsScope scope( timings );
+	StageTimer timer( Timings::STAGE_INIT_ALL );
+	return InitAll( gpuData, context, adapterIndex );
 }
 
-int InitExtensionInfo( GPUData* const gpuData, IDXGIAdapter* adapter, ID3D11Device* device )
+int InitAdapterInfo( GPUData* const gpuData, int adapterIndex )
 {
-	if ( gpuData == nullptr || adapter == nullptr || device == nullptr )
+	if( gpuData == nullptr || adapterIndex < 0 )
 	{
 		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	// basic DXGI information
-	DXGI_ADAPTER_DESC AdapterDesc = {};
-	if( FAILED( adapter->GetDesc( &AdapterDesc ) ) )
+	Context context;
+	return InitAdapterInfo( gpuData, &context, adapterIndex );
+}
+
+int InitAdapterInfo( GPUData* const gpuData, Context* context, int adapterIndex )
+{
+	if( gpuData == nullptr || context == nullptr || adapterIndex < 0 )
 	{
-		return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	gpuData->dxAdapterAvailability = true;
+	IDXGIAdapter* adapter = nullptr;
+	const int returnCode = context->GetAdapter( adapterIndex, &adapter );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	return InitAdapterInfo( gpuData, adapter );
+}
+
+int InitAdapterInfo( GPUData* const gpuData, IDXGIAdapter* adapter )
+{
+	if( gpuData == nullptr || adapter == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
 
-	gpuData->vendorID = AdapterDesc.VendorId;
-	gpuData->deviceID = AdapterDesc.DeviceId;
-	gpuData->adapterLUID = AdapterDesc.AdapterLuid;
+	AdapterDesc desc = {};
+	const int returnCode = GetDxgiAdapterDesc( adapter, &desc );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
 
-	wcscpy_s( gpuData->description, _countof( GPUData::description ), AdapterDesc.Description );
+	FillAdapterData( desc, gpuData );
+	return EXIT_SUCCESS;
+}
 
-	if( AdapterDesc.VendorId == INTEL_VENDOR_ID && AdapterDesc.DedicatedVideoMemory <= 512 * 1024 * 1024 )
+int InitExtensionInfo( GPUData* const gpuData, int adapterIndex )
+{
+	if( gpuData == nullptr || adapterIndex < 0 )
 	{
-		gpuData->isUMAArchitecture = true;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-#ifdef _WIN32_WINNT_WIN10
-	ID3D11Device3* pDevice3 = nullptr;
-	if( SUCCEEDED( device->QueryInterface( __uuidof( ID3D11Device3 ), (void**) &pDevice3 ) ) )
+	Context context;
+	return InitExtensionInfo( gpuData, &context, adapterIndex );
+}
+
+int InitExtensionInfo( GPUData* const gpuData, Context* context, int adapterIndex )
+{
+	if( gpuData == nullptr || context == nullptr || adapterIndex < 0 )
 	{
-		D3D11_FEATURE_DATA_D3D11_OPTIONS2 FeatureData = {};
-		if( SUCCEEDED( pDevice3->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS2, &FeatureData, sizeof( FeatureData ) ) ) )
-		{
-			gpuData->isUMAArchitecture = FeatureData.UnifiedMemoryArchitecture == TRUE;
-		}
-		pDevice3->Release();
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
-#endif // _WIN32_WINNT_WIN10
 
-	if( gpuData->isUMAArchitecture )
+	IDXGIAdapter* adapter = nullptr;
+	int returnCode = context->GetAdapter( adapterIndex, &adapter );
+	if( returnCode != EXIT_SUCCESS )
 	{
-		gpuData->videoMemory = AdapterDesc.SharedSystemMemory;
+		return returnCode;
 	}
-	else
+
+	ID3D11Device* device = nullptr;
+	returnCode = context->GetDevice( adapterIndex, &device );
+	if( returnCode != EXIT_SUCCESS )
 	{
-		gpuData->videoMemory = AdapterDesc.DedicatedVideoMemory;
+		return returnCode;
 	}
 
-	// Intel specific information
-	if( AdapterDesc.VendorId == INTEL_VENDOR_ID )
-	{
-		gpuData->architecture = GetIntelGPUArchitecture(gpuData->deviceID);
+	return InitExtensionInfo( gpuData, adapter, device );
+}
+
+int InitExtensionInfo( GPUData* const gpuData, IDXGIAdapter* adapter, ID3D11Device* device )
+{
+	if ( gpuData == nullptr || adapter == nullptr || device == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	// basic DXGI information
+	AdapterDesc desc = {};
+	const int returnCode = GetDxgiAdapterDesc( adapter, &desc );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	FillAdapterData( desc, gpuData );
+
+	DeviceCaps caps = {};
+	GetDxgiDeviceCaps( adapter, device, gpuData->vendorID == INTEL_VENDOR_ID, &caps );
+	ApplyDeviceCaps( desc, caps, gpuData );
+
+	return EXIT_SUCCESS;
+}
+
+int InitCounterInfo( GPUData* const gpuData, int adapterIndex )
+{
+	if( gpuData == nullptr || adapterIndex < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	Context context;
+	return InitCounterInfo( gpuData, &context, adapterIndex );
+}
+
+int InitCounterInfo( GPUData* const gpuData, Context* context, int adapterIndex )
+{
+	if( gpuData == nullptr || context == nullptr || adapterIndex < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	ID3D11Device* device = nullptr;
+	const int returnCode = context->GetDevice( adapterIndex, &device );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	return InitCounterInfo( gpuData, device );
+}
+
+int InitCounterInfo( GPUData* const gpuData, ID3D11Device* device )
+{
+	if( gpuData == nullptr || device == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	D3D11CounterSource counterSource( device );
+
+	uint64_t driverVersion = 0;
+	GetDeviceDriverVersion( device, &driverVersion );
+
+	return InitCounterInfo( gpuData, &counterSource, driverVersion );
+}
+
+namespace
+{
+
+// Registry source over HKLM\SOFTWARE\Microsoft\DirectX. The name of the
+// last enumerated subkey is kept, since each subkey is read twice in a row.
+class DirectXRegistrySource : public IRegistrySource
+{
+public:
+	DirectXRegistrySource() = default;
+	DirectXRegistrySource( const DirectXRegistrySource& ) = delete;
+	DirectXRegistrySource& operator=( const DirectXRegistrySource& ) = delete;
+
+	~DirectXRegistrySource()
+	{
+		if( m_dxKeyHandle != nullptr )
+		{
+			const LSTATUS returnCode = ::RegCloseKey( m_dxKeyHandle );
+			assert( returnCode == ERROR_SUCCESS );
+			(void) returnCode;
+		}
+	}
+
+	int GetSubKeyCount( int* count ) override
+	{
+		if( m_dxKeyHandle == nullptr && ::RegOpenKeyExA( HKEY_LOCAL_MACHINE, "SOFTWARE\\Microsoft\\DirectX", 0, KEY_READ, &m_dxKeyHandle ) != ERROR_SUCCESS )
+		{
+			m_dxKeyHandle = nullptr;
+			return GPUDETECT_ERROR_REG_NO_D3D_KEY;
+		}
+
+		DWORD numOfAdapters = 0;
+		if( ::RegQueryInfoKeyA( m_dxKeyHandle, nullptr, nullptr, nullptr, &numOfAdapters, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr ) != ERROR_SUCCESS )
+		{
+			return GPUDETECT_ERROR_REG_GENERAL_FAILURE;
+		}
+
+		*count = (int) numOfAdapters;
+		return EXIT_SUCCESS;
+	}
+
+	bool GetQwordValue( int subKeyIndex, const char* valueName, uint64_t* value ) override
+	{
+		if( subKeyIndex != m_subKeyIndex )
+		{
+			DWORD subKeyLength = _countof( m_subKeyName );
+			if( ::RegEnumKeyExA( m_dxKeyHandle, subKeyIndex, m_subKeyName, &subKeyLength, nullptr, nullptr, nullptr, nullptr ) != ERROR_SUCCESS )
+			{
+				m_subKeyIndex = -1;
+				return false;
+			}
+			m_subKeyIndex = subKeyIndex;
+		}
+
+		DWORD qwordSize = sizeof( uint64_t );
+		return ::RegGetValueA( m_dxKeyHandle, m_subKeyName, valueName, RRF_RT_QWORD, nullptr, value, &qwordSize ) == ERROR_SUCCESS;
+	}
+
+private:
+	HKEY m_dxKeyHandle = nullptr;
+	char m_subKeyName[ 256 ];  // registry key names are at most 255 characters
+	int m_subKeyIndex = -1;
+};
+
+// The registry is scanned once per process, see DriverVersionCache
+DriverVersionCache& GetProcessDriverVersionCache()
+{
+	static DriverVersionCache cache;
+	return cache;
+}
+
+}
+
+int InitDxDriverVersion( GPUData* const gpuData )
+{
+	if( gpuData == nullptr || !( gpuData->dxAdapterAvailability == true ) )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	DirectXRegistrySource source;
+	return GetProcessDriverVersionCache().InitDxDriverVersion( gpuData, &source );
+}
+
+namespace
+{
+
+// Adapter source over the adapters of a context
+class ContextAdapterSource : public IAdapterSource
+{
+public:
+	explicit ContextAdapterSource( Context* context )
+		: m_context( context )
+	{
+	}
+
+	int GetAdapterCount() override
+	{
+		int count = 0;
+		m_context->GetAdapterCount( &count );
+		return count;
+	}
+
+	int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) override
+	{
+		IDXGIAdapter* adapter = nullptr;
+		const int returnCode = m_context->GetAdapter( adapterIndex, &adapter );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		return GetDxgiAdapterDesc( adapter, desc );
+	}
+
+private:
+	Context* m_context;
+};
+
+// Device source over the devices of a context. Counter sources are created
+// on demand and kept, so the pointers handed out stay valid.
+class ContextDeviceSource : public IDeviceSource
+{
+public:
+	explicit ContextDeviceSource( Context* context )
+		: m_context( context )
+	{
+	}
+
+	int GetDeviceCaps( int adapterIndex, bool queryIntelExtension, DeviceCaps* caps ) override
+	{
+		IDXGIAdapter* adapter = nullptr;
+		int returnCode = m_context->GetAdapter( adapterIndex, &adapter );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		ID3D11Device* device = nullptr;
+		returnCode = m_context->GetDevice( adapterIndex, &device );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		GetDxgiDeviceCaps( adapter, device, queryIntelExtension, caps );
+		return EXIT_SUCCESS;
+	}
+
+	int GetCounterSource( int adapterIndex, ICounterSource** counters ) override
+	{
+		ID3D11Device* device = nullptr;
+		const int returnCode = m_context->GetDevice( adapterIndex, &device );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		if( (size_t) adapterIndex >= m_counterSources.size() )
+		{
+			m_counterSources.resize( adapterIndex + 1 );
+		}
+		if( !m_counterSources[ adapterIndex ] )
+		{
+			m_counterSources[ adapterIndex ].reset( new D3D11CounterSource( device ) );
+		}
+
+		*counters = m_counterSources[ adapterIndex ].get();
+		return EXIT_SUCCESS;
+	}
+
+private:
+	Context* m_context;
+	std::vector< std::unique_ptr< D3D11CounterSource > > m_counterSources;
+};
+
+}
+
+struct DxgiBackend::Impl
+{
+	explicit Impl( Context* context )
+		: adapters( context )
+		, devices( context )
+	{
+	}
+
+	ContextAdapterSource adapters;
+	ContextDeviceSource devices;
+	DirectXRegistrySource registry;
+};
+
+DxgiBackend::DxgiBackend( Context* context )
+	: m_impl( new Impl( context ) )
+{
+}
+
+DxgiBackend::~DxgiBackend()
+{
+	delete m_impl;
+}
+
+BackendSources DxgiBackend::GetSources()
+{
+	BackendSources sources = {};
+	sources.adapters = &m_impl->adapters;
+	sources.devices = &m_impl->devices;
+	sources.registry = &m_impl->registry;
+	sources.driverVersions = &GetProcessDriverVersionCache();
+	return sources;
+}
+
+namespace
+{
+
+// Adapter and device sources over one adapter and its device, which the
+// caller owns, as adapter 0
+class SingleAdapterSource : public IAdapterSource, public IDeviceSource
+{
+public:
+	SingleAdapterSource( IDXGIAdapter* adapter, ID3D11Device* device )
+		: m_adapter( adapter )
+		, m_device( device )
+		, m_counterSource( device )
+	{
+	}
+
+	int GetAdapterCount() override
+	{
+		return 1;
+	}
+
+	int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) override
+	{
+		return adapterIndex == 0 ? GetDxgiAdapterDesc( m_adapter, desc ) : GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+	}
+
+	int GetDeviceCaps( int adapterIndex, bool queryIntelExtension, DeviceCaps* caps ) override
+	{
+		if( adapterIndex != 0 )
+		{
+			return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+		}
+
+		GetDxgiDeviceCaps( m_adapter, m_device, queryIntelExtension, caps );
+		return EXIT_SUCCESS;
+	}
+
+	int GetCounterSource( int adapterIndex, ICounterSource** counters ) override
+	{
+		if( adapterIndex != 0 )
+		{
+			return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+		}
+
+		*counters = &m_counterSource;
+		return EXIT_SUCCESS;
+	}
+
+private:
+	IDXGIAdapter* m_adapter;
+	ID3D11Device* m_device;
+	D3D11CounterSource m_counterSource;
+};
+
+}
+
+int InitAll( GPUData* const gpuData, IDXGIAdapter* adapter, ID3D11Device* device )
+{
+	if( gpuData == nullptr || adapter == nullptr || device == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	SingleAdapterSource adapterSource( adapter, device );
+	DirectXRegistrySource registry;
+
+	BackendSources sources = {};
+	sources.adapters = &adapterSource;
+	sources.devices = &adapterSource;
+	sources.registry = &registry;
+	sources.driverVersions = &GetProcessDriverVersionCache();
+	return InitAll( gpuData, sources, 0 );
+}
+
+#endif // _WIN32
+
+thread_local Timings* g_currentTimings = nullptr;
+
+const char* GetTimingsStageName( Timings::Stage stage )
+{
+	switch( stage )
+	{
+		case Timings::STAGE_INIT_ALL:       return "InitAll";
+		case Timings::STAGE_LOAD_LIBRARY:   return "LoadLibrary";
+		case Timings::STAGE_CREATE_FACTORY: return "CreateDXGIFactory";
+		case Timings::STAGE_ENUM_ADAPTERS:  return "EnumAdapters";
+		case Timings::STAGE_CREATE_DEVICE:  return "D3D11CreateDevice";
+		case Timings::STAGE_EXTENSION_CAPS: return "GetExtensionCaps";
+		case Timings::STAGE_COUNTER_SCAN:   return "CounterScan";
+		case Timings::STAGE_COUNTER_DATA:   return "CounterData";
+		case Timings::STAGE_REGISTRY_WALK:  return "RegistryWalk";
+		case Timings::STAGE_SYSFS_READ:     return "SysfsRead";
+
+		case Timings::STAGE_COUNT:
+		default:                            return "Unknown";
+	}
+}
+
+int InitAll( GPUData* const gpuData, int adapterIndex, Timings* const timings )
+{
+	if( timings == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*timings = {};
+	timings->adapterIndex = adapterIndex;
+
+	TimingsScope scope( timings );
+	StageTimer timer( Timings::STAGE_INIT_ALL );
+	return InitAll( gpuData, adapterIndex );
+}
+
+int WriteChromeTrace( const Timings* const timings, size_t count, const char* fileName )
+{
+	if( ( timings == nullptr && count != 0 ) || fileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	// Trace times are in microseconds, relative to the earliest stage
+	int64_t originNs = INT64_MAX;
+	for( size_t i = 0; i < count; ++i )
+	{
+		for( const Timings::Interval& interval : timings[ i ].stages )
+		{
+			if( interval.endNs != 0 )
+			{
+				originNs = std::min( originNs, interval.startNs );
+			}
+		}
+	}
+
+	FILE* file = fopen( fileName, "w" );
+	if( file == nullptr )
+	{
+		return GPUDETECT_ERROR_TRACE_WRITE;
+	}
+
+	fprintf( file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" );
+
+	const char* separator = "\n";
+	for( size_t i = 0; i < count; ++i )
+	{
+		fprintf( file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"Adapter %d\"}}",
+			separator, i, timings[ i ].adapterIndex );
+		separator = ",\n";
+
+		for( int stage = 0; stage < Timings::STAGE_COUNT; ++stage )
+		{
+			const Timings::Interval& interval = timings[ i ].stages[ stage ];
+			if( interval.endNs == 0 )
+			{
+				continue;
+			}
+
+			fprintf( file, "%s{\"name\":\"%s\",\"cat\":\"GPUDetect\",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}",
+				separator, GetTimingsStageName( (Timings::Stage) stage ), i,
+				( interval.startNs - originNs ) / 1000.0, ( interval.endNs - interval.startNs ) / 1000.0 );
+		}
+	}
+
+	fprintf( file, "\n]}\n" );
+
+	const bool written = ferror( file ) == 0;
+	return fclose( file ) == 0 && written ? EXIT_SUCCESS : GPUDETECT_ERROR_TRACE_WRITE;
+}
+
+int BuildDriverVersionIndex( IRegistrySource* source, DriverVersionIndex* index )
+{
+	if( source == nullptr || index == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	StageTimer timer( Timings::STAGE_REGISTRY_WALK );
+
+	int subKeyCount = 0;
+	const int returnCode = source->GetSubKeyCount( &subKeyCount );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	index->clear();
+	for( int i = 0; i < subKeyCount; ++i )
+	{
+		uint64_t adapterLUID = 0;
+		uint64_t driverVersion = 0;
+
+		// The registry can contain old leftover driver entries with LUID == 0
+		if( source->GetQwordValue( i, "AdapterLuid", &adapterLUID ) && adapterLUID != 0 &&
+			source->GetQwordValue( i, "DriverVersion", &driverVersion ) )
+		{
+			// Keep the first key of a LUID, as the scan per adapter did
+			index->emplace( adapterLUID, driverVersion );
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int InitDxDriverVersion( GPUData* const gpuData, const DriverVersionIndex& index )
+{
+	if( gpuData == nullptr || !( gpuData->dxAdapterAvailability == true ) )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	if( gpuData->adapterLUID.HighPart == 0 && gpuData->adapterLUID.LowPart == 0 )
+	{
+		// This should not happen with an active/current adapter.
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	const uint64_t adapterLUID = ( (uint64_t) (uint32_t) gpuData->adapterLUID.HighPart << 32 ) | gpuData->adapterLUID.LowPart;
+	const auto it = index.find( adapterLUID );
+	if( it == index.end() )
+	{
+		return GPUDETECT_ERROR_REG_MISSING_DRIVER_INFO;
+	}
+
+	// Now that we have our driver version as a QWORD, let's process that into something readable
+	const uint64_t driverVersionRaw = it->second;
+	gpuData->dxDriverVersion[ 0 ] = (unsigned int) ( ( driverVersionRaw & 0xFFFF000000000000 ) >> 16 * 3 );
+	gpuData->dxDriverVersion[ 1 ] = (unsigned int) ( ( driverVersionRaw & 0x0000FFFF00000000 ) >> 16 * 2 );
+	gpuData->dxDriverVersion[ 2 ] = (unsigned int) ( ( driverVersionRaw & 0x00000000FFFF0000 ) >> 16 * 1 );
+	gpuData->dxDriverVersion[ 3 ] = (unsigned int) ( ( driverVersionRaw & 0x000000000000FFFF ) );
+
+	gpuData->driverInfo.driverReleaseRevision = gpuData->dxDriverVersion[2];
+	gpuData->driverInfo.driverBuildNumber = gpuData->dxDriverVersion[3];
+
+	gpuData->d3dRegistryDataAvailability = true;
+
+	return EXIT_SUCCESS;
+}
+
+int DriverVersionCache::InitDxDriverVersion( GPUData* const gpuData, IRegistrySource* source )
+{
+	if( gpuData == nullptr || source == nullptr || !( gpuData->dxAdapterAvailability == true ) )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	std::lock_guard< std::mutex > lock( m_mutex );
+
+	const bool builtNow = m_buildCount == 0;
+	if( builtNow )
+	{
+		const int returnCode = BuildDriverVersionIndex( source, &m_index );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+		++m_buildCount;
+	}
+
+	int returnCode = GPUDetect::InitDxDriverVersion( gpuData, m_index );
+	if( returnCode != GPUDETECT_ERROR_REG_MISSING_DRIVER_INFO )
+	{
+		return returnCode;
+	}
+
+	// Rebuild only for the first miss of a LUID, and not if the index is fresh
+	const uint64_t adapterLUID = ( (uint64_t) (uint32_t) gpuData->adapterLUID.HighPart << 32 ) | gpuData->adapterLUID.LowPart;
+	const bool firstMiss = m_missedLUIDs.insert( adapterLUID ).second;
+	if( builtNow || !firstMiss )
+	{
+		return returnCode;
+	}
+
+	returnCode = BuildDriverVersionIndex( source, &m_index );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+	++m_buildCount;
+
+	return GPUDetect::InitDxDriverVersion( gpuData, m_index );
+}
+
+unsigned int DriverVersionCache::GetBuildCount()
+{
+	std::lock_guard< std::mutex > lock( m_mutex );
+	return m_buildCount;
+}
+
+namespace
+{
+
+// Reads the counter into stack buffers; the names we look for are short, so a
+// counter whose strings do not fit is not one of them
+bool GetIntelDeviceInfoVersion( ICounterSource* source, int counterIndex, int* version )
+{
+	char name[ 64 ];
+	char description[ 256 ];
+	unsigned int nameLength = sizeof( name );
+	unsigned int descriptionLength = sizeof( description );
+	if( !source->CheckCounter( counterIndex, name, &nameLength, description, &descriptionLength ) )
+	{
+		return false;
+	}
+
+	name[ sizeof( name ) - 1 ] = '\0';
+	description[ sizeof( description ) - 1 ] = '\0';
+	if( strcmp( name, "Intel Device Information" ) != 0 )
+	{
+		return false;
+	}
+
+	*version = 0;
+	sscanf( description, "Version %d", version );
+	return true;
+}
+
+std::mutex counterCacheMutex;
+std::map< std::pair< uint32_t, uint64_t >, IntelDeviceInfoCounter > counterCache;  // guarded by counterCacheMutex
+
+}
+
+int FindIntelDeviceInfoCounter( ICounterSource* source, uint32_t deviceKey, uint64_t driverVersion, IntelDeviceInfoCounter* counter )
+{
+	if( source == nullptr || counter == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	StageTimer timer( Timings::STAGE_COUNTER_SCAN );
+
+	const int counterCount = source->GetCounterCount();
+	if( counterCount <= 0 )
+	{
+		return GPUDETECT_ERROR_DXGI_BAD_COUNTER;
+	}
+
+	const std::pair< uint32_t, uint64_t > key( deviceKey, driverVersion );
+
+	bool cached = false;
+	{
+		std::lock_guard< std::mutex > lock( counterCacheMutex );
+		const auto it = counterCache.find( key );
+		if( it != counterCache.end() )
+		{
+			*counter = it->second;
+			cached = true;
+		}
+	}
+
+	int version = 0;
+	if( cached && counter->counterIndex < counterCount && GetIntelDeviceInfoVersion( source, counter->counterIndex, &version ) )
+	{
+		counter->version = version;
+		return EXIT_SUCCESS;
+	}
+
+	for( int i = 0; i < counterCount; ++i )
+	{
+		if( GetIntelDeviceInfoVersion( source, i, &version ) )
+		{
+			counter->counterIndex = i;
+			counter->version = version;
+
+			std::lock_guard< std::mutex > lock( counterCacheMutex );
+			counterCache[ key ] = *counter;
+			return EXIT_SUCCESS;
+		}
+	}
+
+	return GPUDETECT_ERROR_DXGI_COUNTER_CREATION;
+}
+
+int InitCounterInfo( GPUData* const gpuData, ICounterSource* source, uint64_t driverVersion )
+{
+	if( gpuData == nullptr || source == nullptr || gpuData->vendorID == 0 || gpuData->deviceID == 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	//
+	// In DirectX, Intel exposes additional information through the driver that can be obtained
+	// querying a special DX counter
+	//
+	gpuData->counterAvailability = gpuData->vendorID == INTEL_VENDOR_ID;
+	if( !gpuData->counterAvailability )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	const uint32_t deviceKey = ( gpuData->vendorID << 16 ) | ( gpuData->deviceID & 0xFFFF );
+	IntelDeviceInfoCounter intelDeviceInfo = {};
+	int returnCode = FindIntelDeviceInfoCounter( source, deviceKey, driverVersion, &intelDeviceInfo );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	//
+	// Copy the information into the user's structure
+	//
+	assert( intelDeviceInfo.version == 1 || intelDeviceInfo.version == 2 );
+	const unsigned int infoSize = intelDeviceInfo.version == 1
+		? sizeof( IntelDeviceInfo1 )
+		: sizeof( IntelDeviceInfo2 );
+
+	IntelDeviceInfo2 info = {};
+	{
+		StageTimer timer( Timings::STAGE_COUNTER_DATA );
+		returnCode = source->GetCounterData( intelDeviceInfo.counterIndex, &info, infoSize );
+	}
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	gpuData->maxFrequency = info.GPUMaxFreq;
+	gpuData->minFrequency = info.GPUMinFreq;
+
+	//
+	// Older versions of the IntelDeviceInfo query only return
+	// GPUMaxFreq and GPUMinFreq, all other members will be zero.
+	//
+	if (info.GPUArchitecture != IGFX_UNKNOWN)
+	{
+		gpuData->advancedCounterDataAvailability = true;
+
+		gpuData->architecture = (INTEL_GPU_ARCHITECTURE)info.GPUArchitecture;
+		assert(gpuData->architecture == GetIntelGPUArchitecture(gpuData->deviceID));
+
+		gpuData->euCount = info.EUCount;
+		gpuData->packageTDP = info.PackageTDP;
+		gpuData->maxFillRate = info.MaxFillRate;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void ApplyDeviceCaps( const AdapterDesc& desc, const DeviceCaps& caps, GPUData* const gpuData )
+{
+	if( caps.isUMAArchitecture >= 0 )
+	{
+		gpuData->isUMAArchitecture = caps.isUMAArchitecture != 0;
+	}
+
+	if( gpuData->isUMAArchitecture )
+	{
+		gpuData->videoMemory = desc.sharedSystemMemory;
+	}
+	else
+	{
+		gpuData->videoMemory = desc.dedicatedVideoMemory;
+	}
+
+	// Intel specific information
+	if( gpuData->vendorID == INTEL_VENDOR_ID && caps.extensionVersion != 0 )
+	{
+		gpuData->extensionVersion = caps.extensionVersion;
+		gpuData->intelExtensionAvailability = ( gpuData->extensionVersion >= kExtensionInterfaceVersion1_0 );
+	}
+}
+
+int InitAll( GPUData* const gpuData, const BackendSources& sources, int adapterIndex )
+{
+	if( gpuData == nullptr || sources.adapters == nullptr || sources.devices == nullptr || sources.registry == nullptr ||
+		sources.driverVersions == nullptr || adapterIndex < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	if( adapterIndex >= sources.adapters->GetAdapterCount() )
+	{
+		return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+	}
+
+	// InitExtensionInfo
+	AdapterDesc desc = {};
+	int returnCode = sources.adapters->GetAdapterDesc( adapterIndex, &desc );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	FillAdapterData( desc, gpuData );
+
+	DeviceCaps caps = {};
+	returnCode = sources.devices->GetDeviceCaps( adapterIndex, gpuData->vendorID == INTEL_VENDOR_ID, &caps );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	ApplyDeviceCaps( desc, caps, gpuData );
+
+	// InitDxDriverVersion
+	returnCode = sources.driverVersions->InitDxDriverVersion( gpuData, sources.registry );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	// InitCounterInfo
+	ICounterSource* counters = nullptr;
+	returnCode = sources.devices->GetCounterSource( adapterIndex, &counters );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	return InitCounterInfo( gpuData, counters, caps.driverVersion );
+}
+
+void FillAdapterData( const AdapterDesc& desc, GPUData* const gpuData )
+{
+	gpuData->dxAdapterAvailability = true;
+
+	gpuData->vendorID = desc.vendorID;
+	gpuData->deviceID = desc.deviceID;
+	gpuData->adapterLUID = desc.adapterLUID;
+
+	static_assert( sizeof( GPUData::description ) == sizeof( AdapterDesc::description ), "description size mismatch" );
+	memcpy( gpuData->description, desc.description, sizeof( gpuData->description ) );
+
+	//
+	// Without a device, assume Intel adapters with only a small dedicated
+	// pool are integrated GPUs.
+	//
+	gpuData->isUMAArchitecture = desc.vendorID == INTEL_VENDOR_ID && desc.dedicatedVideoMemory <= 512 * 1024 * 1024;
+
+	if( gpuData->isUMAArchitecture )
+	{
+		gpuData->videoMemory = desc.sharedSystemMemory;
+	}
+	else
+	{
+		gpuData->videoMemory = desc.dedicatedVideoMemory;
+	}
+
+	if( desc.vendorID == INTEL_VENDOR_ID )
+	{
+		gpuData->architecture = GetIntelGPUArchitecture( gpuData->deviceID );
+	}
+}
+
+int EnumerateAdapters( IAdapterSource* source, std::vector< GPUData >* gpuData )
+{
+	if( source == nullptr || gpuData == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	const int adapterCount = source->GetAdapterCount();
+
+	gpuData->clear();
+	gpuData->reserve( adapterCount );
 
-		ID3D10::CAPS_EXTENSION intelExtCaps = {};
-		if (S_OK == GetExtensionCaps(device, &intelExtCaps))
+	for( int i = 0; i < adapterCount; ++i )
+	{
+		AdapterDesc desc = {};
+		const int returnCode = source->GetAdapterDesc( i, &desc );
+		if( returnCode != EXIT_SUCCESS )
 		{
-			gpuData->extensionVersion = intelExtCaps.DriverVersion;
-			gpuData->intelExtensionAvailability = (gpuData->extensionVersion >= ID3D10::EXTENSION_INTERFACE_VERSION_1_0);
+			return returnCode;
 		}
+
+		GPUData data = {};
+		FillAdapterData( desc, &data );
+		gpuData->push_back( data );
 	}
 
 	return EXIT_SUCCESS;
 }
 
-int InitCounterInfo( GPUData* const gpuData, int adapterIndex )
+int InitAllAdapters( IAdapterDetector* detector, std::vector< GPUData >* gpuData, std::vector< int >* returnCodes, unsigned int maxThreads )
 {
-	if( gpuData == nullptr || adapterIndex < 0 )
+	if( detector == nullptr || gpuData == nullptr )
 	{
 		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	IDXGIAdapter* adapter = nullptr;
-	int returnCode = InitAdapter( &adapter, adapterIndex );
+	int adapterCount = 0;
+	const int returnCode = detector->GetAdapterCount( &adapterCount );
 	if( returnCode != EXIT_SUCCESS )
 	{
 		return returnCode;
 	}
 
-	ID3D11Device* device = nullptr;
-	returnCode = InitDevice( adapter, &device );
-	if( returnCode != EXIT_SUCCESS )
+	gpuData->assign( adapterCount, GPUData() );
+	std::vector< int > adapterReturnCodes( adapterCount, EXIT_SUCCESS );
+
+	// Threads take the next adapter when done, so a slow adapter does not
+	// hold back the others
+	std::atomic< int > nextAdapter( 0 );
+	const auto detectAdapters = [ & ]()
 	{
-		adapter->Release();
-		return returnCode;
+		for( int i = nextAdapter++; i < adapterCount; i = nextAdapter++ )
+		{
+			adapterReturnCodes[ i ] = detector->InitAll( &( *gpuData )[ i ], i );
+		}
+	};
+
+	// Detection mostly waits on the driver, so the default is not tied to
+	// the number of CPU cores
+	const unsigned int kDefaultMaxThreads = 8;
+	if( maxThreads == 0 )
+	{
+		maxThreads = kDefaultMaxThreads;
 	}
+	const unsigned int threadCount = std::min( maxThreads, (unsigned int) adapterCount );
 
-	returnCode = InitCounterInfo( gpuData, device );
+	std::vector< std::thread > workers;
+	for( unsigned int i = 1; i < threadCount; ++i )
+	{
+		workers.emplace_back( detectAdapters );
+	}
 
-	adapter->Release();
-	return returnCode;
-}
+	detectAdapters();
 
-int InitCounterInfo( GPUData* const gpuData, ID3D11Device* device )
-{
-	if( gpuData == nullptr || device == nullptr || gpuData->vendorID == 0 || gpuData->deviceID == 0 )
+	for( std::thread& worker : workers )
 	{
-		return GPUDETECT_ERROR_BAD_DATA;
+		worker.join();
 	}
 
-	//
-	// In DirectX, Intel exposes additional information through the driver that can be obtained
-	// querying a special DX counter
-	//
-	gpuData->counterAvailability = gpuData->vendorID == INTEL_VENDOR_ID;
-	if( !gpuData->counterAvailability )
+	if( returnCodes != nullptr )
 	{
-		return GPUDETECT_ERROR_NOT_SUPPORTED;
+		*returnCodes = std::move( adapterReturnCodes );
 	}
+	return EXIT_SUCCESS;
+}
 
-	IntelDeviceInfo2 info = {};
-	const int deviceInfoReturnCode = GetIntelDeviceInfo( &info, device );
-	if (deviceInfoReturnCode != EXIT_SUCCESS)
+#ifdef _WIN32
+LazyGPUData::LazyGPUData( int adapterIndex, Context* context )
+	: m_data()
+	, m_adapterIndex( adapterIndex )
+	, m_loaded()
+	, m_returnCode()
+	, m_context( context != nullptr ? context : &m_ownContext )
+{
+}
+#else
+LazyGPUData::LazyGPUData( int adapterIndex )
+	: m_data()
+	, m_adapterIndex( adapterIndex )
+	, m_loaded()
+	, m_returnCode()
+{
+}
+#endif
+
+int LazyGPUData::Load( Stage stage )
+{
+	if( stage < 0 || stage >= STAGE_COUNT )
 	{
-		return deviceInfoReturnCode;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
-	else
+
+	if( !m_loaded[ stage ] )
 	{
-		gpuData->maxFrequency = info.GPUMaxFreq;
-		gpuData->minFrequency = info.GPUMinFreq;
+		m_returnCode[ stage ] = RunStage( stage );
+		m_loaded[ stage ] = true;
 
-		//
-		// Older versions of the IntelDeviceInfo query only return
-		// GPUMaxFreq and GPUMinFreq, all other members will be zero.
-		//
-		if (info.GPUArchitecture != IGFX_UNKNOWN)
+		// InitExtensionInfo also loads every adapter-level field; running
+		// InitAdapterInfo afterwards would replace its UMA answer by a guess
+		if( stage == STAGE_EXTENSION && m_returnCode[ stage ] == EXIT_SUCCESS )
 		{
-			gpuData->advancedCounterDataAvailability = true;
-
-			gpuData->architecture = (INTEL_GPU_ARCHITECTURE)info.GPUArchitecture;
-			assert(gpuData->architecture == GetIntelGPUArchitecture(gpuData->deviceID));
-
-			gpuData->euCount = info.EUCount;
-			gpuData->packageTDP = info.PackageTDP;
-			gpuData->maxFillRate = info.MaxFillRate;
+			m_loaded[ STAGE_ADAPTER ] = true;
+			m_returnCode[ STAGE_ADAPTER ] = EXIT_SUCCESS;
 		}
 	}
 
-	return EXIT_SUCCESS;
+	return m_returnCode[ stage ];
 }
 
-PresetLevel GetDefaultFidelityPreset( const GPUData* const gpuData )
+int LazyGPUData::RunStage( Stage stage )
 {
-	// Return if prerequisite info is not met
-	if( !gpuData->dxAdapterAvailability )
+	switch( stage )
 	{
-		return PresetLevel::Undefined;
-	}
+	case STAGE_ADAPTER:
+#ifdef _WIN32
+		return InitAdapterInfo( &m_data, m_context, m_adapterIndex );
+#else
+		return InitAdapterInfo( &m_data, m_adapterIndex );
+#endif
 
-	//
-	// Look for a config file that qualifies devices from any vendor
-	// The code here looks for a file with one line per recognized graphics
-	// device in the following format:
-	//
-	// VendorIDHex, DeviceIDHex, CapabilityEnum      ;Commented name of card
-	//
+	case STAGE_EXTENSION:
+#ifdef _WIN32
+		return InitExtensionInfo( &m_data, m_context, m_adapterIndex );
+#else
+		return InitExtensionInfo( &m_data, m_adapterIndex );
+#endif
+
+	case STAGE_COUNTER:
+	{
+		// As in InitAll, the extension stage runs first. Run afterwards, its
+		// FillAdapterData would replace the counter-reported architecture
+		// with the table's, which is IGFX_UNKNOWN for parts newer than it.
+		const int returnCode = Load( STAGE_EXTENSION );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
 
-	const char* cfgFileName = nullptr;
+#ifdef _WIN32
+		return InitCounterInfo( &m_data, m_context, m_adapterIndex );
+#else
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+#endif
+	}
 
-	switch( gpuData->vendorID )
+	case STAGE_DRIVER_VERSION:
 	{
-	case INTEL_VENDOR_ID:
-		cfgFileName = "IntelGfx.cfg";
-		break;
+		const int returnCode = Load( STAGE_ADAPTER );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
 
-		// Add other cases in this fashion to allow for additional cfg files
-		//case SOME_VENDOR_ID:
-		//    cfgFileName =  "OtherBrandGfx.cfg";
-		//    break;
+#ifdef _WIN32
+		return InitDxDriverVersion( &m_data );
+#else
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+#endif
+	}
 
 	default:
-		return PresetLevel::Undefined;;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
+}
 
-	PresetLevel presets = Undefined;
+const GPUData& LazyGPUData::GetData() const
+{
+	return m_data;
+}
 
-	FILE* fp = nullptr;
-	fopen_s( &fp, cfgFileName, "r" );
+bool LazyGPUData::dxAdapterAvailability()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.dxAdapterAvailability;
+}
 
-	if( fp )
-	{
-		char line[ 100 ];
+unsigned int LazyGPUData::vendorID()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.vendorID;
+}
 
-		//
-		// read one line at a time till EOF
-		//
-		while( fgets( line, _countof( line ), fp ) )
-		{
-			//
-			// Parse and remove the comment part of any line
-			//
-			unsigned int i = 0;
-			for( ; i < _countof( line ) - 1 && line[ i ] && line[ i ] != ';'; i++ )
-			{}
-			line[ i ] = '\0';
-
-			//
-			// Try to extract GPUVendorId, GPUDeviceId and recommended Default Preset Level
-			//
-			char* context = nullptr;
-			const char* const szVendorId = strtok_s( line, ",\n", &context );
-			const char* const szDeviceId = strtok_s( nullptr, ",\n", &context );
-			const char* const szPresetLevel = strtok_s( nullptr, ",\n", &context );
-
-			if( ( szVendorId == nullptr ) ||
-				( szDeviceId == nullptr ) ||
-				( szPresetLevel == nullptr ) )
-			{
-				continue;  // blank or improper line in cfg file - skip to next line
-			}
+unsigned int LazyGPUData::deviceID()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.deviceID;
+}
 
-			unsigned int vId = 0;
-			int rv = sscanf_s( szVendorId, "%x", &vId );
-			assert( rv == 1 );
+LUID LazyGPUData::adapterLUID()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.adapterLUID;
+}
 
-			unsigned int dId = 0;
-			rv = sscanf_s( szDeviceId, "%x", &dId );
-			assert( rv == 1 );
+INTEL_GPU_ARCHITECTURE LazyGPUData::architecture()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.architecture;
+}
 
-			//
-			// If current graphics device is found in the cfg file, use the
-			// pre-configured default Graphics Presets setting.
-			//
-			if( ( vId == gpuData->vendorID ) && ( dId == gpuData->deviceID ) )
-			{
-				char s[ 10 ] = {};
-				sscanf_s( szPresetLevel, "%s", s, (unsigned int) _countof( s ) );
-
-				if( !_stricmp( s, "Low" ) )
-					presets = Low;
-				else if( !_stricmp( s, "Medium" ) )
-					presets = Medium;
-				else if( !_stricmp( s, "Medium+" ) )
-					presets = MediumPlus;
-				else if( !_stricmp( s, "High" ) )
-					presets = High;
-				else
-					presets = NotCompatible;
-
-				break;
-			}
-		}
+const WCHAR* LazyGPUData::description()
+{
+	Load( STAGE_ADAPTER );
+	return m_data.description;
+}
 
-		fclose( fp );
-	}
-	else
-	{
-		fprintf( stderr, "Error: %s not found! Fallback to default presets.\n", cfgFileName );
-	}
+bool LazyGPUData::isUMAArchitecture()
+{
+	Load( STAGE_EXTENSION );
+	return m_data.isUMAArchitecture;
+}
 
-	//
-	// If the current graphics device was not listed in any of the config
-	// files, or if config file not found, use Low settings as default.
-	// This should be changed to reflect the desired behavior for unknown
-	// graphics devices.
-	//
-	if( presets == Undefined )
-	{
-		presets = Low;
-	}
+uint64_t LazyGPUData::videoMemory()
+{
+	Load( STAGE_EXTENSION );
+	return m_data.videoMemory;
+}
 
-	return presets;
+unsigned int LazyGPUData::extensionVersion()
+{
+	Load( STAGE_EXTENSION );
+	return m_data.extensionVersion;
 }
 
-int InitDxDriverVersion( GPUData* const gpuData )
+bool LazyGPUData::intelExtensionAvailability()
 {
-	if( gpuData == nullptr || !( gpuData->dxAdapterAvailability == true ) )
-	{
-		return GPUDETECT_ERROR_BAD_DATA;
-	}
+	Load( STAGE_EXTENSION );
+	return m_data.intelExtensionAvailability;
+}
 
-	if( gpuData->adapterLUID.HighPart == 0 && gpuData->adapterLUID.LowPart == 0 )
-	{
-		// This should not happen with an active/current adapter.
-		// But the registry can contain old leftover driver entries with LUID == 0.
-		return GPUDETECT_ERROR_BAD_DATA;
-	}
+bool LazyGPUData::counterAvailability()
+{
+	Load( STAGE_COUNTER );
+	return m_data.counterAvailability;
+}
+
+unsigned int LazyGPUData::maxFrequency()
+{
+	Load( STAGE_COUNTER );
+	return m_data.maxFrequency;
+}
 
-	// Fetch registry data
-	HKEY dxKeyHandle = nullptr;
-	DWORD numOfAdapters = 0;
+unsigned int LazyGPUData::minFrequency()
+{
+	Load( STAGE_COUNTER );
+	return m_data.minFrequency;
+}
 
-	LSTATUS returnCode = ::RegOpenKeyEx( HKEY_LOCAL_MACHINE, _T("SOFTWARE\\Microsoft\\DirectX"), 0, KEY_READ, &dxKeyHandle );
+bool LazyGPUData::advancedCounterDataAvailability()
+{
+	Load( STAGE_COUNTER );
+	return m_data.advancedCounterDataAvailability;
+}
 
-	if( returnCode != ERROR_SUCCESS )
-	{
-		return GPUDETECT_ERROR_REG_NO_D3D_KEY;
-	}
+unsigned int LazyGPUData::euCount()
+{
+	Load( STAGE_COUNTER );
+	return m_data.euCount;
+}
 
-	// Find all subkeys
+unsigned int LazyGPUData::packageTDP()
+{
+	Load( STAGE_COUNTER );
+	return m_data.packageTDP;
+}
 
-	DWORD subKeyMaxLength = 0;
+unsigned int LazyGPUData::maxFillRate()
+{
+	Load( STAGE_COUNTER );
+	return m_data.maxFillRate;
+}
 
-	returnCode = ::RegQueryInfoKey(
-		dxKeyHandle,
-		nullptr,
-		nullptr,
-		nullptr,
-		&numOfAdapters,
-		&subKeyMaxLength,
-		nullptr,
-		nullptr,
-		nullptr,
-		nullptr,
-		nullptr,
-		nullptr
-	);
+const unsigned int* LazyGPUData::dxDriverVersion()
+{
+	Load( STAGE_DRIVER_VERSION );
+	return m_data.dxDriverVersion;
+}
 
-	if( returnCode != ERROR_SUCCESS )
-	{
-		return GPUDETECT_ERROR_REG_GENERAL_FAILURE;
-	}
+bool LazyGPUData::d3dRegistryDataAvailability()
+{
+	Load( STAGE_DRIVER_VERSION );
+	return m_data.d3dRegistryDataAvailability;
+}
+
+const GPUData::DriverVersionInfo& LazyGPUData::driverInfo()
+{
+	Load( STAGE_DRIVER_VERSION );
+	return m_data.driverInfo;
+}
 
-	subKeyMaxLength += 1; // include the null character
+struct AsyncGPUData::Impl
+{
+	int adapterIndex;
+	StageCallback callback;
+	void* userData;
 
-	uint64_t driverVersionRaw = 0;
+	std::mutex mutex;
+	std::condition_variable stageDone;
+	GPUData published;                                  // guarded by mutex
+	bool done[ LazyGPUData::STAGE_COUNT ];              // guarded by mutex
+	int returnCode[ LazyGPUData::STAGE_COUNT ];         // guarded by mutex
+	std::atomic< bool > cancelled;
 
-	bool foundSubkey = false;
-	TCHAR* subKeyName = new TCHAR[subKeyMaxLength];
+	std::thread thread;
 
-	for( DWORD i = 0; i < numOfAdapters; ++i )
+	void Run()
 	{
-		DWORD subKeyLength = subKeyMaxLength;
+		// The context, and with it the device, lives on this thread only
+		LazyGPUData lazyData( adapterIndex );
 
-		returnCode = ::RegEnumKeyEx(
-			dxKeyHandle,
-			i,
-			subKeyName,
-			&subKeyLength,
-			nullptr,
-			nullptr,
-			nullptr,
-			nullptr
-		);
-
-		if( returnCode == ERROR_SUCCESS )
+		for( int i = 0; i < LazyGPUData::STAGE_COUNT; ++i )
 		{
-			LUID adapterLUID = {};
-			DWORD qwordSize = sizeof( uint64_t );
+			const LazyGPUData::Stage stage = (LazyGPUData::Stage) i;
+			const int stageReturnCode = cancelled ? GPUDETECT_ERROR_GENERIC : lazyData.Load( stage );
 
-			returnCode = ::RegGetValue(
-				dxKeyHandle,
-				subKeyName,
-				_T("AdapterLuid"),
-				RRF_RT_QWORD,
-				nullptr,
-				&adapterLUID,
-				&qwordSize
-			);
+			{
+				std::lock_guard< std::mutex > lock( mutex );
+				published = lazyData.GetData();
+				done[ stage ] = true;
+				returnCode[ stage ] = stageReturnCode;
+			}
+			stageDone.notify_all();
 
-			if( returnCode == ERROR_SUCCESS // If we were able to retrieve the registry values
-				&& adapterLUID.HighPart == gpuData->adapterLUID.HighPart && adapterLUID.LowPart == gpuData->adapterLUID.LowPart ) // and if the vendor ID and device ID match
+			if( callback != nullptr && !cancelled )
 			{
-				// We have our registry key! Let's get the driver version num now
-
-				returnCode = ::RegGetValue(
-					dxKeyHandle,
-					subKeyName,
-					_T("DriverVersion"),
-					RRF_RT_QWORD,
-					nullptr,
-					&driverVersionRaw,
-					&qwordSize
-				);
-
-				if( returnCode == ERROR_SUCCESS )
-				{
-					foundSubkey = true;
-					break;
-				}
+				callback( stage, stageReturnCode, lazyData.GetData(), userData );
 			}
 		}
 	}
+};
+
+AsyncGPUData::AsyncGPUData( int adapterIndex, StageCallback callback, void* userData )
+	: m_impl( new Impl )
+{
+	m_impl->adapterIndex = adapterIndex;
+	m_impl->callback = callback;
+	m_impl->userData = userData;
+	m_impl->published = {};
+	std::fill( m_impl->done, m_impl->done + LazyGPUData::STAGE_COUNT, false );
+	std::fill( m_impl->returnCode, m_impl->returnCode + LazyGPUData::STAGE_COUNT, EXIT_SUCCESS );
+	m_impl->cancelled = false;
+
+	m_impl->thread = std::thread( &Impl::Run, m_impl );
+}
 
-	returnCode = ::RegCloseKey( dxKeyHandle );
-	assert( returnCode == ERROR_SUCCESS );
-	delete[] subKeyName;
+AsyncGPUData::~AsyncGPUData()
+{
+	m_impl->cancelled = true;
+	m_impl->thread.join();
+	delete m_impl;
+}
 
-	if( !foundSubkey )
+int AsyncGPUData::Wait( LazyGPUData::Stage stage, GPUData* const gpuData )
+{
+	if( stage < 0 || stage >= LazyGPUData::STAGE_COUNT || gpuData == nullptr )
 	{
-		return GPUDETECT_ERROR_REG_MISSING_DRIVER_INFO;
+		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
-	// Now that we have our driver version as a DWORD, let's process that into something readable
-	gpuData->dxDriverVersion[ 0 ] = (unsigned int) ( ( driverVersionRaw & 0xFFFF000000000000 ) >> 16 * 3 );
-	gpuData->dxDriverVersion[ 1 ] = (unsigned int) ( ( driverVersionRaw & 0x0000FFFF00000000 ) >> 16 * 2 );
-	gpuData->dxDriverVersion[ 2 ] = (unsigned int) ( ( driverVersionRaw & 0x00000000FFFF0000 ) >> 16 * 1 );
-	gpuData->dxDriverVersion[ 3 ] = (unsigned int) ( ( driverVersionRaw & 0x000000000000FFFF ) );
+	std::unique_lock< std::mutex > lock( m_impl->mutex );
+	m_impl->stageDone.wait( lock, [ this, stage ]() { return m_impl->done[ stage ]; } );
 
-	gpuData->driverInfo.driverReleaseRevision = gpuData->dxDriverVersion[2];
-	gpuData->driverInfo.driverBuildNumber = gpuData->dxDriverVersion[3];
+	*gpuData = m_impl->published;
+	return m_impl->returnCode[ stage ];
+}
 
-	gpuData->d3dRegistryDataAvailability = true;
+bool AsyncGPUData::TryGet( LazyGPUData::Stage stage, GPUData* const gpuData, int* returnCode )
+{
+	if( stage < 0 || stage >= LazyGPUData::STAGE_COUNT || gpuData == nullptr || returnCode == nullptr )
+	{
+		return false;
+	}
 
-	return EXIT_SUCCESS;
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	if( !m_impl->done[ stage ] )
+	{
+		return false;
+	}
+
+	*gpuData = m_impl->published;
+	*returnCode = m_impl->returnCode[ stage ];
+	return true;
 }
 
 void GetDriverVersionAsCString( const GPUData* const gpuData, char* const outBuffer, size_t outBufferSize )
@@ -556,7 +1815,7 @@ void GetDriverVersionAsCString( const GPUData* const gpuData, char* const outBuf
 	const size_t kMaxBufferSize = (4 * 4) + 3;
 	if( gpuData != nullptr && outBuffer != nullptr && outBufferSize <= kMaxBufferSize)
 	{
-		sprintf_s( outBuffer, outBufferSize, "%u.%u.%u.%u", gpuData->dxDriverVersion[ 0 ], gpuData->dxDriverVersion[ 1 ], gpuData->dxDriverVersion[ 2 ], gpuData->dxDriverVersion[ 3 ] );
+		snprintf( outBuffer, outBufferSize, "%u.%u.%u.%u", gpuData->dxDriverVersion[ 0 ], gpuData->dxDriverVersion[ 1 ], gpuData->dxDriverVersion[ 2 ], gpuData->dxDriverVersion[ 3 ] );
 	}
 }
 
@@ -630,20 +1889,21 @@ const char * GetIntelGraphicsGenerationString( const IntelGraphicsGeneration gen
 	}
 }
 
-int InitAdapter( IDXGIAdapter** adapter, int adapterIndex )
-{
-	if( adapter == nullptr || adapterIndex < 0 )
-	{
-		return GPUDETECT_ERROR_BAD_DATA;
-	}
+#ifdef _WIN32
 
+int LoadDxgiFactory( HMODULE* dxgiModule, IDXGIFactory** factory )
+{
 	//
 	// We are relying on DXGI (supported on Windows Vista and later) to query
 	// the adapter, so fail if it is not available.
 	//
 	// DXGIFactory1 is required by Windows Store Apps so try that first.
 	//
-	const HMODULE hDXGI = ::LoadLibrary( _T("dxgi.dll") );
+	HMODULE hDXGI = nullptr;
+	{
+		StageTimer timer( Timings::STAGE_LOAD_LIBRARY );
+		hDXGI = ::LoadLibrary( _T("dxgi.dll") );
+	}
 	if( hDXGI == nullptr )
 	{
 		return GPUDETECT_ERROR_DXGI_LOAD;
@@ -666,6 +1926,8 @@ int InitAdapter( IDXGIAdapter** adapter, int adapterIndex )
 	// We have the CreateDXGIFactory function so use it to actually create the factory and enumerate
 	// through the adapters. Here, we are specifically looking for the Intel gfx adapter.
 	//
+	StageTimer timer( Timings::STAGE_CREATE_FACTORY );
+
 	IDXGIFactory* pFactory = nullptr;
 	if( FAILED( pCreateDXGIFactory( __uuidof( IDXGIFactory ), (void**) ( &pFactory ) ) ) )
 	{
@@ -673,6 +1935,44 @@ int InitAdapter( IDXGIAdapter** adapter, int adapterIndex )
 		return GPUDETECT_ERROR_DXGI_FACTORY_CREATION;
 	}
 
+	*dxgiModule = hDXGI;
+	*factory = pFactory;
+	return EXIT_SUCCESS;
+}
+
+int GetDxgiAdapterDesc( IDXGIAdapter* adapter, AdapterDesc* desc )
+{
+	DXGI_ADAPTER_DESC dxgiDesc = {};
+	if( FAILED( adapter->GetDesc( &dxgiDesc ) ) )
+	{
+		return GPUDETECT_ERROR_DXGI_ADAPTER_CREATION;
+	}
+
+	desc->vendorID = dxgiDesc.VendorId;
+	desc->deviceID = dxgiDesc.DeviceId;
+	desc->adapterLUID = dxgiDesc.AdapterLuid;
+	wcscpy_s( desc->description, _countof( desc->description ), dxgiDesc.Description );
+	desc->dedicatedVideoMemory = dxgiDesc.DedicatedVideoMemory;
+	desc->sharedSystemMemory = dxgiDesc.SharedSystemMemory;
+
+	return EXIT_SUCCESS;
+}
+
+int InitAdapter( IDXGIAdapter** adapter, int adapterIndex )
+{
+	if( adapter == nullptr || adapterIndex < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	HMODULE hDXGI = nullptr;
+	IDXGIFactory* pFactory = nullptr;
+	const int returnCode = LoadDxgiFactory( &hDXGI, &pFactory );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
 	if( FAILED( pFactory->EnumAdapters( adapterIndex, (IDXGIAdapter**) adapter ) ) )
 	{
 		pFactory->Release();
@@ -692,6 +1992,8 @@ int InitDevice( IDXGIAdapter* adapter, ID3D11Device** device )
 		return GPUDETECT_ERROR_BAD_DATA;
 	}
 
+	StageTimer timer( Timings::STAGE_CREATE_DEVICE );
+
 	if( FAILED( ::D3D11CreateDevice( adapter, D3D_DRIVER_TYPE_UNKNOWN, nullptr, 0, nullptr, 0, D3D11_SDK_VERSION, device, nullptr, nullptr ) ) )
 	{
 		return GPUDETECT_ERROR_DXGI_DEVICE_CREATION;
@@ -700,110 +2002,43 @@ int InitDevice( IDXGIAdapter* adapter, ID3D11Device** device )
 	return EXIT_SUCCESS;
 }
 
-int GetIntelDeviceInfo( IntelDeviceInfo2* deviceInfo, ID3D11Device* device )
+void GetDxgiDeviceCaps( IDXGIAdapter* adapter, ID3D11Device* device, bool queryIntelExtension, DeviceCaps* caps )
 {
-	assert( deviceInfo != nullptr );
-	assert( device != nullptr );
-
-	//
-	// Grab the device context from the device.
-	//
-	ID3D11DeviceContext* deviceContext = nullptr;
-	device->GetImmediateContext( &deviceContext );
+	*caps = {};
+	caps->isUMAArchitecture = -1;
 
-	//
-	// Query the device to find the number of device dependent counters.
-	//
-	D3D11_COUNTER_INFO counterInfo = {};
-	device->CheckCounterInfo( &counterInfo );
-	if( counterInfo.LastDeviceDependentCounter == 0 )
-	{
-		deviceContext->Release();
-		return GPUDETECT_ERROR_DXGI_BAD_COUNTER;
-	}
-
-	//
-	// Search for the "Intel Device Information" counter and, if found, parse
-	// it's description to determine the supported version.
-	//
-	D3D11_COUNTER_DESC counterDesc = {};
-	int intelDeviceInfoVersion = 0;
-	bool intelDeviceInfo = false;
-
-	for( int i = D3D11_COUNTER_DEVICE_DEPENDENT_0; i <= counterInfo.LastDeviceDependentCounter; ++i )
+#ifdef _WIN32_WINNT_WIN10
+	ID3D11Device3* pDevice3 = nullptr;
+	if( SUCCEEDED( device->QueryInterface( __uuidof( ID3D11Device3 ), (void**) &pDevice3 ) ) )
 	{
-		counterDesc.Counter = static_cast<D3D11_COUNTER>( i );
-
-		D3D11_COUNTER_TYPE counterType = {};
-		UINT uiSlotsRequired = 0;
-		UINT uiNameLength = 0;
-		UINT uiUnitsLength = 0;
-		UINT uiDescLength = 0;
-
-		if( FAILED( device->CheckCounter( &counterDesc, &counterType, &uiSlotsRequired, nullptr, &uiNameLength, nullptr, &uiUnitsLength, nullptr, &uiDescLength ) ) )
-		{
-			continue;
-		}
-
-		LPSTR sName = new char[ uiNameLength ];
-		LPSTR sUnits = new char[ uiUnitsLength ];
-		LPSTR sDesc = new char[ uiDescLength ];
-
-		intelDeviceInfo =
-			SUCCEEDED( device->CheckCounter( &counterDesc, &counterType, &uiSlotsRequired, sName, &uiNameLength, sUnits, &uiUnitsLength, sDesc, &uiDescLength ) ) &&
-			( strcmp( sName, "Intel Device Information" ) == 0 );
-
-		if( intelDeviceInfo )
+		D3D11_FEATURE_DATA_D3D11_OPTIONS2 FeatureData = {};
+		if( SUCCEEDED( pDevice3->CheckFeatureSupport( D3D11_FEATURE_D3D11_OPTIONS2, &FeatureData, sizeof( FeatureData ) ) ) )
 		{
-			sscanf_s( sDesc, "Version %d", &intelDeviceInfoVersion );
+			caps->isUMAArchitecture = FeatureData.UnifiedMemoryArchitecture == TRUE ? 1 : 0;
 		}
+		pDevice3->Release();
+	}
+#endif // _WIN32_WINNT_WIN10
 
-		delete[] sName;
-		delete[] sUnits;
-		delete[] sDesc;
+	// Intel specific information
+	if( queryIntelExtension )
+	{
+		StageTimer timer( Timings::STAGE_EXTENSION_CAPS );
 
-		if( intelDeviceInfo )
+		ID3D10::CAPS_EXTENSION intelExtCaps = {};
+		if (S_OK == GetExtensionCaps(device, &intelExtCaps))
 		{
-			break;
+			caps->extensionVersion = intelExtCaps.DriverVersion;
 		}
 	}
 
-	//
-	// Create the information counter, and query it to get the data. GetData()
-	// returns a pointer to the data, not the actual data.
-	//
-	ID3D11Counter* counter = nullptr;
-	if( !intelDeviceInfo || FAILED( device->CreateCounter( &counterDesc, &counter ) ) )
-	{
-		deviceContext->Release();
-		return GPUDETECT_ERROR_DXGI_COUNTER_CREATION;
-	}
-
-	deviceContext->Begin( counter );
-	deviceContext->End( counter );
-
-	uintptr_t dataAddress = 0;
-	if( deviceContext->GetData( counter, reinterpret_cast<void*>(&dataAddress), sizeof( dataAddress ), 0 ) != S_OK )
+	LARGE_INTEGER umdVersion = {};
+	if( SUCCEEDED( adapter->CheckInterfaceSupport( __uuidof( IDXGIDevice ), &umdVersion ) ) )
 	{
-		counter->Release();
-		deviceContext->Release();
-		return GPUDETECT_ERROR_DXGI_COUNTER_GET_DATA;
+		caps->driverVersion = (uint64_t) umdVersion.QuadPart;
 	}
-
-	//
-	// Copy the information into the user's structure
-	//
-	assert( intelDeviceInfoVersion == 1 || intelDeviceInfoVersion == 2 );
-	const size_t infoSize = intelDeviceInfoVersion == 1
-		? sizeof( IntelDeviceInfo1 )
-		: sizeof( IntelDeviceInfo2 );
-	assert( infoSize <= sizeof( *deviceInfo ) );
-	memset( deviceInfo, 0, sizeof( *deviceInfo ) );
-	memcpy( deviceInfo, reinterpret_cast<const void*>( dataAddress ), infoSize );
-
-	counter->Release();
-	deviceContext->Release();
-	return EXIT_SUCCESS;
 }
 
+#endif // _WIN32
+
 }
@@ -19,6 +19,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "DeviceId.h"
 
 
@@ -26,6 +28,18 @@
 struct IDXGIAdapter;
 struct ID3D11Device;
 
+#ifndef _WIN32
+// Stand-ins for the Windows types used by GPUData, so that the sysfs backend
+// can fill the same struct on Linux.
+typedef wchar_t WCHAR;
+
+struct LUID
+{
+	uint32_t LowPart;
+	int32_t HighPart;
+};
+#endif
+
 
 // Error return codes for GPUDetect
 // These codes are set up so that (ERROR_CODE % GENERAL_ERROR_CODE) == 0 if
@@ -57,9 +71,27 @@ struct ID3D11Device;
 
 #define GPUDETECT_ERROR_NOT_SUPPORTED           55
 
+/// Linux sysfs Errors
+#define GPUDETECT_ERROR_GENERAL_SYSFS           59
+#define GPUDETECT_ERROR_SYSFS_NO_DRM            GPUDETECT_ERROR_GENERAL_SYSFS * 61 // The DRM class directory could not be opened
+#define GPUDETECT_ERROR_SYSFS_NO_ADAPTER        GPUDETECT_ERROR_GENERAL_SYSFS * 67 // No DRM card exists for the given index
+#define GPUDETECT_ERROR_SYSFS_READ              GPUDETECT_ERROR_GENERAL_SYSFS * 71 // A required sysfs attribute could not be read
+
+/// Backend recording Errors
+#define GPUDETECT_ERROR_GENERAL_REPLAY          73
+#define GPUDETECT_ERROR_REPLAY_FILE             GPUDETECT_ERROR_GENERAL_REPLAY * 79 // A recording could not be read or written, or is corrupt
+#define GPUDETECT_ERROR_REPLAY_MISSING_ANSWER   GPUDETECT_ERROR_GENERAL_REPLAY * 83 // A replayed source was asked something that was not recorded
+
+/// Trace Errors
+#define GPUDETECT_ERROR_TRACE_WRITE             89 // A trace file could not be written
+
 
 namespace GPUDetect
 {
+#ifdef _WIN32
+	class Context;
+#endif
+
 	enum
 	{
 		INTEL_VENDOR_ID = 0x8086,
@@ -105,7 +137,9 @@ namespace GPUDetect
 		 *     Is true if Intel driver extension data is populated.
 		 *     If this value is false, all other extension data will be null.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions. On Linux it is set by the sysfs backend once the adapter-level fields
+		 *     have been read.
 		 *
 		 ******************************************************************************/
 		bool dxAdapterAvailability;
@@ -115,7 +149,8 @@ namespace GPUDetect
 		 *
 		 *     The vendorID of the GPU.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions.
 		 *
 		 ******************************************************************************/
 		unsigned int vendorID;
@@ -125,7 +160,8 @@ namespace GPUDetect
 		 *
 		 *     The DeviceID of the GPU.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions.
 		 *
 		 ******************************************************************************/
 		unsigned int deviceID;
@@ -135,7 +171,12 @@ namespace GPUDetect
 		 *
 		 *     The LUID of the d3d adapter.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     On Linux there is no LUID; the sysfs backend stores the PCI address
+		 *     instead, with the domain in HighPart and bus/device/function packed
+		 *     as (bus << 8) | (device << 3) | function in LowPart.
+		 *
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions.
 		 *
 		 ******************************************************************************/
 		LUID adapterLUID;
@@ -145,7 +186,8 @@ namespace GPUDetect
 		*
 		*     The architecture of the GPU.
 		*
-		*     This value is initialized by the InitExtensionInfo function.
+		*     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		*     functions.
 		*
 		******************************************************************************/
 		INTEL_GPU_ARCHITECTURE architecture;
@@ -163,7 +205,9 @@ namespace GPUDetect
 		 *     dedicated memory size as an indication of UMA GPU capability (either
 		 *     performance, nor memory capacity).
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions. InitAdapterInfo can only guess it from the dedicated memory
+		 *     size; InitExtensionInfo asks the device where the OS supports it.
 		 *
 		 ******************************************************************************/
 		bool isUMAArchitecture;
@@ -173,7 +217,8 @@ namespace GPUDetect
 		 *
 		 *     The amount of Video memory in bytes.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions.
 		 *
 		 ******************************************************************************/
 		uint64_t videoMemory;
@@ -183,10 +228,15 @@ namespace GPUDetect
 		 *
 		 *     The driver-provided description of the GPU.
 		 *
-		 *     This value is initialized by the InitExtensionInfo function.
+		 *     This value is initialized by the InitAdapterInfo and InitExtensionInfo
+		 *     functions.
 		 *
 		 ******************************************************************************/
+#ifdef _WIN32
 		WCHAR description[ _countof( DXGI_ADAPTER_DESC::Description ) ];
+#else
+		WCHAR description[ 128 ];
+#endif
 
 		/*******************************************************************************
 		 * extensionVersion
@@ -361,6 +411,26 @@ namespace GPUDetect
 	 ******************************************************************************/
 	int InitAll( GPUData* const gpuData, int adapterIndex );
 
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitAll
+	 *
+	 *     As above, using the adapter and device owned by context, which creates
+	 *     them on first use. Calls that share a context share the device.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     context
+	 *         The context that owns the adapter and device.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 ******************************************************************************/
+	int InitAll( GPUData* const gpuData, Context* context, int adapterIndex );
+#endif
+
 	/*******************************************************************************
 	 * InitAll
 	 *
@@ -379,12 +449,326 @@ namespace GPUDetect
 	 ******************************************************************************/
 	int InitAll( GPUData* const gpuData, IDXGIAdapter* adapter, ID3D11Device* device );
 
+	/*******************************************************************************
+	 * Timings
+	 *
+	 *     When each stage of a detection started and ended, in nanoseconds of
+	 *     std::chrono::steady_clock. A stage that did not run, for example
+	 *     because its result was cached earlier in the process, has zero start
+	 *     and end times; a stage that ran more than once keeps its last run.
+	 *
+	 *     Stages are only timed for calls that ask for Timings, so the cost of
+	 *     the other calls is one thread-local load per stage. Defining
+	 *     GPUDETECT_DISABLE_TIMINGS when building GPUDetect removes even that;
+	 *     all stages then read as not run.
+	 *
+	 ******************************************************************************/
+	struct Timings
+	{
+		enum Stage
+		{
+			STAGE_INIT_ALL,         // the whole call
+			STAGE_LOAD_LIBRARY,     // LoadLibrary( "dxgi.dll" )
+			STAGE_CREATE_FACTORY,   // CreateDXGIFactory
+			STAGE_ENUM_ADAPTERS,    // IDXGIFactory::EnumAdapters over all adapters
+			STAGE_CREATE_DEVICE,    // D3D11CreateDevice
+			STAGE_EXTENSION_CAPS,   // GetExtensionCaps
+			STAGE_COUNTER_SCAN,     // the search for the Intel Device Information counter
+			STAGE_COUNTER_DATA,     // reading the Intel Device Information counter
+			STAGE_REGISTRY_WALK,    // indexing the DirectX registry keys
+			STAGE_SYSFS_READ,       // reading the DRM sysfs attributes (Linux)
+			STAGE_COUNT
+		};
+
+		struct Interval
+		{
+			int64_t startNs;
+			int64_t endNs;
+		};
+
+		int adapterIndex;
+		Interval stages[ STAGE_COUNT ];
+	};
+
+	/*******************************************************************************
+	 * GetTimingsStageName
+	 *
+	 *     Returns the name of a Timings stage, as used in traces.
+	 *
+	 ******************************************************************************/
+	const char* GetTimingsStageName( Timings::Stage stage );
+
+	/*******************************************************************************
+	 * InitAll
+	 *
+	 *     As InitAll( gpuData, adapterIndex ), also filling timings with when
+	 *     each stage ran. Stages run on other threads are not included.
+	 *
+	 ******************************************************************************/
+	int InitAll( GPUData* const gpuData, int adapterIndex, Timings* const timings );
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitAll
+	 *
+	 *     As InitAll( gpuData, context, adapterIndex ), also filling timings.
+	 *     Stages the context already ran for an earlier call read as not run.
+	 *
+	 ******************************************************************************/
+	int InitAll( GPUData* const gpuData, Context* context, int adapterIndex, Timings* const timings );
+#endif
+
+	/*******************************************************************************
+	 * WriteChromeTrace
+	 *
+	 *     Writes timings as Chrome trace-event JSON, which chrome://tracing and
+	 *     Perfetto can open. Each Timings becomes one thread, named after its
+	 *     adapter, and each stage that ran one complete event. Times are
+	 *     relative to the earliest stage. Returns EXIT_SUCCESS if no error was
+	 *     encountered, otherwise returns an error code.
+	 *
+	 *     timings
+	 *         Array of count Timings, for example one per adapter.
+	 *
+	 *     fileName
+	 *         The file to write.
+	 *
+	 ******************************************************************************/
+	int WriteChromeTrace( const Timings* const timings, size_t count, const char* fileName );
+
+	/*******************************************************************************
+	 * InitAllCached
+	 *
+	 *     Like InitAll, but keeps the results in cacheFileName so that later runs
+	 *     on the same adapter and driver skip device creation and the counter
+	 *     query. Returns the InitAll return code, which is replayed on a cache
+	 *     hit.
+	 *
+	 *     An entry is keyed by vendorID, deviceID, adapterLUID and the raw
+	 *     registry DriverVersion, all read without a device. Adapter LUIDs are
+	 *     only stable until reboot, so the first run after a reboot does the
+	 *     full detection again. On Linux adapterLUID holds the PCI address,
+	 *     which is stable, and the kernel release and the srcversion of the
+	 *     driver's module stand in for the driver version.
+	 *
+	 *     The file is versioned and checksummed; a missing, outdated or corrupt
+	 *     file is treated as a miss and rewritten. Failing to write it is
+	 *     reported on stderr and does not fail detection.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 *     cacheFileName
+	 *         The cache file. It is created if it does not exist.
+	 *
+	 ******************************************************************************/
+	int InitAllCached( GPUData* const gpuData, int adapterIndex, const char* cacheFileName );
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitAllCached
+	 *
+	 *     As above, using the adapter and device owned by context. On a cache
+	 *     hit no device is created.
+	 *
+	 ******************************************************************************/
+	int InitAllCached( GPUData* const gpuData, Context* context, int adapterIndex, const char* cacheFileName );
+#endif
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * Context
+	 *
+	 *     Owns dxgi.dll, the DXGI factory, the enumerated adapters and one D3D11
+	 *     device per adapter, so that several Init* calls for the same adapter
+	 *     share them instead of each creating their own. Everything is created
+	 *     on first use and kept until Reset() or destruction.
+	 *
+	 *     A Context is not thread-safe; use one per thread.
+	 *
+	 ******************************************************************************/
+	class Context
+	{
+	public:
+		Context();
+		~Context();
+
+		/*******************************************************************************
+		 * GetAdapterCount
+		 *
+		 *     Loads DXGI and enumerates the adapters if not done yet, and stores
+		 *     the number of adapters in count. Returns EXIT_SUCCESS if no error
+		 *     was encountered, otherwise returns an error code.
+		 *
+		 ******************************************************************************/
+		int GetAdapterCount( int* count );
+
+		/*******************************************************************************
+		 * GetAdapter
+		 *
+		 *     Points adapter to the adapter at adapterIndex. The context keeps
+		 *     ownership; the pointer is valid until Reset() or destruction.
+		 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns
+		 *     an error code.
+		 *
+		 ******************************************************************************/
+		int GetAdapter( int adapterIndex, IDXGIAdapter** adapter );
+
+		/*******************************************************************************
+		 * GetDevice
+		 *
+		 *     Points device to the D3D11 device of the adapter at adapterIndex,
+		 *     creating it on the first call for that adapter. The context keeps
+		 *     ownership; the pointer is valid until Reset() or destruction.
+		 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns
+		 *     an error code.
+		 *
+		 ******************************************************************************/
+		int GetDevice( int adapterIndex, ID3D11Device** device );
+
+		/*******************************************************************************
+		 * Reset
+		 *
+		 *     Releases all devices, adapters and the factory, and unloads DXGI.
+		 *     The context can be used again afterwards.
+		 *
+		 ******************************************************************************/
+		void Reset();
+
+	private:
+		Context( const Context& ) = delete;
+		Context& operator=( const Context& ) = delete;
+
+		friend int EnumerateAdapters( Context* context, std::vector< GPUData >* gpuData );
+
+		struct Impl;
+		Impl* m_impl;
+	};
+#endif
+
+	/*******************************************************************************
+	 * EnumerateAdapters
+	 *
+	 *     Fills one GPUData per adapter in the system, in enumeration order, with
+	 *     the adapter-level fields: vendorID, deviceID, adapterLUID, description,
+	 *     videoMemory, architecture and a device-less isUMAArchitecture guess.
+	 *     DXGI is loaded and the factory created only once for all adapters, and
+	 *     no device is created. Returns EXIT_SUCCESS if no error was encountered,
+	 *     otherwise returns an error code.
+	 *
+	 *     On Linux the adapters come from the sysfs backend.
+	 *
+	 *     gpuData
+	 *         Receives the adapters. Existing contents are replaced.
+	 *
+	 ******************************************************************************/
+	int EnumerateAdapters( std::vector< GPUData >* gpuData );
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * EnumerateAdapters
+	 *
+	 *     As above, using the DXGI factory and adapters owned by context.
+	 *
+	 ******************************************************************************/
+	int EnumerateAdapters( Context* context, std::vector< GPUData >* gpuData );
+#endif
+
+	/*******************************************************************************
+	 * InitAllAdapters
+	 *
+	 *     Runs InitAll on every adapter in the system, detecting them at the same
+	 *     time on a pool of up to maxThreads threads, so that the total time is
+	 *     close to that of the slowest adapter rather than the sum of all of
+	 *     them. Returns EXIT_SUCCESS if the adapters could be enumerated,
+	 *     otherwise returns an error code.
+	 *
+	 *     gpuData
+	 *         Receives one GPUData per adapter, in enumeration order. Existing
+	 *         contents are replaced.
+	 *
+	 *     returnCodes
+	 *         If not nullptr, receives the InitAll return code of each adapter,
+	 *         in the same order.
+	 *
+	 *     maxThreads
+	 *         The maximum number of threads, including the calling one. 0 uses
+	 *         up to 8, as the threads mostly wait on the driver. No more
+	 *         threads than adapters are used.
+	 *
+	 ******************************************************************************/
+	int InitAllAdapters( std::vector< GPUData >* gpuData, std::vector< int >* returnCodes, unsigned int maxThreads );
+
+	/*******************************************************************************
+	 * InitAdapterInfo
+	 *
+	 *     Loads the adapter-level info (dxAdapterAvailability, vendorID, deviceID,
+	 *     adapterLUID, description, videoMemory, architecture and a device-less
+	 *     isUMAArchitecture guess) without creating a device. Returns
+	 *     EXIT_SUCCESS if no error was encountered, otherwise returns an error code.
+	 *
+	 *     This is enough to identify the adapter and select a preset. Run
+	 *     InitExtensionInfo or InitCounterInfo afterwards, ideally with the same
+	 *     Context, only if the device-level fields are needed.
+	 *
+	 *     On Linux this is the same as InitExtensionInfo.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 ******************************************************************************/
+	int InitAdapterInfo( GPUData* const gpuData, int adapterIndex );
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitAdapterInfo
+	 *
+	 *     As above, using the adapter owned by context. No device is created;
+	 *     a later InitExtensionInfo or InitCounterInfo call with the same
+	 *     context creates it on demand.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     context
+	 *         The context that owns the adapter.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 ******************************************************************************/
+	int InitAdapterInfo( GPUData* const gpuData, Context* context, int adapterIndex );
+#endif
+
+	/*******************************************************************************
+	 * InitAdapterInfo
+	 *
+	 *     As above, from an adapter the caller owns.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     adapter
+	 *         A pointer to the adapter to draw info from.
+	 *
+	 ******************************************************************************/
+	int InitAdapterInfo( GPUData* const gpuData, IDXGIAdapter* adapter );
+
 	/*******************************************************************************
 	 * InitExtensionInfo
 	 *
 	 *     Loads available info from the DX11 extension interface. Returns
 	 *     EXIT_SUCCESS if no error was encountered, otherwise returns an error code.
 	 *
+	 *     On Linux this reads the adapter-level fields from sysfs instead; see
+	 *     InitSysfsInfo.
+	 *
 	 *     gpuData
 	 *         The struct in which the information will be stored.
 	 *
@@ -394,6 +778,26 @@ namespace GPUDetect
 	 ******************************************************************************/
 	int InitExtensionInfo( GPUData* const gpuData, int adapterIndex );
 
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitExtensionInfo
+	 *
+	 *     As above, using the adapter and device owned by context, which creates
+	 *     them on first use. Calls that share a context share the device.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     context
+	 *         The context that owns the adapter and device.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 ******************************************************************************/
+	int InitExtensionInfo( GPUData* const gpuData, Context* context, int adapterIndex );
+#endif
+
 	/*******************************************************************************
 	 * InitExtensionInfo
 	 *
@@ -417,7 +821,8 @@ namespace GPUDetect
 	 *
 	 *     Loads available info from DX11 hardware counters. Returns EXIT_SUCCESS
 	 *     if no error was encountered, otherwise returns an error code. Requires
-	 *     that InitExtensionInfo be run on gpuData before this is called.
+	 *     that InitAdapterInfo or InitExtensionInfo be run on gpuData before this
+	 *     is called.
 	 *
 	 *     gpuData
 	 *         The struct in which the information will be stored.
@@ -428,6 +833,26 @@ namespace GPUDetect
 	 ******************************************************************************/
 	int InitCounterInfo( GPUData* const gpuData, int adapterIndex );
 
+#ifdef _WIN32
+	/*******************************************************************************
+	 * InitCounterInfo
+	 *
+	 *     As above, using the adapter and device owned by context, which creates
+	 *     them on first use. Calls that share a context share the device.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     context
+	 *         The context that owns the adapter and device.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 ******************************************************************************/
+	int InitCounterInfo( GPUData* const gpuData, Context* context, int adapterIndex );
+#endif
+
 	/*******************************************************************************
 	 * InitCounterInfo
 	 *
@@ -436,7 +861,8 @@ namespace GPUDetect
 	 *     available info. It returns EXIT_SUCCESS if no error was encountered,
 	 *     otherwise returns an error code.
 	 *
-	 *      Requires that InitExtensionInfo be run on gpuData before this is called.
+	 *      Requires that InitAdapterInfo or InitExtensionInfo be run on gpuData
+	 *      before this is called.
 	 *
 	 *     gpuData
 	 *         The struct in which the information will be stored.
@@ -458,9 +884,16 @@ namespace GPUDetect
 	 *     have to change it if your game already plays well on the older hardware
 	 *     even at high settings.
 	 *
-	 *     Presets for Intel are expected in a file named "IntelGFX.cfg". This
-	 *     method can also be easily modified to also read similar .cfg files
-	 *     detailing presets for other manufacturers.
+	 *     Presets for Intel come from "IntelGfx.cfg", which GeneratePresetTable.py
+	 *     compiles into a perfect hash table (IntelGfxPresets.h) at build time,
+	 *     so the lookup does no file I/O or parsing. Similar .cfg files for other
+	 *     manufacturers can be passed to the generator as well.
+	 *
+	 *     Devices the .cfg does not list are matched against its rules, which
+	 *     can test the architecture, graphics generation, euCount, maxFrequency,
+	 *     videoMemory and driver version. The rules are compiled in too, in
+	 *     priority order; the first that matches applies, and a listed device
+	 *     never reaches them. Devices that no rule matches get Low.
 	 *
 	 *     gpuData
 	 *         The data for the GPU in question.
@@ -468,13 +901,91 @@ namespace GPUDetect
 	 ******************************************************************************/
 	PresetLevel GetDefaultFidelityPreset( const GPUData* const gpuData );
 
+	/*******************************************************************************
+	 * GetDefaultFidelityPreset
+	 *
+	 *     As above, but entries in the given .cfg file take precedence over the
+	 *     compiled table. Devices the file does not list, or a missing file,
+	 *     fall back to the compiled table and rules. Use this to patch presets
+	 *     in the field without a rebuild. Rules in the file are ignored.
+	 *
+	 *     Each file is read on the first call that passes it and kept in memory
+	 *     for the rest of the process; later lookups against it take no lock,
+	 *     and are safe from any thread. A file that cannot be opened is tried
+	 *     again on the next call.
+	 *
+	 *     The file is memory-mapped and tokenized in place. Malformed lines are
+	 *     reported on stderr with their line number and skipped.
+	 *
+	 *     gpuData
+	 *         The data for the GPU in question.
+	 *
+	 *     overrideCfgFileName
+	 *         Path of the .cfg file to read, or nullptr to use only the compiled
+	 *         table.
+	 *
+	 ******************************************************************************/
+	PresetLevel GetDefaultFidelityPreset( const GPUData* const gpuData, const char* overrideCfgFileName );
+
+	/*******************************************************************************
+	 * DeviceKey
+	 *
+	 *     A (vendorID, deviceID) pair, for resolving presets of devices that
+	 *     are not described by a full GPUData.
+	 *
+	 ******************************************************************************/
+	struct DeviceKey
+	{
+		unsigned int vendorID;
+		unsigned int deviceID;
+	};
+
+	/*******************************************************************************
+	 * GetDefaultFidelityPresets
+	 *
+	 *     Batch form of GetDefaultFidelityPreset. outPresets[ i ] receives the
+	 *     preset for gpuData[ i ], exactly as if GetDefaultFidelityPreset had
+	 *     been called for it. The override file, if any, is indexed once for
+	 *     the whole batch, and large batches are split across worker threads.
+	 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns an
+	 *     error code.
+	 *
+	 *     gpuData
+	 *         Array of count records to resolve.
+	 *
+	 *     count
+	 *         Number of records.
+	 *
+	 *     outPresets
+	 *         Array of count presets to fill.
+	 *
+	 *     overrideCfgFileName
+	 *         Path of a .cfg file whose entries take precedence over the
+	 *         compiled table, or nullptr.
+	 *
+	 ******************************************************************************/
+	int GetDefaultFidelityPresets( const GPUData* const gpuData, size_t count, PresetLevel* const outPresets, const char* overrideCfgFileName );
+
+	/*******************************************************************************
+	 * GetDefaultFidelityPresets
+	 *
+	 *     As above, for bare (vendorID, deviceID) pairs. Every pair is treated
+	 *     as a valid adapter.
+	 *
+	 ******************************************************************************/
+	int GetDefaultFidelityPresets( const DeviceKey* const devices, size_t count, PresetLevel* const outPresets, const char* overrideCfgFileName );
+
 	/*******************************************************************************
 	 * InitDxDriverVersion
 	 *
 	 *     Loads the DX driver version for the given adapter from the windows
 	 *     registry. Returns EXIT_SUCCESS if no error was encountered, otherwise
-	 *     returns an error code. Requires that InitExtensionInfo be run on gpuData
-	 *     before this is called.
+	 *     returns an error code. Requires that InitAdapterInfo or InitExtensionInfo
+	 *     be run on gpuData before this is called.
+	 *
+	 *     The registry is scanned once per process into an index of all
+	 *     adapters, which later calls reuse. It is rescanned once if an adapter
+	 *     is missing from it.
 	 *
 	 *     gpuData
 	 *         The struct in which the information will be stored.
@@ -500,27 +1011,217 @@ namespace GPUDetect
 	void GetDriverVersionAsCString( const GPUData* const gpuData, char* const outBuffer, size_t outBufferSize );
 
 	/*******************************************************************************
-	 * GetIntelGraphicsGeneration
-	 *
-	 *     Returns the generation of Intel(tm) Graphics, given the architecture.
+	 * LazyGPUData
 	 *
-	 *     architecture
-	 *         The architecture to identify.
+	 *     A view of the GPUData of one adapter that loads each group of fields
+	 *     the first time one of them is read, and keeps the result. Fields
+	 *     that are never read are never loaded, and each stage runs at most
+	 *     once, in the order its dependencies require:
 	 *
-	 ******************************************************************************/
-	IntelGraphicsGeneration GetIntelGraphicsGeneration( INTEL_GPU_ARCHITECTURE architecture );
-
-	/*******************************************************************************
-	 * GetIntelGraphicsGenerationString
+	 *         STAGE_ADAPTER         InitAdapterInfo, no device needed
+	 *         STAGE_EXTENSION       InitExtensionInfo, creates the device
+	 *         STAGE_COUNTER         InitCounterInfo, after STAGE_EXTENSION
+	 *         STAGE_DRIVER_VERSION  InitDxDriverVersion, reads the registry
 	 *
-	 *     Returns the generation of Intel(tm) Graphics, given the architecture.
+	 *     If a stage fails, the fields it loads read as zero; Load() returns
+	 *     the error. On Linux the counter and driver version stages are not
+	 *     supported.
 	 *
-	 *     generation
-	 *         The generation to identify.
+	 *     Like Context, a LazyGPUData is not thread-safe.
 	 *
 	 ******************************************************************************/
-	const char * GetIntelGraphicsGenerationString( const IntelGraphicsGeneration genneration );
-
+	class LazyGPUData
+	{
+	public:
+		enum Stage
+		{
+			STAGE_ADAPTER,
+			STAGE_EXTENSION,
+			STAGE_COUNTER,
+			STAGE_DRIVER_VERSION,
+			STAGE_COUNT
+		};
+
+#ifdef _WIN32
+		/*******************************************************************************
+		 * LazyGPUData
+		 *
+		 *     adapterIndex
+		 *         The index of the adapter to get the information from.
+		 *
+		 *     context
+		 *         The context that owns the adapter and device. Must outlive
+		 *         this object. If nullptr, the view owns a context of its own.
+		 *
+		 ******************************************************************************/
+		explicit LazyGPUData( int adapterIndex, Context* context = nullptr );
+#else
+		explicit LazyGPUData( int adapterIndex );
+#endif
+
+		/*******************************************************************************
+		 * Load
+		 *
+		 *     Runs stage, and the stages it depends on, unless already run.
+		 *     Returns the return code of the Init* function of the stage, which
+		 *     is EXIT_SUCCESS if no error was encountered.
+		 *
+		 ******************************************************************************/
+		int Load( Stage stage );
+
+		/*******************************************************************************
+		 * GetData
+		 *
+		 *     Returns the fields loaded so far, without loading anything.
+		 *
+		 ******************************************************************************/
+		const GPUData& GetData() const;
+
+		// STAGE_ADAPTER
+		bool dxAdapterAvailability();
+		unsigned int vendorID();
+		unsigned int deviceID();
+		LUID adapterLUID();
+		INTEL_GPU_ARCHITECTURE architecture();
+		const WCHAR* description();
+
+		// STAGE_EXTENSION, which refines the device-less UMA guess
+		bool isUMAArchitecture();
+		uint64_t videoMemory();
+		unsigned int extensionVersion();
+		bool intelExtensionAvailability();
+
+		// STAGE_COUNTER
+		bool counterAvailability();
+		unsigned int maxFrequency();
+		unsigned int minFrequency();
+		bool advancedCounterDataAvailability();
+		unsigned int euCount();
+		unsigned int packageTDP();
+		unsigned int maxFillRate();
+
+		// STAGE_DRIVER_VERSION
+		const unsigned int* dxDriverVersion();
+		bool d3dRegistryDataAvailability();
+		const GPUData::DriverVersionInfo& driverInfo();
+
+	private:
+		LazyGPUData( const LazyGPUData& ) = delete;
+		LazyGPUData& operator=( const LazyGPUData& ) = delete;
+
+		int RunStage( Stage stage );
+
+		GPUData m_data;
+		int m_adapterIndex;
+		bool m_loaded[ STAGE_COUNT ];
+		int m_returnCode[ STAGE_COUNT ];
+
+#ifdef _WIN32
+		Context m_ownContext;
+		Context* m_context;
+#endif
+	};
+
+	/*******************************************************************************
+	 * AsyncGPUData
+	 *
+	 *     Detects one adapter on a background thread, so the application can
+	 *     keep loading while the driver is queried. The stages of LazyGPUData
+	 *     run in order, and the fields of each stage are published as soon as
+	 *     it completes: the adapter identity is available long before the
+	 *     device, counter and registry stages are done.
+	 *
+	 *     Wait and TryGet may be called from any thread.
+	 *
+	 ******************************************************************************/
+	class AsyncGPUData
+	{
+	public:
+		/*******************************************************************************
+		 * StageCallback
+		 *
+		 *     Called on the detection thread after each stage, with its return
+		 *     code and all the fields published so far. It must not destroy the
+		 *     AsyncGPUData.
+		 *
+		 ******************************************************************************/
+		typedef void ( *StageCallback )( LazyGPUData::Stage stage, int returnCode, const GPUData& gpuData, void* userData );
+
+		/*******************************************************************************
+		 * AsyncGPUData
+		 *
+		 *     Starts the detection thread.
+		 *
+		 *     adapterIndex
+		 *         The index of the adapter to get the information from.
+		 *
+		 *     callback
+		 *         If not nullptr, called after each stage.
+		 *
+		 *     userData
+		 *         Passed to callback.
+		 *
+		 ******************************************************************************/
+		explicit AsyncGPUData( int adapterIndex, StageCallback callback = nullptr, void* userData = nullptr );
+
+		/*******************************************************************************
+		 * ~AsyncGPUData
+		 *
+		 *     Skips the stages that have not started and waits for the one in
+		 *     progress.
+		 *
+		 ******************************************************************************/
+		~AsyncGPUData();
+
+		/*******************************************************************************
+		 * Wait
+		 *
+		 *     Blocks until stage has completed, then copies all the fields
+		 *     published so far into gpuData. Returns the return code of the
+		 *     stage.
+		 *
+		 ******************************************************************************/
+		int Wait( LazyGPUData::Stage stage, GPUData* const gpuData );
+
+		/*******************************************************************************
+		 * TryGet
+		 *
+		 *     As Wait, but returns false without blocking if stage has not
+		 *     completed yet.
+		 *
+		 ******************************************************************************/
+		bool TryGet( LazyGPUData::Stage stage, GPUData* const gpuData, int* returnCode );
+
+	private:
+		AsyncGPUData( const AsyncGPUData& ) = delete;
+		AsyncGPUData& operator=( const AsyncGPUData& ) = delete;
+
+		struct Impl;
+		Impl* m_impl;
+	};
+
+	/*******************************************************************************
+	 * GetIntelGraphicsGeneration
+	 *
+	 *     Returns the generation of Intel(tm) Graphics, given the architecture.
+	 *
+	 *     architecture
+	 *         The architecture to identify.
+	 *
+	 ******************************************************************************/
+	IntelGraphicsGeneration GetIntelGraphicsGeneration( INTEL_GPU_ARCHITECTURE architecture );
+
+	/*******************************************************************************
+	 * GetIntelGraphicsGenerationString
+	 *
+	 *     Returns the generation of Intel(tm) Graphics, given the architecture.
+	 *
+	 *     generation
+	 *         The generation to identify.
+	 *
+	 ******************************************************************************/
+	const char * GetIntelGraphicsGenerationString( const IntelGraphicsGeneration genneration );
+
 	/*******************************************************************************
 	 * InitAdapter
 	 *
@@ -554,4 +1255,588 @@ namespace GPUDetect
 	 ******************************************************************************/
 	int InitDevice( IDXGIAdapter* adapter, ID3D11Device** device );
 
+#ifdef __linux__
+	/*******************************************************************************
+	 * InitSysfsInfo
+	 *
+	 *     Loads the adapter-level info (vendorID, deviceID, adapterLUID,
+	 *     description, videoMemory and isUMAArchitecture) from the Linux DRM
+	 *     sysfs interface. No graphics API device is created. Returns
+	 *     EXIT_SUCCESS if no error was encountered, otherwise returns an error
+	 *     code.
+	 *
+	 *     Adapters are the class/drm/cardN entries that have a render node,
+	 *     ordered by N.
+	 *
+	 *     gpuData
+	 *         The struct in which the information will be stored.
+	 *
+	 *     adapterIndex
+	 *         The index of the adapter to get the information from.
+	 *
+	 *     sysfsRoot
+	 *         The directory sysfs is mounted on, normally "/sys". Point this at
+	 *         a fake directory tree to test without real hardware.
+	 *
+	 ******************************************************************************/
+	int InitSysfsInfo( GPUData* const gpuData, int adapterIndex, const char* sysfsRoot );
+
+	/*******************************************************************************
+	 * FrequencyStats
+	 *
+	 *     What a FrequencySampler has seen. "cur" is the frequency the driver
+	 *     requested, "act" the one the GPU actually ran at, both in MHz.
+	 *
+	 ******************************************************************************/
+	struct FrequencyStats
+	{
+		enum
+		{
+			HISTOGRAM_BUCKET_MHZ = 50,
+			HISTOGRAM_BUCKET_COUNT = 64,  // the last bucket also holds higher frequencies
+		};
+
+		uint64_t sampleCount;             // since Open or Reset
+
+		unsigned int lastCurMHz;
+		unsigned int lastActMHz;
+
+		// Over the last windowSampleCount samples
+		unsigned int windowSampleCount;
+		unsigned int curMinMHz;
+		unsigned int curAvgMHz;
+		unsigned int curMaxMHz;
+		unsigned int actMinMHz;
+		unsigned int actAvgMHz;
+		unsigned int actMaxMHz;
+
+		// Time spent at each actual frequency since Open or Reset, bucket i
+		// covering [ i * HISTOGRAM_BUCKET_MHZ, ( i + 1 ) * HISTOGRAM_BUCKET_MHZ )
+		uint64_t timeAtFrequencyUs[ HISTOGRAM_BUCKET_COUNT ];
+	};
+
+	/*******************************************************************************
+	 * FrequencySampler
+	 *
+	 *     Samples the current and actual frequency of an Intel GPU, from
+	 *     gt_cur_freq_mhz and gt_act_freq_mhz with i915, or from
+	 *     tile0/gt0/freq0/cur_freq and act_freq with xe. The files are opened
+	 *     once and re-read in place, so a sample costs two small reads and
+	 *     no allocation.
+	 *
+	 *         FrequencySampler sampler;
+	 *         sampler.Open( 0, "/sys" );
+	 *         sampler.Start( 100 );
+	 *         ...
+	 *         FrequencyStats stats;
+	 *         sampler.GetStats( &stats );
+	 *
+	 *     GetStats and Reset are safe to call while the sampler thread runs.
+	 *
+	 ******************************************************************************/
+	class FrequencySampler
+	{
+	public:
+		// windowSize is the number of samples of the rolling min, avg and max
+		explicit FrequencySampler( unsigned int windowSize = 64 );
+
+		// Stops the sampler thread and closes the files
+		~FrequencySampler();
+
+		/*******************************************************************************
+		 * Open
+		 *
+		 *     Finds the frequency files of an adapter, indexed as by
+		 *     InitSysfsInfo, and resets the statistics. Returns EXIT_SUCCESS,
+		 *     GPUDETECT_ERROR_NOT_SUPPORTED if the adapter's driver exposes no
+		 *     frequencies, GPUDETECT_ERROR_SYSFS_READ if a path is too long, or
+		 *     another error code.
+		 *
+		 *     sysfsRoot
+		 *         As for InitSysfsInfo.
+		 *
+		 ******************************************************************************/
+		int Open( int adapterIndex, const char* sysfsRoot );
+
+		/*******************************************************************************
+		 * Sample
+		 *
+		 *     Takes one sample on the calling thread. Returns EXIT_SUCCESS if no
+		 *     error was encountered, otherwise returns an error code.
+		 *
+		 ******************************************************************************/
+		int Sample();
+
+		/*******************************************************************************
+		 * Start, Stop
+		 *
+		 *     Start samples every intervalMs milliseconds on a thread of its own
+		 *     until Stop is called. Returns EXIT_SUCCESS if the thread was
+		 *     started, or GPUDETECT_ERROR_BAD_DATA if the sampler is not open,
+		 *     is already running, or intervalMs is 0.
+		 *
+		 ******************************************************************************/
+		int Start( unsigned int intervalMs );
+		void Stop();
+
+		void GetStats( FrequencyStats* const stats ) const;
+		void Reset();
+
+	private:
+		FrequencySampler( const FrequencySampler& ) = delete;
+		FrequencySampler& operator=( const FrequencySampler& ) = delete;
+
+		struct Impl;
+		Impl* m_impl;
+	};
+
+	/*******************************************************************************
+	 * PowerStats
+	 *
+	 *     What a PowerSampler has measured. Energy counter wraparound has
+	 *     already been accounted for.
+	 *
+	 ******************************************************************************/
+	struct PowerStats
+	{
+		enum Source
+		{
+			SOURCE_NONE,
+			SOURCE_HWMON,          // the card's own energy counter, on discrete GPUs
+			SOURCE_RAPL_PACKAGE,   // the CPU package, which contains integrated GPUs
+		};
+
+		Source source;
+
+		uint64_t sampleCount;      // since Open or Reset
+		uint64_t totalEnergyUj;    // since Open or Reset
+
+		// Over the last windowUs microseconds, which is shorter than the
+		// sampler's window until enough samples have been taken
+		uint64_t windowUs;
+		float averageWatts;
+
+		// averageWatts / packageTDP, or 0 if packageTDP is not known
+		float fractionOfTDP;
+	};
+
+	/*******************************************************************************
+	 * PowerSampler
+	 *
+	 *     Measures the power an adapter draws, from the energy*_input counter
+	 *     of the card's hwmon device where the driver exposes one (i915 and xe
+	 *     on discrete GPUs), otherwise from the intel-rapl package counter in
+	 *     powercap. Like FrequencySampler, the counter is opened once and
+	 *     re-read in place, and GetStats and Reset are safe to call while the
+	 *     sampler thread runs.
+	 *
+	 *     RAPL counters are only readable by root on most distributions; Open
+	 *     returns GPUDETECT_ERROR_SYSFS_READ in that case.
+	 *
+	 ******************************************************************************/
+	class PowerSampler
+	{
+	public:
+		// windowMs is the span averageWatts is taken over
+		explicit PowerSampler( unsigned int windowMs = 1000 );
+
+		// Stops the sampler thread and closes the counter
+		~PowerSampler();
+
+		/*******************************************************************************
+		 * Open
+		 *
+		 *     Finds the energy counter of an adapter, indexed as by
+		 *     InitSysfsInfo, and resets the statistics. Returns EXIT_SUCCESS,
+		 *     GPUDETECT_ERROR_NOT_SUPPORTED if no counter exists, or another
+		 *     error code.
+		 *
+		 *     sysfsRoot
+		 *         As for InitSysfsInfo. powercap is looked up under
+		 *         sysfsRoot/class/powercap.
+		 *
+		 *     packageTDP
+		 *         GPUData::packageTDP in watts, or 0 if it is not known.
+		 *
+		 ******************************************************************************/
+		int Open( int adapterIndex, const char* sysfsRoot, unsigned int packageTDP );
+
+		/*******************************************************************************
+		 * Sample, Start, Stop, GetStats, Reset
+		 *
+		 *     As for FrequencySampler. Power is only known once two samples
+		 *     have been taken.
+		 *
+		 ******************************************************************************/
+		int Sample();
+		int Start( unsigned int intervalMs );
+		void Stop();
+
+		void GetStats( PowerStats* const stats ) const;
+		void Reset();
+
+	private:
+		PowerSampler( const PowerSampler& ) = delete;
+		PowerSampler& operator=( const PowerSampler& ) = delete;
+
+		struct Impl;
+		Impl* m_impl;
+	};
+#endif
+
+	/*******************************************************************************
+	 * MemoryRegion
+	 *
+	 *     One memory region of an adapter, as reported by QueryMemoryBudget.
+	 *
+	 ******************************************************************************/
+	struct MemoryRegion
+	{
+		enum Type
+		{
+			REGION_LOCAL,    // memory on the card of a discrete GPU
+			REGION_SYSTEM,   // system memory the GPU can use
+		};
+
+		Type type;
+		unsigned int instance;   // the tile on multi-tile GPUs, otherwise 0
+
+		// On Windows this is the budget the OS grants the process, which is
+		// less than the physical size of the region
+		uint64_t totalBytes;
+
+		// Only valid if usageAvailability is true; some drivers only report
+		// the size of the region
+		bool usageAvailability;
+		uint64_t usedBytes;
+		uint64_t availableBytes;
+	};
+
+	struct MemoryBudget
+	{
+		enum
+		{
+			MAX_REGIONS = 4,
+		};
+
+		unsigned int regionCount;
+		MemoryRegion regions[ MAX_REGIONS ];
+	};
+
+	/*******************************************************************************
+	 * QueryMemoryBudget
+	 *
+	 *     Gets the current size, usage and availability of each memory region
+	 *     of an adapter. This is cheap enough to call every frame.
+	 *
+	 *     On Windows the local and system segment groups are read through
+	 *     IDXGIAdapter3::QueryVideoMemoryInfo, from the point of view of the
+	 *     calling process.
+	 *
+	 *     On Linux the local memory regions are read from sysfs, from
+	 *     lmem_total_bytes and lmem_avail_bytes with i915, or from
+	 *     device/tileN/physical_vram_size_bytes with xe. xe has no usage in
+	 *     sysfs, so it is read from the memory region query of the render
+	 *     node, which only reports it to processes with CAP_PERFMON; without
+	 *     it, and for a sysfsRoot other than "/sys", usageAvailability stays
+	 *     false on xe. Returns GPUDETECT_ERROR_NOT_SUPPORTED for adapters
+	 *     without local memory, or GPUDETECT_ERROR_SYSFS_READ if a path is
+	 *     too long.
+	 *
+	 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns
+	 *     an error code.
+	 *
+	 ******************************************************************************/
+#ifdef _WIN32
+	int QueryMemoryBudget( IDXGIAdapter* adapter, MemoryBudget* const budget );
+#endif
+#ifdef __linux__
+	int QueryMemoryBudget( int adapterIndex, const char* sysfsRoot, MemoryBudget* const budget );
+#endif
+
+	/*******************************************************************************
+	 * MemoryBudgetMonitor
+	 *
+	 *     Tells the caller when the usage of a memory region crosses one of a
+	 *     set of thresholds, given as fractions of the region's totalBytes.
+	 *     Pass each new MemoryBudget to Update; the callback is called once
+	 *     for every threshold crossed since the previous Update, in the order
+	 *     they were crossed.
+	 *
+	 *         const float thresholds[] = { 0.8f, 0.9f };
+	 *         MemoryBudgetMonitor monitor( OnMemoryThreshold, streamer );
+	 *         monitor.SetThresholds( thresholds, 2 );
+	 *         ...
+	 *         QueryMemoryBudget( adapter, &budget );
+	 *         monitor.Update( budget );
+	 *
+	 ******************************************************************************/
+	class MemoryBudgetMonitor
+	{
+	public:
+		enum
+		{
+			MAX_THRESHOLDS = 8,
+		};
+
+		struct Event
+		{
+			unsigned int regionIndex;    // into MemoryBudget::regions
+			const MemoryRegion* region;
+			float threshold;
+			bool rising;                 // true if usage went above the threshold
+		};
+
+		typedef void ( *Callback )( const Event& event, void* context );
+
+		MemoryBudgetMonitor( Callback callback, void* context );
+
+		/*******************************************************************************
+		 * SetThresholds
+		 *
+		 *     Replaces the thresholds, which must be in ascending order and in
+		 *     (0, 1]. Usage is then taken to be below all of them until the next
+		 *     Update. Returns EXIT_SUCCESS, or GPUDETECT_ERROR_BAD_DATA if the
+		 *     thresholds are not valid.
+		 *
+		 ******************************************************************************/
+		int SetThresholds( const float* thresholds, unsigned int thresholdCount );
+
+		void Update( const MemoryBudget& budget );
+
+	private:
+		Callback m_callback;
+		void* m_context;
+
+		float m_thresholds[ MAX_THRESHOLDS ];
+		unsigned int m_thresholdCount;
+
+		// The number of thresholds each region's usage is at or above
+		unsigned int m_levels[ MemoryBudget::MAX_REGIONS ];
+	};
+
+	/*******************************************************************************
+	 * UploadPath
+	 *
+	 *     How the CPU should get data into a GPU resource.
+	 *
+	 ******************************************************************************/
+	enum UploadPath
+	{
+		// Map the resource and write into it. On UMA GPUs the resource is in
+		// system memory, so this is the only copy.
+		UPLOAD_DIRECT_WRITE,
+
+		// Map the texture with RESOURCE_EXTENSION_DIRECT_ACCESS from
+		// ID3D10Extensions.h, and write its texels in place
+		UPLOAD_DIRECT_ACCESS,
+
+		// Write through the CPU-visible BAR into local memory. Keep writes
+		// sequential and never read back; the writes cross PCIe.
+		UPLOAD_BAR_WRITE,
+
+		// Write into a staging resource in system memory, and let the copy
+		// engine move it into local memory
+		UPLOAD_STAGING_COPY,
+	};
+
+	enum UploadResourceClass
+	{
+		UPLOAD_CLASS_CONSTANT_BUFFER,   // rewritten every frame or draw
+		UPLOAD_CLASS_DYNAMIC_BUFFER,    // vertex or index data rewritten every frame
+		UPLOAD_CLASS_STATIC_BUFFER,     // written once, read by the GPU many times
+		UPLOAD_CLASS_TEXTURE,
+		UPLOAD_CLASS_COUNT,
+	};
+
+	struct UploadAdvice
+	{
+		UploadPath path;
+
+		// Of each upload's offset in the buffer the CPU writes into
+		unsigned int alignment;
+	};
+
+	/*******************************************************************************
+	 * GetUploadAdvice
+	 *
+	 *     Recommends an upload path and alignment for a class of resource,
+	 *     from isUMAArchitecture, intelExtensionAvailability and how much
+	 *     local memory the CPU can see. The answer depends on nothing else,
+	 *     so it can be computed once per adapter.
+	 *
+	 *     gpuData
+	 *         Initialized by InitAdapterInfo or InitSysfsInfo at least.
+	 *         intelExtensionAvailability is only used if InitExtensionInfo was
+	 *         called.
+	 *
+	 *     cpuVisibleLocalMemory
+	 *         The size of the BAR through which the CPU sees a discrete GPU's
+	 *         local memory, from GetCpuVisibleLocalMemory, or 0 if it is not
+	 *         known. With resizable BAR it covers all of videoMemory.
+	 *
+	 *     Returns EXIT_SUCCESS, or GPUDETECT_ERROR_BAD_DATA if an argument is
+	 *     not valid.
+	 *
+	 ******************************************************************************/
+	int GetUploadAdvice( const GPUData* const gpuData, uint64_t cpuVisibleLocalMemory, UploadResourceClass resourceClass, UploadAdvice* const advice );
+
+	const char* GetUploadPathName( UploadPath path );
+
+	enum MemoryBandwidthClass
+	{
+		BANDWIDTH_LOW,         // below 50 GB/s, older shared memory
+		BANDWIDTH_MEDIUM,      // below 150 GB/s, newer shared memory and entry discrete GPUs
+		BANDWIDTH_HIGH,        // below 400 GB/s
+		BANDWIDTH_VERY_HIGH,
+	};
+
+	/*******************************************************************************
+	 * ThroughputScore
+	 *
+	 *     Estimated peak throughput of a GPU. These are paper numbers from the
+	 *     width of the hardware and its clock, for comparing GPUs and scaling
+	 *     budgets, not measurements.
+	 *
+	 ******************************************************************************/
+	struct ThroughputScore
+	{
+		float fp32Gflops;
+		float texelRateGtexels;   // billion bilinear texels per second
+		float pixelRateGpixels;   // billion pixels per second
+		float bandwidthGBs;       // memory bandwidth in GB/s
+		MemoryBandwidthClass bandwidthClass;
+
+		// Weighted geometric mean of the above relative to a 24 EU Gen9 GPU at
+		// 1050 MHz (Intel HD Graphics 620), which scores 1. Twice the
+		// throughput in every respect scores 2.
+		float score;
+
+		// True if euCount, maxFrequency or maxFillRate were not reported, and
+		// typical values for the architecture were used instead
+		bool estimated;
+	};
+
+	/*******************************************************************************
+	 * GetThroughputScore
+	 *
+	 *     Estimates the throughput of a GPU from euCount, maxFrequency,
+	 *     maxFillRate, its graphics generation and whether it is UMA. Where
+	 *     advancedCounterDataAvailability is false, or a counter is missing,
+	 *     typical values for the architecture stand in for the counters.
+	 *     Returns EXIT_SUCCESS, GPUDETECT_ERROR_NOT_SUPPORTED if the GPU has
+	 *     neither counter data nor a known architecture, or
+	 *     GPUDETECT_ERROR_BAD_DATA if an argument is not valid.
+	 *
+	 *     gpuData
+	 *         Initialized by InitAdapterInfo or InitSysfsInfo at least, and
+	 *         by InitCounterInfo for figures of the actual SKU.
+	 *
+	 ******************************************************************************/
+	int GetThroughputScore( const GPUData* const gpuData, ThroughputScore* const score );
+
+	/*******************************************************************************
+	 * CPUData
+	 *
+	 *     The capabilities of the CPU the GPU shares power and memory with on
+	 *     integrated parts.
+	 *
+	 ******************************************************************************/
+	struct CPUData
+	{
+		enum SimdFeature
+		{
+			SIMD_SSE4_2      = 0x01,
+			SIMD_AVX         = 0x02,
+			SIMD_AVX2        = 0x04,
+			SIMD_FMA         = 0x08,
+			SIMD_AVX512      = 0x10,   // AVX-512 F, CD, BW, DQ and VL, as on all Intel parts with AVX-512
+			SIMD_AVX512_VNNI = 0x20,
+			SIMD_AVX_VNNI    = 0x40,   // the VEX encoded VNNI of parts without AVX-512
+		};
+
+		char vendor[ 13 ];             // "GenuineIntel", "AuthenticAMD", or empty
+
+		unsigned int logicalCoreCount;
+		unsigned int physicalCoreCount;
+
+		// SimdFeature flags that both the CPU and the OS support
+		uint32_t simdFeatures;
+
+		// As seen by the first logical processor; on hybrid parts the
+		// other cores' L1 and L2 can differ. 0 if not known.
+		unsigned int l1DataCacheKB;
+		unsigned int l2CacheKB;
+		unsigned int l3CacheKB;
+	};
+
+	/*******************************************************************************
+	 * InitCPUData
+	 *
+	 *     Fills cpuData from CPUID, and the core counts and caches from the OS:
+	 *     GetLogicalProcessorInformationEx on Windows, /sys/devices/system/cpu
+	 *     on Linux. Returns EXIT_SUCCESS if no error was encountered, otherwise
+	 *     returns an error code.
+	 *
+	 ******************************************************************************/
+	int InitCPUData( CPUData* const cpuData );
+
+#ifdef __linux__
+	/*******************************************************************************
+	 * InitCPUSysfsInfo
+	 *
+	 *     Fills the core counts and cache sizes of cpuData from
+	 *     sysfsRoot/devices/system/cpu, and leaves the rest as it is. Point
+	 *     sysfsRoot at a fake directory tree to test without the real CPU.
+	 *     Returns EXIT_SUCCESS, GPUDETECT_ERROR_SYSFS_READ if no CPU was
+	 *     found or a path is too long, or GPUDETECT_ERROR_BAD_DATA if an
+	 *     argument is not valid.
+	 *
+	 ******************************************************************************/
+	int InitCPUSysfsInfo( CPUData* const cpuData, const char* sysfsRoot );
+#endif
+
+	enum SimdTier
+	{
+		SIMD_TIER_SCALAR,
+		SIMD_TIER_SSE4_2,
+		SIMD_TIER_AVX2,     // AVX2 and FMA
+		SIMD_TIER_AVX512,
+	};
+
+	/*******************************************************************************
+	 * GetSimdTier
+	 *
+	 *     Returns the widest code path cpuData can run, for picking between
+	 *     code paths at runtime.
+	 *
+	 ******************************************************************************/
+	SimdTier GetSimdTier( const CPUData* const cpuData );
+
+	const char* GetSimdTierName( SimdTier tier );
+
+	/*******************************************************************************
+	 * GetCpuVisibleLocalMemory
+	 *
+	 *     Stores how much of an adapter's local memory the CPU can see, in
+	 *     bytes, for GetUploadAdvice. Returns EXIT_SUCCESS if no error was
+	 *     encountered, otherwise returns an error code.
+	 *
+	 *     On Windows this is all of DedicatedVideoMemory if D3D12 supports GPU
+	 *     upload heaps on the adapter, which it only does with resizable BAR,
+	 *     and 0 otherwise, as the size of a small BAR is not reported. It
+	 *     creates a D3D12 device, so call it once per adapter. Returns
+	 *     GPUDETECT_ERROR_NOT_SUPPORTED if D3D12 is not available.
+	 *
+	 *     On Linux this is the size of the largest memory BAR of the adapter,
+	 *     indexed as by InitSysfsInfo.
+	 *
+	 ******************************************************************************/
+#ifdef _WIN32
+	int GetCpuVisibleLocalMemory( IDXGIAdapter* adapter, uint64_t* bytes );
+#endif
+#ifdef __linux__
+	int GetCpuVisibleLocalMemory( int adapterIndex, const char* sysfsRoot, uint64_t* bytes );
+#endif
+
 }
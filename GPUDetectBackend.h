@@ -0,0 +1,658 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "GPUDetect.h"
+
+
+//
+// Interfaces between the GPUDetect logic and the platform it queries. The
+// DXGI implementations live in GPUDetect.cpp; other implementations (mocks,
+// recordings) can be passed in to run the same logic without a GPU.
+//
+namespace GPUDetect
+{
+	/*******************************************************************************
+	 * AdapterDesc
+	 *
+	 *     The adapter-level description reported by the platform, before
+	 *     GPUDetect interprets it. Mirrors the DXGI_ADAPTER_DESC fields used.
+	 *
+	 ******************************************************************************/
+	struct AdapterDesc
+	{
+		unsigned int vendorID;
+		unsigned int deviceID;
+		LUID adapterLUID;
+		WCHAR description[ sizeof( GPUData::description ) / sizeof( WCHAR ) ];
+		uint64_t dedicatedVideoMemory;
+		uint64_t sharedSystemMemory;
+	};
+
+	/*******************************************************************************
+	 * IAdapterSource
+	 *
+	 *     Enumerates the adapters of a system.
+	 *
+	 ******************************************************************************/
+	class IAdapterSource
+	{
+	public:
+		virtual ~IAdapterSource() {}
+
+		/*******************************************************************************
+		 * GetAdapterCount
+		 *
+		 *     Returns the number of adapters, which are indexed from 0.
+		 *
+		 ******************************************************************************/
+		virtual int GetAdapterCount() = 0;
+
+		/*******************************************************************************
+		 * GetAdapterDesc
+		 *
+		 *     Fills desc for the adapter at adapterIndex. Returns EXIT_SUCCESS if
+		 *     no error was encountered, otherwise returns an error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) = 0;
+	};
+
+	/*******************************************************************************
+	 * IAdapterDetector
+	 *
+	 *     Runs the full detection of one adapter. InitAll is called from several
+	 *     threads at once, each time for a different adapter, and must be safe
+	 *     to call that way.
+	 *
+	 ******************************************************************************/
+	class IAdapterDetector
+	{
+	public:
+		virtual ~IAdapterDetector() {}
+
+		/*******************************************************************************
+		 * GetAdapterCount
+		 *
+		 *     Stores the number of adapters, which are indexed from 0, in count.
+		 *     Called once, before any InitAll call. Returns EXIT_SUCCESS if no
+		 *     error was encountered, otherwise returns an error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetAdapterCount( int* count ) = 0;
+
+		/*******************************************************************************
+		 * InitAll
+		 *
+		 *     Fills gpuData for the adapter at adapterIndex, like
+		 *     GPUDetect::InitAll.
+		 *
+		 ******************************************************************************/
+		virtual int InitAll( GPUData* const gpuData, int adapterIndex ) = 0;
+	};
+
+	/*******************************************************************************
+	 * InitAllAdapters
+	 *
+	 *     Detects every adapter of detector on up to maxThreads threads,
+	 *     including the calling one. See GPUDetect::InitAllAdapters.
+	 *
+	 ******************************************************************************/
+	int InitAllAdapters( IAdapterDetector* detector, std::vector< GPUData >* gpuData, std::vector< int >* returnCodes, unsigned int maxThreads );
+
+	/*******************************************************************************
+	 * ICounterSource
+	 *
+	 *     The device-dependent performance counters of a device, indexed from 0
+	 *     (D3D11_COUNTER_DEVICE_DEPENDENT_0 in D3D11).
+	 *
+	 ******************************************************************************/
+	class ICounterSource
+	{
+	public:
+		virtual ~ICounterSource() {}
+
+		/*******************************************************************************
+		 * GetCounterCount
+		 *
+		 *     Returns the number of device-dependent counters.
+		 *
+		 ******************************************************************************/
+		virtual int GetCounterCount() = 0;
+
+		/*******************************************************************************
+		 * CheckCounter
+		 *
+		 *     Copies the null-terminated name and description of the counter at
+		 *     counterIndex into the given buffers, like ID3D11Device::CheckCounter:
+		 *     the lengths are the buffer sizes on input and the string sizes,
+		 *     including the terminator, on output. Returns false if the counter
+		 *     cannot be queried or a string does not fit its buffer.
+		 *
+		 ******************************************************************************/
+		virtual bool CheckCounter( int counterIndex, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength ) = 0;
+
+		/*******************************************************************************
+		 * GetCounterData
+		 *
+		 *     Samples the counter at counterIndex into data, which is dataSize
+		 *     bytes. Returns EXIT_SUCCESS if no error was encountered, otherwise
+		 *     returns an error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetCounterData( int counterIndex, void* data, unsigned int dataSize ) = 0;
+	};
+
+	/*******************************************************************************
+	 * IntelDeviceInfoCounter
+	 *
+	 *     Where a device exposes the "Intel Device Information" counter.
+	 *
+	 ******************************************************************************/
+	struct IntelDeviceInfoCounter
+	{
+		int counterIndex;
+		int version;     // from the "Version N" description: 1 or 2
+	};
+
+	/*******************************************************************************
+	 * FindIntelDeviceInfoCounter
+	 *
+	 *     Finds the "Intel Device Information" counter of source. The result is
+	 *     remembered for the rest of the process per (deviceKey, driverVersion);
+	 *     later calls with the same key check that one counter instead of
+	 *     scanning them all, and scan again if it no longer matches. Returns
+	 *     EXIT_SUCCESS if found, GPUDETECT_ERROR_DXGI_BAD_COUNTER if source has
+	 *     no counters and GPUDETECT_ERROR_DXGI_COUNTER_CREATION otherwise.
+	 *
+	 *     deviceKey
+	 *         Identifies the device model, e.g. ( vendorID << 16 ) | deviceID.
+	 *
+	 *     driverVersion
+	 *         The driver version, since a driver update can renumber counters.
+	 *
+	 ******************************************************************************/
+	int FindIntelDeviceInfoCounter( ICounterSource* source, uint32_t deviceKey, uint64_t driverVersion, IntelDeviceInfoCounter* counter );
+
+	/*******************************************************************************
+	 * InitCounterInfo
+	 *
+	 *     As GPUDetect::InitCounterInfo, reading the "Intel Device Information"
+	 *     counter of source. gpuData must already hold vendorID and deviceID.
+	 *
+	 *     driverVersion
+	 *         As for FindIntelDeviceInfoCounter.
+	 *
+	 ******************************************************************************/
+	int InitCounterInfo( GPUData* const gpuData, ICounterSource* source, uint64_t driverVersion );
+
+	/*******************************************************************************
+	 * IRegistrySource
+	 *
+	 *     The subkeys of SOFTWARE\\Microsoft\\DirectX, one per adapter the
+	 *     driver has ever installed, including stale ones.
+	 *
+	 ******************************************************************************/
+	class IRegistrySource
+	{
+	public:
+		virtual ~IRegistrySource() {}
+
+		/*******************************************************************************
+		 * GetSubKeyCount
+		 *
+		 *     Stores the number of subkeys, which are indexed from 0, in count.
+		 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns
+		 *     an error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetSubKeyCount( int* count ) = 0;
+
+		/*******************************************************************************
+		 * GetQwordValue
+		 *
+		 *     Reads the QWORD valueName of the subkey at subKeyIndex. Returns false
+		 *     if the subkey or value does not exist or is not a QWORD.
+		 *
+		 ******************************************************************************/
+		virtual bool GetQwordValue( int subKeyIndex, const char* valueName, uint64_t* value ) = 0;
+	};
+
+	/*******************************************************************************
+	 * DriverVersionIndex
+	 *
+	 *     Maps an adapter LUID, packed as ( HighPart << 32 ) | LowPart, to the
+	 *     raw DriverVersion QWORD of its registry key.
+	 *
+	 ******************************************************************************/
+	typedef std::unordered_map< uint64_t, uint64_t > DriverVersionIndex;
+
+	/*******************************************************************************
+	 * BuildDriverVersionIndex
+	 *
+	 *     Reads AdapterLuid and DriverVersion from every subkey of source in a
+	 *     single pass. Keys with a zero LUID or no DriverVersion are skipped.
+	 *     Existing contents of index are replaced. Returns EXIT_SUCCESS if no
+	 *     error was encountered, otherwise returns an error code.
+	 *
+	 ******************************************************************************/
+	int BuildDriverVersionIndex( IRegistrySource* source, DriverVersionIndex* index );
+
+	/*******************************************************************************
+	 * InitDxDriverVersion
+	 *
+	 *     As GPUDetect::InitDxDriverVersion, looking the adapter up in index.
+	 *
+	 ******************************************************************************/
+	int InitDxDriverVersion( GPUData* const gpuData, const DriverVersionIndex& index );
+
+	/*******************************************************************************
+	 * DriverVersionCache
+	 *
+	 *     A DriverVersionIndex built on the first lookup and shared by all
+	 *     adapters. A LUID that is missing from it may belong to an adapter
+	 *     that appeared since (hot plug, driver update), so the index is
+	 *     rebuilt, but at most once per missing LUID: a LUID that is still
+	 *     missing afterwards fails without scanning the registry again.
+	 *     Thread-safe.
+	 *
+	 ******************************************************************************/
+	class DriverVersionCache
+	{
+	public:
+		/*******************************************************************************
+		 * InitDxDriverVersion
+		 *
+		 *     As GPUDetect::InitDxDriverVersion, reading the registry from
+		 *     source when the index has to be built.
+		 *
+		 ******************************************************************************/
+		int InitDxDriverVersion( GPUData* const gpuData, IRegistrySource* source );
+
+		/*******************************************************************************
+		 * GetBuildCount
+		 *
+		 *     Returns how many times the index has been built.
+		 *
+		 ******************************************************************************/
+		unsigned int GetBuildCount();
+
+	private:
+		std::mutex m_mutex;
+		DriverVersionIndex m_index;
+		std::set< uint64_t > m_missedLUIDs;
+		unsigned int m_buildCount = 0;
+	};
+
+	/*******************************************************************************
+	 * EnumerateAdapters
+	 *
+	 *     Fills one GPUData per adapter of source, in enumeration order, with
+	 *     the adapter-level fields (see FillAdapterData). Returns EXIT_SUCCESS
+	 *     if no error was encountered, otherwise returns an error code.
+	 *
+	 *     source
+	 *         The adapters to enumerate.
+	 *
+	 *     gpuData
+	 *         Receives the adapters. Existing contents are replaced.
+	 *
+	 ******************************************************************************/
+	int EnumerateAdapters( IAdapterSource* source, std::vector< GPUData >* gpuData );
+
+	/*******************************************************************************
+	 * FillAdapterData
+	 *
+	 *     Sets dxAdapterAvailability, vendorID, deviceID, adapterLUID,
+	 *     description, isUMAArchitecture, videoMemory and, for Intel adapters,
+	 *     architecture from desc. isUMAArchitecture is a heuristic here; a
+	 *     device can refine it (see InitExtensionInfo).
+	 *
+	 ******************************************************************************/
+	void FillAdapterData( const AdapterDesc& desc, GPUData* const gpuData );
+
+	/*******************************************************************************
+	 * ICacheSource
+	 *
+	 *     The two halves of the detection of one adapter that InitAllCached
+	 *     keeps apart: the cheap fingerprint that keys the cache, and the full
+	 *     detection that a cache hit skips.
+	 *
+	 ******************************************************************************/
+	class ICacheSource
+	{
+	public:
+		virtual ~ICacheSource() {}
+
+		/*******************************************************************************
+		 * GetAdapterFingerprint
+		 *
+		 *     Fills vendorID, deviceID and adapterLUID of gpuData, and stores the
+		 *     driver version in driverVersion, without creating a device.
+		 *     Returns EXIT_SUCCESS if no error was encountered, otherwise returns
+		 *     an error code, and the cache is then bypassed.
+		 *
+		 ******************************************************************************/
+		virtual int GetAdapterFingerprint( GPUData* const gpuData, uint64_t* driverVersion ) = 0;
+
+		/*******************************************************************************
+		 * InitAll
+		 *
+		 *     Fills gpuData, like GPUDetect::InitAll.
+		 *
+		 ******************************************************************************/
+		virtual int InitAll( GPUData* const gpuData ) = 0;
+	};
+
+	/*******************************************************************************
+	 * InitAllCached
+	 *
+	 *     As GPUDetect::InitAllCached, with the fingerprint and the detection
+	 *     taken from source.
+	 *
+	 ******************************************************************************/
+	int InitAllCached( GPUData* const gpuData, ICacheSource* source, const char* cacheFileName );
+
+	/*******************************************************************************
+	 * ScanPresetFile
+	 *
+	 *     Parses every entry of a .cfg file as the override lookups do, without
+	 *     keeping them, and stores their number in entryCount. With buildIndex
+	 *     they are put into a fresh index, which is not cached, and entryCount
+	 *     receives the number of distinct devices in it.
+	 *     Exists so that the parser and the index build can be measured.
+	 *     Returns EXIT_SUCCESS, or GPUDETECT_ERROR_GENERIC if the file could
+	 *     not be opened.
+	 *
+	 ******************************************************************************/
+	int ScanPresetFile( const char* cfgFileName, bool buildIndex, size_t* entryCount );
+
+	/*******************************************************************************
+	 * g_currentTimings
+	 *
+	 *     The Timings of the InitAll call running on this thread, or nullptr if
+	 *     it did not ask for them. Set through TimingsScope.
+	 *
+	 ******************************************************************************/
+	extern thread_local Timings* g_currentTimings;
+
+	/*******************************************************************************
+	 * TimingsScope
+	 *
+	 *     Makes timings the current Timings of this thread for its lifetime.
+	 *
+	 ******************************************************************************/
+	class TimingsScope
+	{
+	public:
+		explicit TimingsScope( Timings* timings )
+			: m_previous( g_currentTimings )
+		{
+			g_currentTimings = timings;
+		}
+
+		~TimingsScope()
+		{
+			g_currentTimings = m_previous;
+		}
+
+	private:
+		TimingsScope( const TimingsScope& ) = delete;
+		TimingsScope& operator=( const TimingsScope& ) = delete;
+
+		Timings* m_previous;
+	};
+
+	/*******************************************************************************
+	 * StageTimer
+	 *
+	 *     Records its lifetime as stage in the current Timings of this thread,
+	 *     if there are any.
+	 *
+	 ******************************************************************************/
+	class StageTimer
+	{
+	public:
+#ifndef GPUDETECT_DISABLE_TIMINGS
+		explicit StageTimer( Timings::Stage stage )
+			: m_timings( g_currentTimings )
+			, m_stage( stage )
+		{
+			if( m_timings != nullptr )
+			{
+				m_timings->stages[ m_stage ].startNs = Now();
+				m_timings->stages[ m_stage ].endNs = 0;
+			}
+		}
+
+		~StageTimer()
+		{
+			if( m_timings != nullptr )
+			{
+				m_timings->stages[ m_stage ].endNs = Now();
+			}
+		}
+#else
+		explicit StageTimer( Timings::Stage )
+		{
+		}
+#endif
+
+	private:
+		StageTimer( const StageTimer& ) = delete;
+		StageTimer& operator=( const StageTimer& ) = delete;
+
+#ifndef GPUDETECT_DISABLE_TIMINGS
+		static int64_t Now()
+		{
+			return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+		}
+
+		Timings* m_timings;
+		Timings::Stage m_stage;
+#endif
+	};
+
+	/*******************************************************************************
+	 * DeviceCaps
+	 *
+	 *     What a device reports about itself, before GPUDetect interprets it.
+	 *
+	 ******************************************************************************/
+	struct DeviceCaps
+	{
+		int32_t isUMAArchitecture;   // 1 or 0, or -1 if the device cannot tell
+		uint32_t extensionVersion;   // 0 if the Intel extension was not queried
+		uint64_t driverVersion;      // the UMD version, 0 if unknown
+	};
+
+	/*******************************************************************************
+	 * ApplyDeviceCaps
+	 *
+	 *     Refines isUMAArchitecture and videoMemory from caps and sets
+	 *     extensionVersion and intelExtensionAvailability for Intel adapters.
+	 *     gpuData must already be filled by FillAdapterData( desc, gpuData ).
+	 *
+	 ******************************************************************************/
+	void ApplyDeviceCaps( const AdapterDesc& desc, const DeviceCaps& caps, GPUData* const gpuData );
+
+	/*******************************************************************************
+	 * IDeviceSource
+	 *
+	 *     The devices of the adapters of an IAdapterSource, with the same
+	 *     indices.
+	 *
+	 ******************************************************************************/
+	class IDeviceSource
+	{
+	public:
+		virtual ~IDeviceSource() {}
+
+		/*******************************************************************************
+		 * GetDeviceCaps
+		 *
+		 *     Fills caps for the device of the adapter at adapterIndex. The Intel
+		 *     extension is only queried if queryIntelExtension is true. Returns
+		 *     EXIT_SUCCESS if no error was encountered, otherwise returns an
+		 *     error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetDeviceCaps( int adapterIndex, bool queryIntelExtension, DeviceCaps* caps ) = 0;
+
+		/*******************************************************************************
+		 * GetCounterSource
+		 *
+		 *     Stores the counters of the device of the adapter at adapterIndex in
+		 *     counters. They remain owned by this source. Returns EXIT_SUCCESS if
+		 *     no error was encountered, otherwise returns an error code.
+		 *
+		 ******************************************************************************/
+		virtual int GetCounterSource( int adapterIndex, ICounterSource** counters ) = 0;
+	};
+
+	/*******************************************************************************
+	 * BackendSources
+	 *
+	 *     Everything the detection of GPUDetect::InitAll queries, and the
+	 *     DriverVersionCache that indexes registry. The cache must only ever
+	 *     be used with the one registry.
+	 *
+	 ******************************************************************************/
+	struct BackendSources
+	{
+		IAdapterSource* adapters;
+		IDeviceSource* devices;
+		IRegistrySource* registry;
+		DriverVersionCache* driverVersions;
+	};
+
+	/*******************************************************************************
+	 * InitAll
+	 *
+	 *     As GPUDetect::InitAll, querying only sources. GPUDetect::InitAll runs
+	 *     through this too, on DxgiBackend sources, so a recording of it
+	 *     measures the same path. The registry is only read when
+	 *     sources.driverVersions has to build or rebuild its index.
+	 *
+	 ******************************************************************************/
+	int InitAll( GPUData* const gpuData, const BackendSources& sources, int adapterIndex );
+
+#ifdef _WIN32
+	/*******************************************************************************
+	 * DxgiBackend
+	 *
+	 *     BackendSources that query DXGI, D3D11 and the registry, creating
+	 *     devices through a Context. Their DriverVersionCache is the one of
+	 *     the process, which GPUDetect::InitDxDriverVersion also uses.
+	 *
+	 ******************************************************************************/
+	class DxgiBackend
+	{
+	public:
+		// context must outlive this object
+		explicit DxgiBackend( Context* context );
+		~DxgiBackend();
+
+		BackendSources GetSources();
+
+	private:
+		DxgiBackend( const DxgiBackend& ) = delete;
+		DxgiBackend& operator=( const DxgiBackend& ) = delete;
+
+		struct Impl;
+		Impl* m_impl;
+	};
+#endif
+
+	/*******************************************************************************
+	 * BackendRecording
+	 *
+	 *     Every answer the sources gave during a detection, with how long each
+	 *     took, so the detection can be replayed later without the hardware:
+	 *
+	 *         DxgiBackend backend( &context );
+	 *         BackendRecording recording;
+	 *         InitAll( &gpuData, recording.Record( backend.GetSources() ), 0 );
+	 *         recording.Save( "machine.gpdr" );
+	 *
+	 *         BackendRecording replay;
+	 *         replay.Load( "machine.gpdr" );
+	 *         InitAll( &gpuData, replay.Replay( false ), 0 );
+	 *
+	 *     The same question always gets the recorded answer, so a replay is
+	 *     deterministic; a question that was not recorded fails with
+	 *     GPUDETECT_ERROR_REPLAY_MISSING_ANSWER. Recording and replaying are
+	 *     not thread-safe.
+	 *
+	 ******************************************************************************/
+	class BackendRecording
+	{
+	public:
+		BackendRecording();
+		~BackendRecording();
+
+		/*******************************************************************************
+		 * Record
+		 *
+		 *     Clears the recording and returns sources that forward to the given
+		 *     ones and record their answers. They remain valid until the next
+		 *     Record, Replay or Load call, and the given sources must outlive
+		 *     them. They come with a DriverVersionCache of their own, which starts
+		 *     empty so that the registry walk is recorded; the one of the given
+		 *     sources is not used.
+		 *
+		 ******************************************************************************/
+		BackendSources Record( const BackendSources& sources );
+
+		/*******************************************************************************
+		 * Replay
+		 *
+		 *     Returns sources that answer from the recording. If simulateLatency
+		 *     is true each answer waits for as long as it took when recorded.
+		 *     They remain valid until the next Record, Replay or Load call. Their
+		 *     DriverVersionCache starts empty, and is kept across the InitAll
+		 *     calls on them as the one of the process is.
+		 *
+		 ******************************************************************************/
+		BackendSources Replay( bool simulateLatency );
+
+		/*******************************************************************************
+		 * Load, Save
+		 *
+		 *     Read or write the recording. Load replaces the current recording.
+		 *     Return EXIT_SUCCESS if no error was encountered, otherwise
+		 *     GPUDETECT_ERROR_REPLAY_FILE.
+		 *
+		 ******************************************************************************/
+		int Load( const char* fileName );
+		int Save( const char* fileName ) const;
+
+	private:
+		BackendRecording( const BackendRecording& ) = delete;
+		BackendRecording& operator=( const BackendRecording& ) = delete;
+
+		struct Impl;
+		Impl* m_impl;
+	};
+}
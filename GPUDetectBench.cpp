@@ -0,0 +1,2406 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+//
+// Microbenchmarks of the functions of GPUDetect that do not query the
+// system, so regressions in these startup paths can be tracked. Needs no
+// GPU and runs on Windows and Linux.
+//
+// Each benchmark runs over three input sets: the device IDs of IntelGfx.cfg,
+// uniformly random device IDs, and adversarial ones (range edges, the
+// architecture table overrides and their neighbours, non-Intel vendors).
+// One JSON object per benchmark and input set is written to stdout:
+//
+//     {"benchmark":"GetIntelGPUArchitecture","inputs":"cfg","input_count":287,
+//      "ops_per_sample":1024,"samples":200,"ns_per_op":2.5,"min_ns":2.4,
+//      "p50_ns":2.5,"p90_ns":2.6,"p99_ns":2.9,"allocs_per_op":0.0000}
+//
+// The percentiles are over samples; each sample times ops_per_sample calls.
+// Allocations are counted through the global operator new.
+//
+// The modes below run checks instead, and exit with EXIT_FAILURE if one
+// fails; -check runs all of them:
+//
+//     -archcheck    GetIntelGPUArchitecture against the original if-chain,
+//                   on every device ID, and the lookups per second of both
+//     -presetcheck  GetDefaultFidelityPreset rules on new and unlisted parts
+//     -countercheck FindIntelDeviceInfoCounter on mock devices
+//     -registrycheck
+//                   DriverVersionCache rebuilds on a mock registry
+//     -replaycheck  A recording of mock sources saved, loaded and replayed,
+//                   and damaged recording files
+//     -cachecheck   InitAllCached hits and misses on a mock adapter, and
+//                   damaged cache files
+//     -uploadcheck  GetUploadAdvice on integrated and discrete GPUs
+//     -memcheck     MemoryBudgetMonitor threshold crossings, and on Linux
+//                   QueryMemoryBudget on fixtures/sysfs
+//     -scorecheck   GetThroughputScore on a table of GPUs, with and without
+//                   counter data
+//     -sysfscheck   InitSysfsInfo on the fake DRM tree in fixtures/sysfs
+//                   (Linux only)
+//     -freqcheck    FrequencySampler on the i915 and xe frequency files of
+//                   fixtures/sysfs (Linux only)
+//     -powercheck   PowerSampler on the hwmon and wrapping RAPL counters of
+//                   fixtures/sysfs (Linux only)
+//     -cpucheck     InitCPUSysfsInfo on the fake tree in fixtures/sysfs
+//                   (Linux only)
+//
+// and these run one larger benchmark each:
+//
+//     -bigcfg [lines]   Parsing and indexing a generated override cfg file
+//                       of 1,000,000 lines, or the given number
+//     -parallel [latency_ms ...]
+//                       InitAllAdapters on mock adapters that take the given
+//                       times to detect, on one thread and on the default
+//                       pool
+//     -counters [counter_count]
+//                       FindIntelDeviceInfoCounter on a mock device with 1,000
+//                       counters, or the given number: the first lookup and
+//                       the cached ones after it
+//     -registry [stale_key_count]
+//                       Building the driver version index of a mock registry
+//                       with 5,000 stale keys, or the given number, and
+//                       looking its adapters up
+//     -replay file [iterations] [-latency]
+//                       InitAll on every adapter of a recording made with
+//                       GPUDetect -record, 1,000 times or the given number;
+//                       with -latency each answer takes as long as recorded
+//
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#endif // _WIN32
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "DeviceId.h"
+#include "GPUDetect.h"
+#include "GPUDetectBackend.h"
+#include "GPUDetectSysfs.h"
+
+
+namespace
+{
+
+std::atomic< uint64_t > g_allocationCount( 0 );
+
+void* CountedAllocate( size_t size )
+{
+	g_allocationCount.fetch_add( 1, std::memory_order_relaxed );
+	return malloc( size != 0 ? size : 1 );
+}
+
+}
+
+void* operator new( size_t size )
+{
+	void* memory = CountedAllocate( size );
+	if( memory == nullptr )
+	{
+		abort();
+	}
+	return memory;
+}
+
+void* operator new[]( size_t size )
+{
+	return operator new( size );
+}
+
+void* operator new( size_t size, const std::nothrow_t& ) noexcept
+{
+	return CountedAllocate( size );
+}
+
+void* operator new[]( size_t size, const std::nothrow_t& ) noexcept
+{
+	return CountedAllocate( size );
+}
+
+void operator delete( void* memory ) noexcept
+{
+	free( memory );
+}
+
+void operator delete[]( void* memory ) noexcept
+{
+	free( memory );
+}
+
+void operator delete( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+void operator delete[]( void* memory, size_t ) noexcept
+{
+	free( memory );
+}
+
+
+namespace
+{
+
+const unsigned int kIntelVendorID = 0x8086;
+
+struct InputSet
+{
+	const char* name;
+	std::vector< GPUDetect::DeviceKey > devices;
+};
+
+struct Options
+{
+	int samples = 200;
+	int opsPerSample = 1024;
+	const char* cfgFileName = "IntelGfx.cfg";
+};
+
+// Defeats dead code elimination of the benchmarked calls
+volatile uint64_t g_sink = 0;
+
+bool IsNumber( const char* s )
+{
+	if( *s == '\0' )
+	{
+		return false;
+	}
+	for( ; *s != '\0'; ++s )
+	{
+		if( *s < '0' || *s > '9' )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void PrintError( const char* functionName, int returnCode )
+{
+	fprintf( stderr, "Error: %s returned %d.\n", functionName, returnCode );
+}
+
+/*******************************************************************************
+ * ReadCfgDevices
+ *
+ *     Returns the (vendorID, deviceID) pairs listed in a .cfg file, or none if
+ *     it cannot be read.
+ *
+ ******************************************************************************/
+std::vector< GPUDetect::DeviceKey > ReadCfgDevices( const char* cfgFileName )
+{
+	std::vector< GPUDetect::DeviceKey > devices;
+
+	FILE* file = fopen( cfgFileName, "r" );
+	if( file == nullptr )
+	{
+		return devices;
+	}
+
+	char line[ 512 ];
+	while( fgets( line, sizeof( line ), file ) != nullptr )
+	{
+		GPUDetect::DeviceKey device = {};
+		if( sscanf( line, " %x , %x", &device.vendorID, &device.deviceID ) == 2 )
+		{
+			devices.push_back( device );
+		}
+	}
+
+	fclose( file );
+	return devices;
+}
+
+std::vector< GPUDetect::DeviceKey > MakeRandomDevices( size_t count )
+{
+	// Fixed seed, so every run measures the same inputs
+	std::mt19937 generator( 0x47504944 );
+	std::uniform_int_distribution< unsigned int > deviceIDs( 0, 0xFFFF );
+
+	std::vector< GPUDetect::DeviceKey > devices( count );
+	for( GPUDetect::DeviceKey& device : devices )
+	{
+		device.vendorID = kIntelVendorID;
+		device.deviceID = deviceIDs( generator );
+	}
+	return devices;
+}
+
+std::vector< GPUDetect::DeviceKey > MakeAdversarialDevices( const std::vector< GPUDetect::DeviceKey >& cfgDevices )
+{
+	std::vector< GPUDetect::DeviceKey > devices;
+	const auto add = [ &devices ]( unsigned int vendorID, unsigned int deviceID )
+	{
+		GPUDetect::DeviceKey device = { vendorID, deviceID };
+		devices.push_back( device );
+	};
+
+	// Edges of the ID range, and bits above the 16 that are used
+	for( unsigned int deviceID : { 0x0000u, 0x0001u, 0x00FFu, 0x0100u, 0xFF00u, 0xFFFEu, 0xFFFFu, 0x10000u, 0xFFFFFFFFu } )
+	{
+		add( kIntelVendorID, deviceID );
+	}
+
+	// The table overrides and their neighbours, which hit the override scan
+	for( unsigned int deviceID : { 0x0150u, 0x016Fu, 0x3EA0u, 0x3EA1u } )
+	{
+		add( kIntelVendorID, deviceID - 1 );
+		add( kIntelVendorID, deviceID );
+		add( kIntelVendorID, deviceID + 1 );
+	}
+
+	// Neighbours of known devices, and known devices under other vendors,
+	// which probe the misses of the preset hash table
+	for( const GPUDetect::DeviceKey& device : cfgDevices )
+	{
+		add( device.vendorID, device.deviceID ^ 0x1 );
+		add( 0x10DE, device.deviceID );
+		add( 0x1002, device.deviceID );
+	}
+
+	return devices;
+}
+
+/*******************************************************************************
+ * Benchmark
+ *
+ *     Times op( i ), for i cycling through [0, inputCount), and prints the
+ *     result as one JSON line.
+ *
+ ******************************************************************************/
+template< typename Op >
+void Benchmark( const char* benchmarkName, const char* inputsName, size_t inputCount, const Options& options, Op op )
+{
+	if( inputCount == 0 )
+	{
+		fprintf( stdout, "{\"benchmark\":\"%s\",\"inputs\":\"%s\",\"error\":\"no inputs\"}\n", benchmarkName, inputsName );
+		return;
+	}
+
+	// Warm up caches, lazily built tables and the override file
+	size_t input = 0;
+	for( int i = 0; i < options.opsPerSample; ++i )
+	{
+		op( input );
+		input = input + 1 == inputCount ? 0 : input + 1;
+	}
+
+	std::vector< double > samplesNs( options.samples );
+	const uint64_t allocationsBefore = g_allocationCount.load();
+
+	for( double& sampleNs : samplesNs )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for( int i = 0; i < options.opsPerSample; ++i )
+		{
+			op( input );
+			input = input + 1 == inputCount ? 0 : input + 1;
+		}
+		const auto elapsed = std::chrono::steady_clock::now() - start;
+		sampleNs = std::chrono::duration< double, std::nano >( elapsed ).count() / options.opsPerSample;
+	}
+
+	const uint64_t allocations = g_allocationCount.load() - allocationsBefore;
+	const double totalOps = (double) options.samples * options.opsPerSample;
+
+	double sumNs = 0.0;
+	for( double sampleNs : samplesNs )
+	{
+		sumNs += sampleNs;
+	}
+
+	std::sort( samplesNs.begin(), samplesNs.end() );
+	const auto percentile = [ &samplesNs ]( double p )
+	{
+		const size_t index = std::min( samplesNs.size() - 1, (size_t) ( p * samplesNs.size() ) );
+		return samplesNs[ index ];
+	};
+
+	fprintf( stdout,
+		"{\"benchmark\":\"%s\",\"inputs\":\"%s\",\"input_count\":%zu,\"ops_per_sample\":%d,\"samples\":%d,"
+		"\"ns_per_op\":%.3f,\"min_ns\":%.3f,\"p50_ns\":%.3f,\"p90_ns\":%.3f,\"p99_ns\":%.3f,\"allocs_per_op\":%.4f}\n",
+		benchmarkName, inputsName, inputCount, options.opsPerSample, options.samples,
+		sumNs / options.samples, samplesNs.front(), percentile( 0.5 ), percentile( 0.9 ), percentile( 0.99 ),
+		allocations / totalOps );
+	fflush( stdout );
+}
+
+void RunBenchmarks( const InputSet& inputs, const Options& options )
+{
+	const std::vector< GPUDetect::DeviceKey >& devices = inputs.devices;
+	const size_t count = devices.size();
+
+	Benchmark( "GetIntelGPUArchitecture", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + GPUDetect::GetIntelGPUArchitecture( devices[ i ].deviceID );
+	} );
+
+	std::vector< GPUDetect::INTEL_GPU_ARCHITECTURE > architectures( count );
+	for( size_t i = 0; i < count; ++i )
+	{
+		architectures[ i ] = GPUDetect::GetIntelGPUArchitecture( devices[ i ].deviceID );
+	}
+
+	Benchmark( "GetIntelGPUArchitectureString", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + (uintptr_t) GPUDetect::GetIntelGPUArchitectureString( architectures[ i ] );
+	} );
+
+	Benchmark( "GetIntelGraphicsGeneration", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + GPUDetect::GetIntelGraphicsGeneration( architectures[ i ] );
+	} );
+
+	//
+	// Driver versions: one registry QWORD per input, derived from its device
+	// ID so every input decodes to a different version
+	//
+	std::vector< GPUDetect::GPUData > gpuData( count );
+	GPUDetect::DriverVersionIndex driverVersions;
+	for( size_t i = 0; i < count; ++i )
+	{
+		GPUDetect::GPUData& data = gpuData[ i ];
+		data = {};
+		data.dxAdapterAvailability = true;
+		data.vendorID = devices[ i ].vendorID;
+		data.deviceID = devices[ i ].deviceID;
+		data.adapterLUID.LowPart = (uint32_t) ( i + 1 );
+		data.architecture = architectures[ i ];
+
+		const uint64_t driverVersion = ( 31ull << 48 ) | ( 0ull << 32 ) | ( ( 101ull + ( devices[ i ].deviceID & 0xFF ) ) << 16 ) | ( devices[ i ].deviceID & 0xFFFF );
+		driverVersions[ i + 1 ] = driverVersion;
+		GPUDetect::InitDxDriverVersion( &data, driverVersions );
+	}
+
+	Benchmark( "DecodeDriverVersion", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + GPUDetect::InitDxDriverVersion( &gpuData[ i ], driverVersions ) + gpuData[ i ].dxDriverVersion[ 3 ];
+	} );
+
+	Benchmark( "GetDriverVersionAsCString", inputs.name, count, options, [ & ]( size_t i )
+	{
+		char driverVersion[ 19 ];
+		GPUDetect::GetDriverVersionAsCString( &gpuData[ i ], driverVersion, sizeof( driverVersion ) );
+		g_sink = g_sink + (uint8_t) driverVersion[ 0 ];
+	} );
+
+	Benchmark( "GetDefaultFidelityPreset", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + GPUDetect::GetDefaultFidelityPreset( &gpuData[ i ] );
+	} );
+
+	Benchmark( "GetDefaultFidelityPreset_cfg", inputs.name, count, options, [ & ]( size_t i )
+	{
+		g_sink = g_sink + GPUDetect::GetDefaultFidelityPreset( &gpuData[ i ], options.cfgFileName );
+	} );
+}
+
+/*******************************************************************************
+ * MeasureLookupsPerSecond
+ *
+ *     Times passes over all 65,536 device IDs and prints the lookups per
+ *     second of decode as one JSON line.
+ *
+ ******************************************************************************/
+template< typename Decode >
+void MeasureLookupsPerSecond( const char* benchmarkName, Decode decode )
+{
+	const int kPasses = 64;
+	const auto start = std::chrono::steady_clock::now();
+	for( int pass = 0; pass < kPasses; ++pass )
+	{
+		for( unsigned int deviceID = 0; deviceID <= 0xFFFF; ++deviceID )
+		{
+			g_sink = g_sink + decode( deviceID );
+		}
+	}
+	const double seconds = std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+
+	fprintf( stdout, "{\"benchmark\":\"%s\",\"inputs\":\"all_ids\",\"input_count\":65536,\"lookups_per_sec\":%.0f}\n",
+		benchmarkName, kPasses * 65536.0 / seconds );
+	fflush( stdout );
+}
+
+/*******************************************************************************
+ * GetIntelGPUArchitectureReference
+ *
+ *     The original if-chain decoder that GetIntelGPUArchitecture replaced,
+ *     kept here as the reference for -archcheck.
+ *
+ ******************************************************************************/
+GPUDetect::INTEL_GPU_ARCHITECTURE GetIntelGPUArchitectureReference( unsigned int deviceId )
+{
+	const unsigned int idhi = deviceId & 0xFF00;
+	const unsigned int idlo = deviceId & 0x00FF;
+
+	if( idhi == 0x0100 )
+	{
+		if( ( idlo & 0xFFF0 ) == 0x0050 || ( idlo & 0xFFF0 ) == 0x0060 )
+		{
+			return GPUDetect::IGFX_IVYBRIDGE;
+		}
+		return GPUDetect::IGFX_SANDYBRIDGE;
+	}
+
+	if( idhi == 0x0400 || idhi == 0x0A00 || idhi == 0x0D00 || idhi == 0x0C00 )
+	{
+		return GPUDetect::IGFX_HASWELL;
+	}
+
+	if( idhi == 0x1600 || idhi == 0x0B00 )
+	{
+		return GPUDetect::IGFX_BROADWELL;
+	}
+
+	if( idhi == 0x1900 || idhi == 0x0900 )
+	{
+		return GPUDetect::IGFX_SKYLAKE;
+	}
+
+	if( idhi == 0x5900 )
+	{
+		return GPUDetect::IGFX_KABYLAKE;
+	}
+
+	if( idhi == 0x3100 )
+	{
+		return GPUDetect::IGFX_GEMINILAKE;
+	}
+
+	if( idhi == 0x5A00 )
+	{
+		return GPUDetect::IGFX_CANNONLAKE;
+	}
+
+	if( idhi == 0x3E00 )
+	{
+		if( idlo == 0x00A0 || idlo == 0x00A1 )
+		{
+			return GPUDetect::IGFX_WHISKEYLAKE;
+		}
+		return GPUDetect::IGFX_COFFEELAKE;
+	}
+
+	if ( idhi == 0x8A00 )
+	{
+		return GPUDetect::IGFX_ICELAKE_LP;
+	}
+
+	if( idhi == 0x9A00 )
+	{
+		return GPUDetect::IGFX_TIGERLAKE_LP;
+	}
+
+	if( idhi == 0x4900 )
+	{
+		return GPUDetect::IGFX_DG1;
+	}
+
+	if (idhi == 0x4C00)
+	{
+		return GPUDetect::IGFX_ROCKETLAKE;
+	}
+
+	if (idhi == 0x9B00)
+	{
+		return GPUDetect::IGFX_COMETLAKE;
+	}
+
+	if (idhi == 0x4600)
+	{
+		return GPUDetect::IGFX_ADL;
+	}
+
+	if (idhi == 0x5600)
+	{
+		return GPUDetect::DGFX_ACM;
+	}
+
+	// The original asserted here; unknown ids are a valid answer now
+	return GPUDetect::IGFX_UNKNOWN;
+}
+
+/*******************************************************************************
+ * CheckArchitectureDecode
+ *
+ *     Compares GetIntelGPUArchitecture with the original if-chain on every
+ *     16-bit device ID, then measures both.
+ *
+ ******************************************************************************/
+bool CheckArchitectureDecode()
+{
+	unsigned int mismatches = 0;
+	for( unsigned int deviceID = 0; deviceID <= 0xFFFF; ++deviceID )
+	{
+		const GPUDetect::INTEL_GPU_ARCHITECTURE expected = GetIntelGPUArchitectureReference( deviceID );
+		const GPUDetect::INTEL_GPU_ARCHITECTURE actual = GPUDetect::GetIntelGPUArchitecture( deviceID );
+		if( actual != expected )
+		{
+			if( mismatches < 16 )
+			{
+				fprintf( stderr, "0x%04X: %s, expected %s\n", deviceID,
+					GPUDetect::GetIntelGPUArchitectureString( actual ), GPUDetect::GetIntelGPUArchitectureString( expected ) );
+			}
+			++mismatches;
+		}
+	}
+
+	MeasureLookupsPerSecond( "GetIntelGPUArchitecture", []( unsigned int deviceID ) { return GPUDetect::GetIntelGPUArchitecture( deviceID ); } );
+	MeasureLookupsPerSecond( "GetIntelGPUArchitectureReference", []( unsigned int deviceID ) { return GetIntelGPUArchitectureReference( deviceID ); } );
+
+	fprintf( stdout, "{\"check\":\"archcheck\",\"inputs\":65536,\"mismatches\":%u}\n", mismatches );
+	return mismatches == 0;
+}
+
+/*******************************************************************************
+ * WriteSyntheticCfg
+ *
+ *     Writes a cfg file of lineCount lines in the layout of IntelGfx.cfg:
+ *     entries with comments, a blank or comment line in every 16, and IDs
+ *     that repeat every 64K entries under the next vendor ID.
+ *
+ ******************************************************************************/
+bool WriteSyntheticCfg( const char* fileName, unsigned int lineCount )
+{
+	FILE* file = fopen( fileName, "w" );
+	if( file == nullptr )
+	{
+		return false;
+	}
+
+	const char* const presetNames[] = { "Low", "Medium", "Medium+", "High", "NotCompatible" };
+	for( unsigned int line = 0; line < lineCount; ++line )
+	{
+		if( line % 16 == 0 )
+		{
+			fprintf( file, line % 32 == 0 ? "\n" : "; Synthetic block %u\n", line / 16 );
+			continue;
+		}
+
+		fprintf( file, "0x%04X, 0x%04X, %s ; Synthetic device %u\n",
+			kIntelVendorID + ( line >> 16 ), line & 0xFFFF, presetNames[ line % 5 ], line );
+	}
+
+	return fclose( file ) == 0;
+}
+
+/*******************************************************************************
+ * BenchLargeCfg
+ *
+ *     Times the cfg parser, the index build and the first override lookup,
+ *     which builds the cached index, on a generated file.
+ *
+ ******************************************************************************/
+int BenchLargeCfg( int argc, char** argv )
+{
+	unsigned int lineCount = 1000000;
+	if( argc == 1 && IsNumber( argv[ 0 ] ) && atoi( argv[ 0 ] ) > 0 )
+	{
+		lineCount = (unsigned int) atoi( argv[ 0 ] );
+	}
+	else if( argc != 0 )
+	{
+		fprintf( stderr, "Error: expected a line count.\n" );
+		return EXIT_FAILURE;
+	}
+
+	const char* const fileName = "GPUDetectBench_synthetic.cfg";
+	if( !WriteSyntheticCfg( fileName, lineCount ) )
+	{
+		fprintf( stderr, "Error: %s could not be written.\n", fileName );
+		return EXIT_FAILURE;
+	}
+
+	const int kRuns = 5;
+	const auto timeRuns = [ & ]( const char* benchmarkName, bool buildIndex )
+	{
+		size_t entryCount = 0;
+		double minMs = 0.0;
+		double sumMs = 0.0;
+		for( int run = 0; run < kRuns; ++run )
+		{
+			const auto start = std::chrono::steady_clock::now();
+			if( GPUDetect::ScanPresetFile( fileName, buildIndex, &entryCount ) != EXIT_SUCCESS )
+			{
+				return false;
+			}
+			const double ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+			minMs = run == 0 ? ms : std::min( minMs, ms );
+			sumMs += ms;
+		}
+
+		fprintf( stdout, "{\"benchmark\":\"%s\",\"inputs\":\"synthetic_cfg\",\"lines\":%u,\"entries\":%zu,\"runs\":%d,\"mean_ms\":%.2f,\"min_ms\":%.2f,\"lines_per_sec\":%.0f}\n",
+			benchmarkName, lineCount, entryCount, kRuns, sumMs / kRuns, minMs, lineCount / ( minMs / 1000.0 ) );
+		fflush( stdout );
+		return true;
+	};
+
+	bool passed = timeRuns( "ForEachPresetEntry", false ) && timeRuns( "BuildPresetFileIndex", true );
+
+	if( passed )
+	{
+		// The first lookup indexes the file for the process, later ones hit it
+		GPUDetect::GPUData gpuData = {};
+		gpuData.dxAdapterAvailability = true;
+		gpuData.vendorID = kIntelVendorID;
+		gpuData.deviceID = 0x0001;
+
+		const auto start = std::chrono::steady_clock::now();
+		g_sink = g_sink + GPUDetect::GetDefaultFidelityPreset( &gpuData, fileName );
+		const double firstMs = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+
+		fprintf( stdout, "{\"benchmark\":\"GetDefaultFidelityPreset_first\",\"inputs\":\"synthetic_cfg\",\"lines\":%u,\"ms\":%.2f}\n", lineCount, firstMs );
+	}
+
+	remove( fileName );
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*******************************************************************************
+ * MockAdapterDetector
+ *
+ *     Stands in for the GPU: each adapter takes a configurable time to
+ *     detect, so InitAllAdapters can be measured on any machine.
+ *
+ ******************************************************************************/
+class MockAdapterDetector : public GPUDetect::IAdapterDetector
+{
+public:
+	explicit MockAdapterDetector( const std::vector< int >& latenciesMs )
+		: m_latenciesMs( latenciesMs )
+	{
+	}
+
+	int GetAdapterCount( int* count ) override
+	{
+		*count = (int) m_latenciesMs.size();
+		return EXIT_SUCCESS;
+	}
+
+	int InitAll( GPUDetect::GPUData* const gpuData, int adapterIndex ) override
+	{
+		std::this_thread::sleep_for( std::chrono::milliseconds( m_latenciesMs[ adapterIndex ] ) );
+
+		gpuData->dxAdapterAvailability = true;
+		gpuData->vendorID = kIntelVendorID;
+		gpuData->deviceID = 0x4905; // DG1
+		gpuData->adapterLUID.LowPart = adapterIndex;
+		return EXIT_SUCCESS;
+	}
+
+private:
+	std::vector< int > m_latenciesMs;
+};
+
+/*******************************************************************************
+ * BenchParallelDetection
+ *
+ *     Times InitAllAdapters on mock adapters with the given latencies, on one
+ *     thread and on the default pool.
+ *
+ ******************************************************************************/
+int BenchParallelDetection( int argc, char** argv )
+{
+	std::vector< int > latenciesMs;
+	for( int i = 0; i < argc; ++i )
+	{
+		if( !IsNumber( argv[ i ] ) )
+		{
+			fprintf( stderr, "Error: latencies must be in milliseconds.\n" );
+			return EXIT_FAILURE;
+		}
+		latenciesMs.push_back( atoi( argv[ i ] ) );
+	}
+
+	if( latenciesMs.empty() )
+	{
+		// iGPU, discrete card, and a second discrete card
+		latenciesMs = { 40, 120, 120 };
+	}
+
+	MockAdapterDetector detector( latenciesMs );
+	const unsigned int threadCounts[] = { 1, 0 };
+	for( const unsigned int maxThreads : threadCounts )
+	{
+		std::vector< GPUDetect::GPUData > gpuData;
+		const auto start = std::chrono::steady_clock::now();
+		const int returnCode = GPUDetect::InitAllAdapters( &detector, &gpuData, nullptr, maxThreads );
+		const double ms = std::chrono::duration< double, std::milli >( std::chrono::steady_clock::now() - start ).count();
+		if( returnCode != EXIT_SUCCESS )
+		{
+			PrintError( "InitAllAdapters", returnCode );
+			return EXIT_FAILURE;
+		}
+
+		fprintf( stdout, "{\"benchmark\":\"InitAllAdapters\",\"inputs\":\"mock_adapters\",\"input_count\":%zu,\"threads\":\"%s\",\"ms\":%.1f}\n",
+			gpuData.size(), maxThreads == 1 ? "sequential" : "default", ms );
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * MockCounterSource
+ *
+ *     Reports counterCount device-dependent counters, of which the one at
+ *     deviceInfoIndex, if any, is "Intel Device Information", and counts the
+ *     CheckCounter calls. Its data holds only the frequencies.
+ *
+ ******************************************************************************/
+class MockCounterSource : public GPUDetect::ICounterSource
+{
+public:
+	MockCounterSource( int counterCount, int deviceInfoIndex )
+		: m_counterCount( counterCount )
+		, m_deviceInfoIndex( deviceInfoIndex )
+	{
+	}
+
+	int GetCounterCount() override
+	{
+		return m_counterCount;
+	}
+
+	bool CheckCounter( int counterIndex, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength ) override
+	{
+		++m_checkCounterCalls;
+
+		char counterName[ 64 ];
+		if( counterIndex == m_deviceInfoIndex )
+		{
+			strcpy( counterName, "Intel Device Information" );
+		}
+		else
+		{
+			snprintf( counterName, sizeof( counterName ), "Vendor Counter %d", counterIndex );
+		}
+		const char* counterDescription = counterIndex == m_deviceInfoIndex ? "Version 2" : "Vendor specific counter";
+
+		const unsigned int nameSize = (unsigned int) strlen( counterName ) + 1;
+		const unsigned int descriptionSize = (unsigned int) strlen( counterDescription ) + 1;
+		const bool fits = nameSize <= *nameLength && descriptionSize <= *descriptionLength;
+		if( fits )
+		{
+			memcpy( name, counterName, nameSize );
+			memcpy( description, counterDescription, descriptionSize );
+		}
+		*nameLength = nameSize;
+		*descriptionLength = descriptionSize;
+		return fits;
+	}
+
+	int GetCounterData( int, void* data, unsigned int dataSize ) override
+	{
+		// GPUMaxFreq and GPUMinFreq lead every IntelDeviceInfo version
+		memset( data, 0, dataSize );
+		const uint32_t frequencies[] = { m_maxFrequency, m_minFrequency };
+		memcpy( data, frequencies, std::min( (size_t) dataSize, sizeof( frequencies ) ) );
+		return EXIT_SUCCESS;
+	}
+
+	unsigned int m_checkCounterCalls = 0;
+	uint32_t m_maxFrequency = 0;
+	uint32_t m_minFrequency = 0;
+
+private:
+	int m_counterCount;
+	int m_deviceInfoIndex;
+};
+
+/*******************************************************************************
+ * BenchCounterDiscovery
+ *
+ *     Times the first FindIntelDeviceInfoCounter call on a mock device with
+ *     many counters, and the cached calls after it.
+ *
+ ******************************************************************************/
+int BenchCounterDiscovery( int argc, char** argv )
+{
+	int counterCount = 1000;
+	if( argc == 1 && IsNumber( argv[ 0 ] ) && atoi( argv[ 0 ] ) > 0 )
+	{
+		counterCount = atoi( argv[ 0 ] );
+	}
+	else if( argc != 0 )
+	{
+		fprintf( stderr, "Error: expected a counter count.\n" );
+		return EXIT_FAILURE;
+	}
+
+	MockCounterSource source( counterCount, counterCount - 1 );
+	GPUDetect::IntelDeviceInfoCounter counter = {};
+
+	// The first lookup scans every counter, the later ones hit the cache
+	const int runCounts[] = { 1, 1000 };
+	for( const int runs : runCounts )
+	{
+		source.m_checkCounterCalls = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for( int i = 0; i < runs; ++i )
+		{
+			const int returnCode = GPUDetect::FindIntelDeviceInfoCounter( &source, 0x80864905, 0x1F0004000B5D4, &counter );
+			if( returnCode != EXIT_SUCCESS )
+			{
+				PrintError( "FindIntelDeviceInfoCounter", returnCode );
+				return EXIT_FAILURE;
+			}
+		}
+		const double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count();
+
+		fprintf( stdout, "{\"benchmark\":\"FindIntelDeviceInfoCounter_%s\",\"inputs\":\"mock_counters\",\"input_count\":%d,\"check_counter_calls\":%u,\"ns_per_op\":%.1f}\n",
+			runs == 1 ? "first" : "cached", counterCount, source.m_checkCounterCalls / runs, ns / runs );
+	}
+
+	return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * CheckPresetRules
+ *
+ *     Checks GetDefaultFidelityPreset on devices the compiled table does not
+ *     list, so only the rules apply: a new part whose counter reports an
+ *     architecture outside INTEL_GPU_ARCHITECTURE lands on the EU-count
+ *     rules for unknown architectures, and a known one on the rules for its
+ *     generation.
+ *
+ ******************************************************************************/
+bool CheckPresetRules()
+{
+	unsigned int failures = 0;
+
+	// Not in IntelGfx.cfg, and newer than the architecture table
+	const unsigned int kNewDeviceID = 0x7D55;
+
+	const struct
+	{
+		const char* what;
+		unsigned int vendorID;
+		unsigned int architecture;
+		unsigned int euCount;
+		GPUDetect::PresetLevel expected;
+	}
+	cases[] =
+	{
+		{ "new architecture with 128 EUs", kIntelVendorID, 0x27, 128, GPUDetect::High },
+		{ "new architecture past DGFX_ACM with 64 EUs", kIntelVendorID, GPUDetect::DGFX_ACM + 1, 64, GPUDetect::Medium },
+		{ "new architecture with 32 EUs, which falls back to Low", kIntelVendorID, 0x27, 32, GPUDetect::Low },
+		{ "Tiger Lake with 96 EUs", kIntelVendorID, GPUDetect::IGFX_TIGERLAKE_LP, 96, GPUDetect::High },
+		{ "Tiger Lake with 80 EUs", kIntelVendorID, GPUDetect::IGFX_TIGERLAKE_LP, 80, GPUDetect::Medium },
+		{ "other vendor", 0x10DE, 0x27, 128, GPUDetect::Undefined },
+	};
+
+	for( const auto& testCase : cases )
+	{
+		GPUDetect::GPUData gpuData = {};
+		gpuData.dxAdapterAvailability = true;
+		gpuData.vendorID = testCase.vendorID;
+		gpuData.deviceID = kNewDeviceID;
+		gpuData.architecture = (GPUDetect::INTEL_GPU_ARCHITECTURE) testCase.architecture;
+		gpuData.euCount = testCase.euCount;
+
+		const GPUDetect::PresetLevel preset = GPUDetect::GetDefaultFidelityPreset( &gpuData );
+		if( preset != testCase.expected )
+		{
+			fprintf( stderr, "presetcheck: %s: got preset %d, expected %d\n", testCase.what, (int) preset, (int) testCase.expected );
+			++failures;
+		}
+	}
+
+	fprintf( stdout, "{\"check\":\"presetcheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckCounterDiscovery
+ *
+ *     Checks FindIntelDeviceInfoCounter on mock devices: the first lookup
+ *     scans, a repeated one checks only the remembered counter, a renumbered
+ *     counter is found again, and devices without it fail.
+ *
+ ******************************************************************************/
+bool CheckCounterDiscovery()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "countercheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	// Keys of their own, as the lookups are remembered for the process
+	const uint32_t deviceKey = 0x8086FFF0;
+	const uint64_t driverVersion = 0x001F000400000001ull;
+
+	GPUDetect::IntelDeviceInfoCounter counter = {};
+	MockCounterSource source( 50, 49 );
+	int returnCode = GPUDetect::FindIntelDeviceInfoCounter( &source, deviceKey, driverVersion, &counter );
+	expect( returnCode == EXIT_SUCCESS && counter.counterIndex == 49 && counter.version == 2, "first lookup did not find the counter" );
+	expect( source.m_checkCounterCalls == 50, "first lookup did not scan every counter once" );
+
+	source.m_checkCounterCalls = 0;
+	counter = {};
+	returnCode = GPUDetect::FindIntelDeviceInfoCounter( &source, deviceKey, driverVersion, &counter );
+	expect( returnCode == EXIT_SUCCESS && counter.counterIndex == 49 && counter.version == 2, "cached lookup did not find the counter" );
+	expect( source.m_checkCounterCalls == 1, "cached lookup scanned again" );
+
+	// Same key, but the counter moved, e.g. after a driver reinstall
+	MockCounterSource renumbered( 50, 10 );
+	returnCode = GPUDetect::FindIntelDeviceInfoCounter( &renumbered, deviceKey, driverVersion, &counter );
+	expect( returnCode == EXIT_SUCCESS && counter.counterIndex == 10, "renumbered counter was not found" );
+
+	MockCounterSource missing( 20, -1 );
+	returnCode = GPUDetect::FindIntelDeviceInfoCounter( &missing, deviceKey + 1, driverVersion, &counter );
+	expect( returnCode == GPUDETECT_ERROR_DXGI_COUNTER_CREATION, "device without the counter did not fail" );
+
+	MockCounterSource empty( 0, -1 );
+	returnCode = GPUDetect::FindIntelDeviceInfoCounter( &empty, deviceKey + 2, driverVersion, &counter );
+	expect( returnCode == GPUDETECT_ERROR_DXGI_BAD_COUNTER, "device without counters did not fail" );
+
+	fprintf( stdout, "{\"check\":\"countercheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * MockRegistrySource
+ *
+ *     A synthetic DirectX registry key: staleKeyCount leftover keys with a
+ *     zero LUID, followed by one key per adapter. Counts the value reads.
+ *
+ ******************************************************************************/
+class MockRegistrySource : public GPUDetect::IRegistrySource
+{
+public:
+	MockRegistrySource( int staleKeyCount, int adapterCount )
+		: m_staleKeyCount( staleKeyCount )
+		, m_adapterCount( adapterCount )
+	{
+	}
+
+	int GetSubKeyCount( int* count ) override
+	{
+		*count = m_staleKeyCount + m_adapterCount;
+		return EXIT_SUCCESS;
+	}
+
+	bool GetQwordValue( int subKeyIndex, const char* valueName, uint64_t* value ) override
+	{
+		++m_valueReads;
+
+		const bool isAdapter = subKeyIndex >= m_staleKeyCount;
+		if( strcmp( valueName, "AdapterLuid" ) == 0 )
+		{
+			*value = isAdapter ? 0x10000 + subKeyIndex - m_staleKeyCount : 0;
+			return true;
+		}
+		if( strcmp( valueName, "DriverVersion" ) == 0 )
+		{
+			*value = 0x001F000400000000ull | (uint64_t) subKeyIndex;
+			return true;
+		}
+		return false;
+	}
+
+	// An adapter that appeared after the index was built
+	void AddAdapter()
+	{
+		++m_adapterCount;
+	}
+
+	unsigned int m_valueReads = 0;
+
+private:
+	int m_staleKeyCount;
+	int m_adapterCount;
+};
+
+/*******************************************************************************
+ * MakeRegistryAdapter
+ *
+ *     Returns the GPUData of the adapter at adapterIndex of a
+ *     MockRegistrySource, ready for InitDxDriverVersion.
+ *
+ ******************************************************************************/
+GPUDetect::GPUData MakeRegistryAdapter( int adapterIndex )
+{
+	GPUDetect::GPUData gpuData = {};
+	gpuData.dxAdapterAvailability = true;
+	gpuData.adapterLUID.LowPart = 0x10000 + adapterIndex;
+	return gpuData;
+}
+
+/*******************************************************************************
+ * BenchDriverVersionIndex
+ *
+ *     Times building the driver version index of a mock registry with many
+ *     stale keys, and looking all adapters up in it.
+ *
+ ******************************************************************************/
+int BenchDriverVersionIndex( int argc, char** argv )
+{
+	int staleKeyCount = 5000;
+	if( argc == 1 && IsNumber( argv[ 0 ] ) )
+	{
+		staleKeyCount = atoi( argv[ 0 ] );
+	}
+	else if( argc != 0 )
+	{
+		fprintf( stderr, "Error: expected a stale key count.\n" );
+		return EXIT_FAILURE;
+	}
+
+	const int kAdapterCount = 4;
+	MockRegistrySource source( staleKeyCount, kAdapterCount );
+
+	auto start = std::chrono::steady_clock::now();
+	GPUDetect::DriverVersionIndex index;
+	int returnCode = GPUDetect::BuildDriverVersionIndex( &source, &index );
+	const double buildNs = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count();
+	if( returnCode != EXIT_SUCCESS )
+	{
+		PrintError( "BuildDriverVersionIndex", returnCode );
+		return EXIT_FAILURE;
+	}
+
+	start = std::chrono::steady_clock::now();
+	for( int i = 0; i < kAdapterCount; ++i )
+	{
+		GPUDetect::GPUData gpuData = MakeRegistryAdapter( i );
+		returnCode = GPUDetect::InitDxDriverVersion( &gpuData, index );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			PrintError( "InitDxDriverVersion", returnCode );
+			return EXIT_FAILURE;
+		}
+	}
+	const double lookupNs = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count();
+
+	fprintf( stdout, "{\"benchmark\":\"BuildDriverVersionIndex\",\"inputs\":\"mock_registry\",\"input_count\":%d,\"value_reads\":%u,\"ns_per_op\":%.1f}\n",
+		staleKeyCount + kAdapterCount, source.m_valueReads, buildNs );
+	fprintf( stdout, "{\"benchmark\":\"InitDxDriverVersion\",\"inputs\":\"mock_registry\",\"input_count\":%d,\"ns_per_op\":%.1f}\n",
+		kAdapterCount, lookupNs / kAdapterCount );
+	return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * CheckDriverVersionCache
+ *
+ *     Checks DriverVersionCache on a mock registry: the index is built once
+ *     for all adapters, a new adapter is found by one rebuild, and a LUID
+ *     that is never in the registry costs at most one rebuild.
+ *
+ ******************************************************************************/
+bool CheckDriverVersionCache()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "registrycheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	const int kAdapterCount = 4;
+	MockRegistrySource source( 100, kAdapterCount );
+	GPUDetect::DriverVersionCache cache;
+
+	bool found = true;
+	for( int pass = 0; pass < 2; ++pass )
+	{
+		for( int i = 0; i < kAdapterCount; ++i )
+		{
+			GPUDetect::GPUData gpuData = MakeRegistryAdapter( i );
+			found = cache.InitDxDriverVersion( &gpuData, &source ) == EXIT_SUCCESS && gpuData.dxDriverVersion[ 3 ] == (unsigned int) ( 100 + i ) && found;
+		}
+	}
+	expect( found, "adapters were not found" );
+	expect( cache.GetBuildCount() == 1, "index was built more than once for known adapters" );
+
+	source.AddAdapter();
+	GPUDetect::GPUData gpuData = MakeRegistryAdapter( kAdapterCount );
+	expect( cache.InitDxDriverVersion( &gpuData, &source ) == EXIT_SUCCESS, "new adapter was not found" );
+	expect( cache.GetBuildCount() == 2, "new adapter did not rebuild the index once" );
+
+	for( int i = 0; i < 3; ++i )
+	{
+		gpuData = MakeRegistryAdapter( 1000 );
+		expect( cache.InitDxDriverVersion( &gpuData, &source ) == GPUDETECT_ERROR_REG_MISSING_DRIVER_INFO, "missing adapter did not fail" );
+	}
+	expect( cache.GetBuildCount() == 3, "missing adapter rebuilt the index more than once" );
+
+	// A fresh index is not rebuilt for a miss
+	GPUDetect::DriverVersionCache freshCache;
+	gpuData = MakeRegistryAdapter( 1000 );
+	expect( freshCache.InitDxDriverVersion( &gpuData, &source ) == GPUDETECT_ERROR_REG_MISSING_DRIVER_INFO, "missing adapter did not fail" );
+	expect( freshCache.GetBuildCount() == 1, "fresh index was rebuilt" );
+
+	fprintf( stdout, "{\"check\":\"registrycheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * BenchReplay
+ *
+ *     Runs InitAll on every adapter of a recording, iterations times, and
+ *     reports the average time per pass. With -latency every answer takes as
+ *     long as it did when recorded.
+ *
+ ******************************************************************************/
+int BenchReplay( int argc, char** argv )
+{
+	int iterations = 1000;
+	bool simulateLatency = false;
+	bool validArguments = argc >= 1;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-latency" ) == 0 )
+		{
+			simulateLatency = true;
+		}
+		else if( IsNumber( argv[ i ] ) && atoi( argv[ i ] ) > 0 )
+		{
+			iterations = atoi( argv[ i ] );
+		}
+		else
+		{
+			validArguments = false;
+		}
+	}
+	if( !validArguments )
+	{
+		fprintf( stderr, "Error: expected a recording file name, then optionally an iteration count and -latency.\n" );
+		return EXIT_FAILURE;
+	}
+
+	GPUDetect::BackendRecording recording;
+	int returnCode = recording.Load( argv[ 0 ] );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		PrintError( "BackendRecording::Load", returnCode );
+		return EXIT_FAILURE;
+	}
+
+	const GPUDetect::BackendSources sources = recording.Replay( simulateLatency );
+	const int adapterCount = sources.adapters->GetAdapterCount();
+
+	std::vector< GPUDetect::GPUData > gpuData( adapterCount );
+	std::vector< int > returnCodes( adapterCount );
+
+	const auto start = std::chrono::steady_clock::now();
+	for( int iteration = 0; iteration < iterations; ++iteration )
+	{
+		for( int i = 0; i < adapterCount; ++i )
+		{
+			gpuData[ i ] = {};
+			returnCodes[ i ] = GPUDetect::InitAll( &gpuData[ i ], sources, i );
+		}
+	}
+	const double ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - start ).count();
+
+	for( int i = 0; i < adapterCount; ++i )
+	{
+		if( returnCodes[ i ] != EXIT_SUCCESS )
+		{
+			fprintf( stderr, "Adapter #%d: ", i );
+			PrintError( "InitAll", returnCodes[ i ] );
+		}
+	}
+
+	fprintf( stdout, "{\"benchmark\":\"InitAll_replay\",\"inputs\":\"%s\",\"input_count\":%d,\"iterations\":%d,\"latency\":%s,\"ns_per_op\":%.1f}\n",
+		argv[ 0 ], adapterCount, iterations, simulateLatency ? "true" : "false", ns / iterations );
+	return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * MockAdapterSource, MockDeviceSource
+ *
+ *     A fixed set of adapters, their devices and one counter source shared
+ *     by all of them.
+ *
+ ******************************************************************************/
+class MockAdapterSource : public GPUDetect::IAdapterSource
+{
+public:
+	explicit MockAdapterSource( const std::vector< GPUDetect::AdapterDesc >& descs )
+		: m_descs( descs )
+	{
+	}
+
+	int GetAdapterCount() override
+	{
+		return (int) m_descs.size();
+	}
+
+	int GetAdapterDesc( int adapterIndex, GPUDetect::AdapterDesc* desc ) override
+	{
+		*desc = m_descs[ adapterIndex ];
+		return EXIT_SUCCESS;
+	}
+
+private:
+	std::vector< GPUDetect::AdapterDesc > m_descs;
+};
+
+class MockDeviceSource : public GPUDetect::IDeviceSource
+{
+public:
+	MockDeviceSource( const GPUDetect::DeviceCaps& caps, GPUDetect::ICounterSource* counters )
+		: m_caps( caps )
+		, m_counters( counters )
+	{
+	}
+
+	int GetDeviceCaps( int, bool queryIntelExtension, GPUDetect::DeviceCaps* caps ) override
+	{
+		*caps = m_caps;
+		if( !queryIntelExtension )
+		{
+			caps->extensionVersion = 0;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	int GetCounterSource( int, GPUDetect::ICounterSource** counters ) override
+	{
+		*counters = m_counters;
+		return EXIT_SUCCESS;
+	}
+
+private:
+	GPUDetect::DeviceCaps m_caps;
+	GPUDetect::ICounterSource* m_counters;
+};
+
+/*******************************************************************************
+ * Fnv1a
+ *
+ *     The checksum of recording files, to write damaged files that still
+ *     pass it.
+ *
+ ******************************************************************************/
+uint32_t Fnv1a( const uint8_t* bytes, size_t size )
+{
+	uint32_t hash = 2166136261u;
+	for( size_t i = 0; i < size; ++i )
+	{
+		hash ^= bytes[ i ];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool WriteBytes( const char* fileName, const std::vector< uint8_t >& bytes )
+{
+	FILE* file = fopen( fileName, "wb" );
+	if( file == nullptr )
+	{
+		return false;
+	}
+	const bool written = fwrite( bytes.data(), 1, bytes.size(), file ) == bytes.size();
+	return fclose( file ) == 0 && written;
+}
+
+std::vector< uint8_t > ReadBytes( const char* fileName )
+{
+	std::vector< uint8_t > bytes;
+	FILE* file = fopen( fileName, "rb" );
+	if( file != nullptr )
+	{
+		uint8_t buffer[ 4096 ];
+		size_t bytesRead = 0;
+		while( ( bytesRead = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+		{
+			bytes.insert( bytes.end(), buffer, buffer + bytesRead );
+		}
+		fclose( file );
+	}
+	return bytes;
+}
+
+/*******************************************************************************
+ * CheckReplayRoundTrip
+ *
+ *     Records InitAll on mock sources, saves and loads the recording, and
+ *     checks that the registry was walked once for all adapters and that
+ *     replaying it gives the same GPUData, including a description outside
+ *     ASCII. Then checks that damaged files are
+ *     rejected: a changed byte, a truncated file, a truncated file with a
+ *     matching checksum, an empty and a missing file.
+ *
+ ******************************************************************************/
+bool CheckReplayRoundTrip()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "replaycheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	const char* const fileName = "GPUDetectBench_replaycheck.gpdr";
+
+	// An Intel dGPU and another vendor's, which has no counter to read
+	const WCHAR intelDescription[] = L"Intel\u00AE Arc\u2122 A770 Graphics";
+	std::vector< GPUDetect::AdapterDesc > descs( 2 );
+	descs[ 0 ].vendorID = kIntelVendorID;
+	descs[ 0 ].deviceID = 0x56A0;
+	descs[ 0 ].adapterLUID.LowPart = 0x10000;
+	memcpy( descs[ 0 ].description, intelDescription, sizeof( intelDescription ) );
+	descs[ 0 ].dedicatedVideoMemory = 16ull << 30;
+	descs[ 0 ].sharedSystemMemory = 8ull << 30;
+	descs[ 1 ].vendorID = 0x10DE;
+	descs[ 1 ].deviceID = 0x2204;
+	descs[ 1 ].adapterLUID.LowPart = 0x10001;
+	wcscpy( descs[ 1 ].description, L"Other Vendor Graphics" );
+	descs[ 1 ].dedicatedVideoMemory = 24ull << 30;
+	descs[ 1 ].sharedSystemMemory = 8ull << 30;
+
+	MockAdapterSource adapters( descs );
+	MockCounterSource counters( 30, 29 );
+	counters.m_maxFrequency = 2400;
+	counters.m_minFrequency = 300;
+	MockDeviceSource devices( { 0, 0x00010000, 0x001F000400000001ull }, &counters );
+	MockRegistrySource registry( 10, (int) descs.size() );
+	GPUDetect::DriverVersionCache driverVersions;
+	const GPUDetect::BackendSources mockSources = { &adapters, &devices, &registry, &driverVersions };
+
+	const int adapterCount = (int) descs.size();
+	std::vector< GPUDetect::GPUData > recorded( adapterCount );
+	std::vector< int > recordedCodes( adapterCount );
+	{
+		GPUDetect::BackendRecording recording;
+		const GPUDetect::BackendSources sources = recording.Record( mockSources );
+		unsigned int firstAdapterReads = 0;
+		for( int i = 0; i < adapterCount; ++i )
+		{
+			// Zeroed padding too, so that the results can be compared with memcmp
+			memset( &recorded[ i ], 0, sizeof( GPUDetect::GPUData ) );
+			recordedCodes[ i ] = GPUDetect::InitAll( &recorded[ i ], sources, i );
+			firstAdapterReads = i == 0 ? registry.m_valueReads : firstAdapterReads;
+		}
+		expect( firstAdapterReads != 0 && registry.m_valueReads == firstAdapterReads, "registry was not walked once for all adapters" );
+		expect( recording.Save( fileName ) == EXIT_SUCCESS, "recording could not be saved" );
+	}
+
+	expect( recordedCodes[ 0 ] == EXIT_SUCCESS && recorded[ 0 ].maxFrequency == 2400 && recorded[ 0 ].dxDriverVersion[ 3 ] == 10 &&
+		wcscmp( recorded[ 0 ].description, intelDescription ) == 0, "recorded Intel adapter is wrong" );
+	expect( recordedCodes[ 1 ] == GPUDETECT_ERROR_NOT_SUPPORTED && recorded[ 1 ].dxDriverVersion[ 3 ] == 11, "recorded other adapter is wrong" );
+
+	GPUDetect::BackendRecording replay;
+	expect( replay.Load( fileName ) == EXIT_SUCCESS, "recording could not be loaded" );
+	const GPUDetect::BackendSources sources = replay.Replay( false );
+	expect( sources.adapters->GetAdapterCount() == adapterCount, "replayed adapter count differs" );
+	for( int i = 0; i < adapterCount; ++i )
+	{
+		GPUDetect::GPUData gpuData;
+		memset( &gpuData, 0, sizeof( gpuData ) );
+		const int returnCode = GPUDetect::InitAll( &gpuData, sources, i );
+		expect( returnCode == recordedCodes[ i ] && memcmp( &gpuData, &recorded[ i ], sizeof( gpuData ) ) == 0, "replayed GPUData differs" );
+	}
+
+	// Damaged files
+	const std::vector< uint8_t > bytes = ReadBytes( fileName );
+	expect( bytes.size() > 64, "saved recording is too short" );
+	if( bytes.size() > 64 )
+	{
+		std::vector< uint8_t > changed = bytes;
+		changed[ changed.size() / 2 ] ^= 0x01;
+
+		const std::vector< uint8_t > truncated( bytes.begin(), bytes.begin() + bytes.size() / 2 );
+
+		// Records cut short, behind a checksum that matches, to reach the parser
+		std::vector< uint8_t > resealed( bytes.begin(), bytes.begin() + bytes.size() / 2 );
+		const uint32_t checksum = Fnv1a( resealed.data(), resealed.size() );
+		for( int shift = 0; shift < 32; shift += 8 )
+		{
+			resealed.push_back( (uint8_t) ( checksum >> shift ) );
+		}
+
+		const struct
+		{
+			const std::vector< uint8_t >& bytes;
+			const char* what;
+		}
+		damagedFiles[] =
+		{
+			{ changed, "file with a changed byte was loaded" },
+			{ truncated, "truncated file was loaded" },
+			{ resealed, "truncated file with a matching checksum was loaded" },
+			{ std::vector< uint8_t >(), "empty file was loaded" },
+		};
+
+		for( const auto& damaged : damagedFiles )
+		{
+			GPUDetect::BackendRecording recording;
+			expect( WriteBytes( fileName, damaged.bytes ) && recording.Load( fileName ) == GPUDETECT_ERROR_REPLAY_FILE, damaged.what );
+		}
+	}
+
+	remove( fileName );
+
+	GPUDetect::BackendRecording missing;
+	expect( missing.Load( fileName ) == GPUDETECT_ERROR_REPLAY_FILE, "missing file was loaded" );
+
+	fprintf( stdout, "{\"check\":\"replaycheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckDetectionCache
+ *
+ *     Checks InitAllCached on a mock adapter: a miss runs the detection and
+ *     a second call is a hit that replays its result, a new driver version
+ *     is a miss, and failed detections are not kept. Then checks that
+ *     damaged cache files are misses that get rewritten: a bad magic,
+ *     format version or GPUData size behind a matching checksum, a flipped
+ *     byte, and a truncated file.
+ *
+ ******************************************************************************/
+class MockCacheSource : public GPUDetect::ICacheSource
+{
+public:
+	uint64_t m_driverVersion = 1;
+	int m_returnCode = EXIT_SUCCESS;
+	unsigned int m_detectCount = 0;
+
+	int GetAdapterFingerprint( GPUDetect::GPUData* const gpuData, uint64_t* driverVersion ) override
+	{
+		gpuData->vendorID = kIntelVendorID;
+		gpuData->deviceID = 0x56A0;
+		gpuData->adapterLUID.LowPart = 0x10000;
+		*driverVersion = m_driverVersion;
+		return EXIT_SUCCESS;
+	}
+
+	int InitAll( GPUDetect::GPUData* const gpuData ) override
+	{
+		++m_detectCount;
+		uint64_t driverVersion = 0;
+		GetAdapterFingerprint( gpuData, &driverVersion );
+		gpuData->dxAdapterAvailability = true;
+		gpuData->maxFrequency = (unsigned int) ( 2000 + m_driverVersion );
+		return m_returnCode;
+	}
+};
+
+bool CheckDetectionCache()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "cachecheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	const char* const fileName = "GPUDetectBench_cachecheck.bin";
+	remove( fileName );
+
+	MockCacheSource source;
+	GPUDetect::GPUData gpuData = {};
+
+	// Runs InitAllCached and returns whether it detected instead of hitting
+	const auto detected = [ & ]( int* returnCode )
+	{
+		const unsigned int detectCount = source.m_detectCount;
+		gpuData = {};
+		*returnCode = GPUDetect::InitAllCached( &gpuData, &source, fileName );
+		return source.m_detectCount != detectCount;
+	};
+
+	int returnCode = 0;
+	expect( detected( &returnCode ) && returnCode == EXIT_SUCCESS, "missing file was not a miss" );
+	expect( !detected( &returnCode ) && returnCode == EXIT_SUCCESS, "second call was not a hit" );
+	expect( gpuData.dxAdapterAvailability && gpuData.maxFrequency == 2001, "hit did not replay the detected GPUData" );
+
+	source.m_driverVersion = 2;
+	expect( detected( &returnCode ) && gpuData.maxFrequency == 2002, "new driver version was not a miss" );
+	expect( !detected( &returnCode ) && gpuData.maxFrequency == 2002, "new driver version was not stored" );
+
+	// Only the latest driver of an adapter is kept
+	source.m_driverVersion = 1;
+	expect( detected( &returnCode ), "entry of the old driver version was kept" );
+
+	// Non-Intel adapters are kept with their return code, errors are not
+	source.m_driverVersion = 3;
+	source.m_returnCode = GPUDETECT_ERROR_NOT_SUPPORTED;
+	expect( detected( &returnCode ) && returnCode == GPUDETECT_ERROR_NOT_SUPPORTED, "detection return code was not returned" );
+	expect( !detected( &returnCode ) && returnCode == GPUDETECT_ERROR_NOT_SUPPORTED, "GPUDETECT_ERROR_NOT_SUPPORTED was not replayed" );
+	source.m_driverVersion = 4;
+	source.m_returnCode = GPUDETECT_ERROR_GENERIC;
+	expect( detected( &returnCode ) && detected( &returnCode ), "failed detection was cached" );
+	source.m_returnCode = EXIT_SUCCESS;
+
+	// A valid file to damage, with one entry
+	remove( fileName );
+	expect( detected( &returnCode ), "missing file was not a miss" );
+	const std::vector< uint8_t > bytes = ReadBytes( fileName );
+	expect( bytes.size() > 20, "cache file is too short" );
+	if( bytes.size() > 20 )
+	{
+		// Header fields are uint32_t at offsets 0, 4 and 8: magic, format
+		// version and sizeof( GPUData ). Each is changed behind a recomputed
+		// checksum, so only the field check can reject it.
+		const auto resealed = [ &bytes ]( size_t offset )
+		{
+			std::vector< uint8_t > damaged = bytes;
+			damaged[ offset ] ^= 0x01;
+			const uint32_t checksum = Fnv1a( damaged.data(), damaged.size() - 4 );
+			memcpy( &damaged[ damaged.size() - 4 ], &checksum, sizeof( checksum ) );
+			return damaged;
+		};
+
+		std::vector< uint8_t > flipped = bytes;
+		flipped[ bytes.size() / 2 ] ^= 0x01;
+
+		const struct
+		{
+			std::vector< uint8_t > bytes;
+			const char* what;
+		}
+		damagedFiles[] =
+		{
+			{ resealed( 0 ), "bad magic was a hit" },
+			{ resealed( 4 ), "bad format version was a hit" },
+			{ resealed( 8 ), "bad GPUData size was a hit" },
+			{ flipped, "flipped byte was a hit" },
+			{ std::vector< uint8_t >( bytes.begin(), bytes.end() - 1 ), "truncated file was a hit" },
+		};
+
+		for( const auto& damaged : damagedFiles )
+		{
+			expect( WriteBytes( fileName, damaged.bytes ) && detected( &returnCode ), damaged.what );
+			expect( ReadBytes( fileName ) == bytes, "damaged file was not rewritten" );
+		}
+	}
+
+	remove( fileName );
+
+	fprintf( stdout, "{\"check\":\"cachecheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckUploadAdvice
+ *
+ *     Checks GetUploadAdvice against a table of integrated and discrete
+ *     GPUs: shared memory with and without the Intel extension, and local
+ *     memory behind a small BAR, a resizable BAR and an unknown one.
+ *
+ ******************************************************************************/
+bool CheckUploadAdvice()
+{
+	unsigned int failures = 0;
+
+	const uint64_t kVideoMemory = 16ull << 30;
+	const struct
+	{
+		const char* gpu;
+		bool isUMAArchitecture;
+		bool intelExtensionAvailability;
+		uint64_t cpuVisibleLocalMemory;
+		GPUDetect::UploadAdvice advice[ GPUDetect::UPLOAD_CLASS_COUNT ];   // by UploadResourceClass
+	}
+	cases[] =
+	{
+		{ "uma", true, false, 0, {
+			{ GPUDetect::UPLOAD_DIRECT_WRITE, 256 }, { GPUDetect::UPLOAD_DIRECT_WRITE, 64 },
+			{ GPUDetect::UPLOAD_DIRECT_WRITE, 64 }, { GPUDetect::UPLOAD_STAGING_COPY, 512 } } },
+		{ "uma_extension", true, true, 0, {
+			{ GPUDetect::UPLOAD_DIRECT_WRITE, 256 }, { GPUDetect::UPLOAD_DIRECT_WRITE, 64 },
+			{ GPUDetect::UPLOAD_DIRECT_WRITE, 64 }, { GPUDetect::UPLOAD_DIRECT_ACCESS, 4096 } } },
+		{ "dgpu_small_bar", false, true, 256ull << 20, {
+			{ GPUDetect::UPLOAD_BAR_WRITE, 256 }, { GPUDetect::UPLOAD_BAR_WRITE, 64 },
+			{ GPUDetect::UPLOAD_STAGING_COPY, 256 }, { GPUDetect::UPLOAD_STAGING_COPY, 512 } } },
+		{ "dgpu_rebar", false, true, kVideoMemory, {
+			{ GPUDetect::UPLOAD_BAR_WRITE, 256 }, { GPUDetect::UPLOAD_BAR_WRITE, 64 },
+			{ GPUDetect::UPLOAD_BAR_WRITE, 64 }, { GPUDetect::UPLOAD_STAGING_COPY, 512 } } },
+		{ "dgpu_unknown_bar", false, false, 0, {
+			{ GPUDetect::UPLOAD_BAR_WRITE, 256 }, { GPUDetect::UPLOAD_BAR_WRITE, 64 },
+			{ GPUDetect::UPLOAD_STAGING_COPY, 256 }, { GPUDetect::UPLOAD_STAGING_COPY, 512 } } },
+	};
+
+	for( const auto& testCase : cases )
+	{
+		GPUDetect::GPUData gpuData = {};
+		gpuData.vendorID = kIntelVendorID;
+		gpuData.isUMAArchitecture = testCase.isUMAArchitecture;
+		gpuData.intelExtensionAvailability = testCase.intelExtensionAvailability;
+		gpuData.videoMemory = kVideoMemory;
+
+		for( int resourceClass = 0; resourceClass < GPUDetect::UPLOAD_CLASS_COUNT; ++resourceClass )
+		{
+			const GPUDetect::UploadAdvice& expected = testCase.advice[ resourceClass ];
+			GPUDetect::UploadAdvice advice = {};
+			const int returnCode = GPUDetect::GetUploadAdvice( &gpuData, testCase.cpuVisibleLocalMemory, (GPUDetect::UploadResourceClass) resourceClass, &advice );
+			if( returnCode != EXIT_SUCCESS || advice.path != expected.path || advice.alignment != expected.alignment )
+			{
+				fprintf( stderr, "uploadcheck: %s class %d: got %s/%u, expected %s/%u\n", testCase.gpu, resourceClass,
+					GPUDetect::GetUploadPathName( advice.path ), advice.alignment, GPUDetect::GetUploadPathName( expected.path ), expected.alignment );
+				++failures;
+			}
+		}
+	}
+
+	GPUDetect::GPUData gpuData = {};
+	GPUDetect::UploadAdvice advice = {};
+	if( GPUDetect::GetUploadAdvice( &gpuData, 0, GPUDetect::UPLOAD_CLASS_COUNT, &advice ) != GPUDETECT_ERROR_BAD_DATA ||
+		GPUDetect::GetUploadAdvice( nullptr, 0, GPUDetect::UPLOAD_CLASS_TEXTURE, &advice ) != GPUDETECT_ERROR_BAD_DATA )
+	{
+		fprintf( stderr, "uploadcheck: invalid arguments were accepted\n" );
+		++failures;
+	}
+
+	fprintf( stdout, "{\"check\":\"uploadcheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckThroughputScore
+ *
+ *     Checks GetThroughputScore against a table of GPUs: from their counters
+ *     and from the typical figures of their architecture, integrated and
+ *     discrete, and with an architecture that is unknown to GPUDetect, which
+ *     only scores with counters. The expected figures are worked out by hand
+ *     from the per-EU rates and bandwidths in GPUDetectScore.cpp.
+ *
+ ******************************************************************************/
+bool CheckThroughputScore()
+{
+	unsigned int failures = 0;
+
+	// What the counters report; euCount and maxFillRate need the advanced
+	// counter data, maxFrequency any counter data
+	enum Counters
+	{
+		COUNTERS_NONE,
+		COUNTERS_FREQUENCY,
+		COUNTERS_ALL,
+	};
+
+	const struct
+	{
+		const char* what;
+		unsigned int deviceID;
+		unsigned int architecture;
+		bool isUMA;
+		Counters counters;
+		unsigned int euCount;
+		unsigned int maxFillRate;
+		unsigned int maxFrequency;
+		int returnCode;
+		bool estimated;
+		float fp32Gflops;
+		float bandwidthGBs;
+		GPUDetect::MemoryBandwidthClass bandwidthClass;
+		float score;
+	}
+	cases[] =
+	{
+		// The reference GPU scores 1, from its counters or its architecture
+		{ "HD 620 from counters", 0x5916, GPUDetect::IGFX_KABYLAKE, true, COUNTERS_ALL, 24, 8, 1050,
+			EXIT_SUCCESS, false, 403.2f, 38.4f, GPUDetect::BANDWIDTH_LOW, 1.0f },
+		{ "Skylake from the device ID table", 0x1916, GPUDetect::IGFX_UNKNOWN, true, COUNTERS_NONE, 0, 0, 0,
+			EXIT_SUCCESS, true, 403.2f, 38.4f, GPUDetect::BANDWIDTH_LOW, 1.0f },
+		{ "Kaby Lake with only its frequency", 0x5916, GPUDetect::IGFX_KABYLAKE, true, COUNTERS_FREQUENCY, 0, 0, 1150,
+			EXIT_SUCCESS, true, 441.6f, 38.4f, GPUDetect::BANDWIDTH_LOW, 1.0755f },
+
+		// The same GPU, sharing system memory or with memory of its own
+		{ "Tiger Lake, UMA", 0x9A49, GPUDetect::IGFX_TIGERLAKE_LP, true, COUNTERS_ALL, 96, 24, 1350,
+			EXIT_SUCCESS, false, 2073.6f, 68.3f, GPUDetect::BANDWIDTH_MEDIUM, 3.9264f },
+		{ "Tiger Lake, discrete", 0x9A49, GPUDetect::IGFX_TIGERLAKE_LP, false, COUNTERS_ALL, 96, 24, 1350,
+			EXIT_SUCCESS, false, 2073.6f, 104.64f, GPUDetect::BANDWIDTH_MEDIUM, 4.2761f },
+		{ "DG1 from its architecture", 0x4905, GPUDetect::IGFX_DG1, false, COUNTERS_NONE, 0, 0, 0,
+			EXIT_SUCCESS, true, 2112.0f, 68.3f, GPUDetect::BANDWIDTH_MEDIUM, 3.9845f },
+		{ "Alchemist from counters", 0x56A0, GPUDetect::DGFX_ACM, false, COUNTERS_ALL, 512, 128, 2100,
+			EXIT_SUCCESS, false, 17203.2f, 558.08f, GPUDetect::BANDWIDTH_VERY_HIGH, 37.3046f },
+
+		// An architecture newer than GPUDetect gets the generic rates
+		{ "unknown architecture from counters", 0x7D55, 0x27, true, COUNTERS_ALL, 128, 32, 2250,
+			EXIT_SUCCESS, false, 4608.0f, 68.3f, GPUDetect::BANDWIDTH_MEDIUM, 7.4374f },
+		{ "unknown architecture without counters", 0x7D55, 0x27, true, COUNTERS_NONE, 0, 0, 0,
+			GPUDETECT_ERROR_NOT_SUPPORTED, false, 0.0f, 0.0f, GPUDetect::BANDWIDTH_LOW, 0.0f },
+	};
+
+	const auto near = []( float value, float expected )
+	{
+		return fabs( value - expected ) <= expected * 1e-4f;
+	};
+
+	for( const auto& testCase : cases )
+	{
+		GPUDetect::GPUData gpuData = {};
+		gpuData.vendorID = kIntelVendorID;
+		gpuData.deviceID = testCase.deviceID;
+		gpuData.architecture = (GPUDetect::INTEL_GPU_ARCHITECTURE) testCase.architecture;
+		gpuData.isUMAArchitecture = testCase.isUMA;
+		gpuData.counterAvailability = testCase.counters != COUNTERS_NONE;
+		gpuData.advancedCounterDataAvailability = testCase.counters == COUNTERS_ALL;
+		gpuData.euCount = testCase.euCount;
+		gpuData.maxFillRate = testCase.maxFillRate;
+		gpuData.maxFrequency = testCase.maxFrequency;
+
+		GPUDetect::ThroughputScore score = {};
+		const int returnCode = GPUDetect::GetThroughputScore( &gpuData, &score );
+		if( returnCode != testCase.returnCode ||
+			( returnCode == EXIT_SUCCESS &&
+				( score.estimated != testCase.estimated || !near( score.fp32Gflops, testCase.fp32Gflops ) ||
+					!near( score.bandwidthGBs, testCase.bandwidthGBs ) || score.bandwidthClass != testCase.bandwidthClass ||
+					!near( score.score, testCase.score ) ) ) )
+		{
+			fprintf( stderr, "scorecheck: %s: got %d, %.1f GFLOPS, %.2f GB/s, score %.4f%s\n",
+				testCase.what, returnCode, score.fp32Gflops, score.bandwidthGBs, score.score, score.estimated ? " (estimated)" : "" );
+			++failures;
+		}
+	}
+
+	GPUDetect::GPUData otherVendor = {};
+	otherVendor.vendorID = 0x10DE;
+	otherVendor.deviceID = 0x2204;
+	GPUDetect::ThroughputScore score = {};
+	if( GPUDetect::GetThroughputScore( &otherVendor, &score ) != GPUDETECT_ERROR_NOT_SUPPORTED ||
+		GPUDetect::GetThroughputScore( nullptr, &score ) != GPUDETECT_ERROR_BAD_DATA )
+	{
+		fprintf( stderr, "scorecheck: other vendor or invalid arguments were scored\n" );
+		++failures;
+	}
+
+	fprintf( stdout, "{\"check\":\"scorecheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+#ifdef __linux__
+
+/*******************************************************************************
+ * WriteFixtureValue
+ *
+ *     Rewrites a fixture attribute in place, as the kernel would update it,
+ *     so that a sampler's open file sees the new value.
+ *
+ ******************************************************************************/
+bool WriteFixtureValue( const char* fileName, uint64_t value )
+{
+	char text[ 24 ];
+	const int length = snprintf( text, sizeof( text ), "%llu\n", (unsigned long long) value );
+	return WriteBytes( fileName, std::vector< uint8_t >( text, text + length ) );
+}
+
+/*******************************************************************************
+ * CheckSysfsAdapters
+ *
+ *     Checks EnumerateSysfsAdapters and InitSysfsInfo on the fake DRM tree in
+ *     fixtures/sysfs: an integrated GPU, an i915 discrete GPU reporting
+ *     lmem_total_bytes, an xe one reporting two tiles of VRAM, and a
+ *     display-only card and connectors that are not adapters.
+ *
+ ******************************************************************************/
+bool CheckSysfsAdapters()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "sysfscheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	std::vector< GPUDetect::GPUData > adapters;
+	int returnCode = GPUDetect::EnumerateSysfsAdapters( "fixtures/sysfs", &adapters );
+	expect( returnCode == EXIT_SUCCESS && adapters.size() == 3, "fixtures/sysfs did not enumerate 3 adapters; run from the repository root" );
+	if( adapters.size() == 3 )
+	{
+		const GPUDetect::GPUData& igpu = adapters[ 0 ];
+		expect( igpu.vendorID == kIntelVendorID && igpu.deviceID == 0x9A49 && igpu.architecture == GPUDetect::IGFX_TIGERLAKE_LP, "iGPU IDs are wrong" );
+		expect( igpu.isUMAArchitecture && igpu.videoMemory != 0, "iGPU is not UMA" );
+		expect( igpu.adapterLUID.HighPart == 0 && igpu.adapterLUID.LowPart == ( 2 << 3 ), "iGPU LUID is not its PCI slot" );
+		expect( wcscmp( igpu.description, L"i915 (0000:00:02.0)" ) == 0, "iGPU description is wrong" );
+
+		const GPUDetect::GPUData& i915 = adapters[ 1 ];
+		expect( i915.deviceID == 0x56A0 && !i915.isUMAArchitecture, "i915 dGPU is UMA" );
+		expect( i915.videoMemory == 17163091968ull, "i915 dGPU did not use lmem_total_bytes" );
+		expect( i915.adapterLUID.LowPart == ( 3 << 8 ), "i915 dGPU LUID is not its PCI slot" );
+
+		const GPUDetect::GPUData& xe = adapters[ 2 ];
+		expect( xe.deviceID == 0x56A1 && !xe.isUMAArchitecture, "xe dGPU is UMA" );
+		expect( xe.videoMemory == 16ull << 30, "xe dGPU did not sum the VRAM of its tiles" );
+
+		for( int i = 0; i < 3; ++i )
+		{
+			GPUDetect::GPUData gpuData = {};
+			returnCode = GPUDetect::InitSysfsInfo( &gpuData, i, "fixtures/sysfs" );
+			expect( returnCode == EXIT_SUCCESS && gpuData.deviceID == adapters[ i ].deviceID && gpuData.videoMemory == adapters[ i ].videoMemory,
+				"InitSysfsInfo differs from the enumeration" );
+		}
+	}
+
+	uint64_t barBytes = 0;
+	expect( GPUDetect::GetCpuVisibleLocalMemory( 1, "fixtures/sysfs", &barBytes ) == EXIT_SUCCESS && barBytes == 256ull << 20, "i915 dGPU BAR is not 256 MB" );
+	expect( GPUDetect::GetCpuVisibleLocalMemory( 2, "fixtures/sysfs", &barBytes ) == EXIT_SUCCESS && barBytes == 16ull << 30, "xe dGPU BAR is not resizable" );
+
+	GPUDetect::GPUData gpuData = {};
+	expect( GPUDetect::InitSysfsInfo( &gpuData, 3, "fixtures/sysfs" ) == GPUDETECT_ERROR_SYSFS_NO_ADAPTER, "display-only card was counted" );
+	expect( GPUDetect::InitSysfsInfo( &gpuData, 0, "fixtures/missing" ) == GPUDETECT_ERROR_SYSFS_NO_DRM, "missing tree did not fail" );
+
+	fprintf( stdout, "{\"check\":\"sysfscheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckFrequencySampler
+ *
+ *     Checks FrequencySampler on the i915 gt_*_freq_mhz files of card0 and
+ *     the xe tile0/gt0/freq0 files of card2 in fixtures/sysfs. The files are
+ *     rewritten before each sample and restored afterwards. The window
+ *     statistics must cover only the last 4 samples, and the histogram must
+ *     hold time in the bucket of each sample's actual frequency but the last.
+ *
+ ******************************************************************************/
+bool CheckFrequencySampler()
+{
+	unsigned int failures = 0;
+	char prefix[ 16 ];
+	const char* driver = "";
+	const auto expect = [ &failures, &driver ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "freqcheck: %s%s\n", driver, what );
+			++failures;
+		}
+	};
+
+	const struct
+	{
+		const char* driver;
+		int adapterIndex;
+		const char* curFile;
+		const char* actFile;
+	}
+	layouts[] =
+	{
+		{ "i915", 0, "fixtures/sysfs/class/drm/card0/gt_cur_freq_mhz", "fixtures/sysfs/class/drm/card0/gt_act_freq_mhz" },
+		{ "xe", 2, "fixtures/sysfs/class/drm/card2/device/tile0/gt0/freq0/cur_freq", "fixtures/sysfs/class/drm/card2/device/tile0/gt0/freq0/act_freq" },
+	};
+
+	// Requested and actual MHz. 3900 MHz is beyond the last bucket.
+	const unsigned int samples[][ 2 ] = { { 300, 300 }, { 1200, 1150 }, { 2400, 2350 }, { 1200, 1100 }, { 4000, 3900 }, { 600, 550 } };
+	const size_t sampleCount = sizeof( samples ) / sizeof( samples[ 0 ] );
+
+	for( const auto& layout : layouts )
+	{
+		snprintf( prefix, sizeof( prefix ), "%s: ", layout.driver );
+		driver = prefix;
+		const std::vector< uint8_t > curOriginal = ReadBytes( layout.curFile );
+		const std::vector< uint8_t > actOriginal = ReadBytes( layout.actFile );
+
+		GPUDetect::FrequencySampler sampler( 4 );
+		if( sampler.Open( layout.adapterIndex, "fixtures/sysfs" ) != EXIT_SUCCESS )
+		{
+			expect( false, "fixtures/sysfs could not be opened; run from the repository root" );
+			continue;
+		}
+
+		bool sampled = true;
+		for( const auto& sample : samples )
+		{
+			sampled = WriteFixtureValue( layout.curFile, sample[ 0 ] ) && WriteFixtureValue( layout.actFile, sample[ 1 ] ) &&
+				sampler.Sample() == EXIT_SUCCESS && sampled;
+
+			// So that each sample's time is at least a microsecond
+			std::this_thread::sleep_for( std::chrono::milliseconds( 2 ) );
+		}
+		WriteBytes( layout.curFile, curOriginal );
+		WriteBytes( layout.actFile, actOriginal );
+
+		GPUDetect::FrequencyStats stats;
+		sampler.GetStats( &stats );
+		expect( sampled && stats.sampleCount == sampleCount, "samples could not be taken" );
+		expect( stats.lastCurMHz == 600 && stats.lastActMHz == 550, "last sample is wrong" );
+		expect( stats.windowSampleCount == 4, "window is not 4 samples" );
+		expect( stats.curMinMHz == 600 && stats.curAvgMHz == 2050 && stats.curMaxMHz == 4000, "requested min/avg/max are not over the window" );
+		expect( stats.actMinMHz == 550 && stats.actAvgMHz == 1975 && stats.actMaxMHz == 3900, "actual min/avg/max are not over the window" );
+
+		// 300, 1150, 2350, 1100 and 3900 MHz; the last sample has no time yet
+		const unsigned int expectedBuckets[] = { 6, 23, 47, 22, GPUDetect::FrequencyStats::HISTOGRAM_BUCKET_COUNT - 1 };
+		bool histogramValid = true;
+		for( unsigned int bucket = 0; bucket < GPUDetect::FrequencyStats::HISTOGRAM_BUCKET_COUNT; ++bucket )
+		{
+			const bool expected = std::find( std::begin( expectedBuckets ), std::end( expectedBuckets ), bucket ) != std::end( expectedBuckets );
+			histogramValid = histogramValid && ( stats.timeAtFrequencyUs[ bucket ] != 0 ) == expected;
+		}
+		expect( histogramValid, "histogram holds time in the wrong buckets" );
+
+		sampler.Reset();
+		sampler.GetStats( &stats );
+		expect( stats.sampleCount == 0 && stats.windowSampleCount == 0 && stats.timeAtFrequencyUs[ 6 ] == 0, "Reset did not clear the statistics" );
+	}
+
+	// The i915 dGPU of the fixtures has no frequency files
+	driver = "";
+	GPUDetect::FrequencySampler sampler;
+	expect( sampler.Open( 1, "fixtures/sysfs" ) == GPUDETECT_ERROR_NOT_SUPPORTED, "card without frequency files was opened" );
+	expect( sampler.Sample() == GPUDETECT_ERROR_BAD_DATA, "sampler that is not open sampled" );
+
+	fprintf( stdout, "{\"check\":\"freqcheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckPowerSampler
+ *
+ *     Checks PowerSampler on fixtures/sysfs: the hwmon energy1_input of the
+ *     i915 and xe discrete GPUs, and the RAPL package counter for the
+ *     integrated GPU, which wraps past max_energy_range_uj between the two
+ *     samples. The counters are rewritten between samples and restored
+ *     afterwards. The energy must be exact, and the power and fraction of
+ *     TDP must follow from it and the time between the samples.
+ *
+ ******************************************************************************/
+bool CheckPowerSampler()
+{
+	unsigned int failures = 0;
+	char prefix[ 16 ];
+	const char* counter = "";
+	const auto expect = [ &failures, &counter ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "powercheck: %s%s\n", counter, what );
+			++failures;
+		}
+	};
+
+	const struct
+	{
+		const char* name;
+		int adapterIndex;
+		unsigned int packageTDP;
+		const char* energyFile;
+		GPUDetect::PowerStats::Source source;
+		uint64_t firstUj;
+		uint64_t secondUj;
+		uint64_t expectedUj;
+	}
+	cases[] =
+	{
+		{ "i915", 1, 225, "fixtures/sysfs/class/drm/card1/device/hwmon/hwmon3/energy1_input",
+			GPUDetect::PowerStats::SOURCE_HWMON, 5000000000ull, 5002000000ull, 2000000 },
+		{ "xe", 2, 225, "fixtures/sysfs/class/drm/card2/device/hwmon/hwmon4/energy1_input",
+			GPUDetect::PowerStats::SOURCE_HWMON, 7000000000ull, 7003000000ull, 3000000 },
+		// 328,850 uJ up to max_energy_range_uj, then 1,000,000 uJ after the wrap
+		{ "rapl", 0, 15, "fixtures/sysfs/class/powercap/intel-rapl:0/energy_uj",
+			GPUDetect::PowerStats::SOURCE_RAPL_PACKAGE, 262143000000ull, 1000000, 1328850 },
+	};
+
+	const unsigned int kIntervalMs = 50;
+	for( const auto& testCase : cases )
+	{
+		snprintf( prefix, sizeof( prefix ), "%s: ", testCase.name );
+		counter = prefix;
+		const std::vector< uint8_t > original = ReadBytes( testCase.energyFile );
+
+		GPUDetect::PowerSampler sampler( 1000 );
+		bool sampled = WriteFixtureValue( testCase.energyFile, testCase.firstUj );
+		if( !sampled || sampler.Open( testCase.adapterIndex, "fixtures/sysfs", testCase.packageTDP ) != EXIT_SUCCESS )
+		{
+			expect( false, "fixtures/sysfs could not be opened; run from the repository root" );
+			WriteBytes( testCase.energyFile, original );
+			continue;
+		}
+
+		sampled = sampler.Sample() == EXIT_SUCCESS;
+		std::this_thread::sleep_for( std::chrono::milliseconds( kIntervalMs ) );
+		sampled = WriteFixtureValue( testCase.energyFile, testCase.secondUj ) && sampler.Sample() == EXIT_SUCCESS && sampled;
+		WriteBytes( testCase.energyFile, original );
+
+		GPUDetect::PowerStats stats;
+		sampler.GetStats( &stats );
+		expect( sampled && stats.sampleCount == 2, "samples could not be taken" );
+		expect( stats.source == testCase.source, "wrong counter was opened" );
+		expect( stats.totalEnergyUj == testCase.expectedUj, "energy is wrong" );
+
+		// uJ / us is W; the interval is at least kIntervalMs, and far less than a second
+		const double expectedWatts = stats.windowUs != 0 ? (double) testCase.expectedUj / stats.windowUs : 0.0;
+		expect( stats.windowUs >= kIntervalMs * 1000 && stats.windowUs < 1000000, "window does not span the two samples" );
+		expect( fabs( stats.averageWatts - expectedWatts ) <= expectedWatts * 1e-4, "averageWatts does not follow from the energy" );
+		expect( fabs( stats.fractionOfTDP - expectedWatts / testCase.packageTDP ) <= expectedWatts / testCase.packageTDP * 1e-4, "fractionOfTDP does not follow from averageWatts" );
+	}
+
+	counter = "";
+	GPUDetect::PowerSampler sampler;
+	expect( sampler.Sample() == GPUDETECT_ERROR_BAD_DATA, "sampler that is not open sampled" );
+
+	fprintf( stdout, "{\"check\":\"powercheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+/*******************************************************************************
+ * CheckCPUSysfs
+ *
+ *     Checks InitCPUSysfsInfo on the fake sysfs tree in fixtures/sysfs: two
+ *     cores with SMT siblings, one without, an offline CPU and three cache
+ *     levels. A missing tree and a root too long for a path must fail.
+ *
+ ******************************************************************************/
+bool CheckCPUSysfs()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "cpucheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	GPUDetect::CPUData cpuData = {};
+	const int returnCode = GPUDetect::InitCPUSysfsInfo( &cpuData, "fixtures/sysfs" );
+	expect( returnCode == EXIT_SUCCESS, "fixtures/sysfs could not be read; run from the repository root" );
+	expect( cpuData.logicalCoreCount == 5, "offline CPU was counted, or an online one was not" );
+	expect( cpuData.physicalCoreCount == 3, "SMT siblings were not counted as one core" );
+	expect( cpuData.l1DataCacheKB == 48 && cpuData.l2CacheKB == 1280 && cpuData.l3CacheKB == 18 * 1024, "cache sizes are wrong" );
+
+	cpuData = {};
+	expect( GPUDetect::InitCPUSysfsInfo( &cpuData, "fixtures/missing" ) == GPUDETECT_ERROR_SYSFS_READ, "missing tree did not fail" );
+
+	const std::string longRoot = "fixtures/sysfs/" + std::string( GPUDetect::kMaxSysfsPath, 'x' );
+	expect( GPUDetect::InitCPUSysfsInfo( &cpuData, longRoot.c_str() ) == GPUDETECT_ERROR_SYSFS_READ, "root too long for a path did not fail" );
+
+	fprintf( stdout, "{\"check\":\"cpucheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+#endif // __linux__
+
+/*******************************************************************************
+ * CheckMemoryBudget
+ *
+ *     Checks MemoryBudgetMonitor on a sequence of budgets whose usage rises
+ *     through and falls back below each threshold, one or several at a time,
+ *     next to a region without usage, which must never be reported. On Linux
+ *     it also checks QueryMemoryBudget on the i915 and xe discrete GPUs of
+ *     fixtures/sysfs, and the monitor on the i915 one as lmem_avail_bytes is
+ *     rewritten.
+ *
+ ******************************************************************************/
+struct MemoryEvents
+{
+	std::vector< GPUDetect::MemoryBudgetMonitor::Event > events;
+
+	static void Record( const GPUDetect::MemoryBudgetMonitor::Event& event, void* context )
+	{
+		( (MemoryEvents*) context )->events.push_back( event );
+	}
+
+	bool Match( const float* thresholds, unsigned int count, bool rising ) const
+	{
+		if( events.size() != count )
+		{
+			return false;
+		}
+		for( unsigned int i = 0; i < count; ++i )
+		{
+			if( events[ i ].threshold != thresholds[ i ] || events[ i ].rising != rising || events[ i ].regionIndex != 0 )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+bool CheckMemoryBudget()
+{
+	unsigned int failures = 0;
+	const auto expect = [ &failures ]( bool condition, const char* what )
+	{
+		if( !condition )
+		{
+			fprintf( stderr, "memcheck: %s\n", what );
+			++failures;
+		}
+	};
+
+	const float thresholds[] = { 0.5f, 0.8f, 0.9f };
+	const float falling[] = { 0.9f, 0.8f, 0.5f };
+	MemoryEvents recorder;
+	GPUDetect::MemoryBudgetMonitor monitor( MemoryEvents::Record, &recorder );
+
+	const float descending[] = { 0.8f, 0.5f };
+	const float aboveOne[] = { 0.5f, 1.5f };
+	expect( monitor.SetThresholds( descending, 2 ) == GPUDETECT_ERROR_BAD_DATA, "descending thresholds were accepted" );
+	expect( monitor.SetThresholds( aboveOne, 2 ) == GPUDETECT_ERROR_BAD_DATA, "threshold above 1 was accepted" );
+	expect( monitor.SetThresholds( thresholds, 3 ) == EXIT_SUCCESS, "thresholds were rejected" );
+
+	// Region 1 is full but has no usage, so only region 0 is reported
+	GPUDetect::MemoryBudget budget = {};
+	budget.regionCount = 2;
+	budget.regions[ 0 ].totalBytes = 1000;
+	budget.regions[ 0 ].usageAvailability = true;
+	budget.regions[ 1 ].totalBytes = 1000;
+	budget.regions[ 1 ].usedBytes = 1000;
+
+	const struct
+	{
+		const char* what;
+		uint64_t usedBytes;
+		const float* expected;
+		unsigned int expectedCount;
+		bool rising;
+	}
+	steps[] =
+	{
+		{ "usage below all thresholds was reported", 100, thresholds, 0, true },
+		{ "rise across two thresholds was not reported in order", 850, thresholds, 2, true },
+		{ "rise onto the last threshold was not reported", 900, thresholds + 2, 1, true },
+		{ "unchanged usage was reported", 950, thresholds, 0, true },
+		{ "fall across all thresholds was not reported in order", 400, falling, 3, false },
+		{ "rise onto the first threshold was not reported", 500, thresholds, 1, true },
+		{ "fall below the first threshold was not reported", 499, falling + 2, 1, false },
+	};
+
+	for( const auto& step : steps )
+	{
+		recorder.events.clear();
+		budget.regions[ 0 ].usedBytes = step.usedBytes;
+		monitor.Update( budget );
+		expect( recorder.Match( step.expected, step.expectedCount, step.rising ), step.what );
+	}
+
+#ifdef __linux__
+	const uint64_t kLocalBytes = 17163091968ull;
+	const char* const availFile = "fixtures/sysfs/class/drm/card1/lmem_avail_bytes";
+
+	expect( GPUDetect::QueryMemoryBudget( 1, "fixtures/sysfs", &budget ) == EXIT_SUCCESS, "i915 budget could not be read; run from the repository root" );
+	expect( budget.regionCount == 1 && budget.regions[ 0 ].type == GPUDetect::MemoryRegion::REGION_LOCAL &&
+		budget.regions[ 0 ].totalBytes == kLocalBytes, "i915 local memory is wrong" );
+	expect( budget.regions[ 0 ].usageAvailability && budget.regions[ 0 ].availableBytes == 12884901888ull &&
+		budget.regions[ 0 ].usedBytes == kLocalBytes - 12884901888ull, "i915 usage is wrong" );
+
+	// The fake tree has no render node to query, so xe reports sizes only
+	expect( GPUDetect::QueryMemoryBudget( 2, "fixtures/sysfs", &budget ) == EXIT_SUCCESS, "xe budget could not be read" );
+	expect( budget.regionCount == 2 && budget.regions[ 0 ].instance == 0 && budget.regions[ 1 ].instance == 1 &&
+		budget.regions[ 0 ].totalBytes == 0x200000000ull && budget.regions[ 1 ].totalBytes == 0x200000000ull, "xe tiles are wrong" );
+	expect( !budget.regions[ 0 ].usageAvailability && !budget.regions[ 1 ].usageAvailability, "xe reported usage from sysfs" );
+
+	expect( GPUDetect::QueryMemoryBudget( 0, "fixtures/sysfs", &budget ) == GPUDETECT_ERROR_NOT_SUPPORTED, "integrated GPU reported local memory" );
+
+	const std::string longRoot = "fixtures/sysfs/" + std::string( GPUDetect::kMaxSysfsPath, 'x' );
+	expect( GPUDetect::QueryMemoryBudget( 0, longRoot.c_str(), &budget ) != EXIT_SUCCESS, "root too long for a path did not fail" );
+
+	const std::vector< uint8_t > original = ReadBytes( availFile );
+	const struct
+	{
+		const char* what;
+		uint64_t availableBytes;
+		const float* expected;
+		unsigned int expectedCount;
+		bool rising;
+	}
+	fixtureSteps[] =
+	{
+		{ "i915 rise across all thresholds was not reported", kLocalBytes / 20, thresholds, 3, true },
+		{ "i915 fall across all thresholds was not reported", kLocalBytes, falling, 3, false },
+	};
+
+	monitor.SetThresholds( thresholds, 3 );
+	for( const auto& step : fixtureSteps )
+	{
+		recorder.events.clear();
+		const bool read = WriteFixtureValue( availFile, step.availableBytes ) &&
+			GPUDetect::QueryMemoryBudget( 1, "fixtures/sysfs", &budget ) == EXIT_SUCCESS;
+		monitor.Update( budget );
+		expect( read && recorder.Match( step.expected, step.expectedCount, step.rising ), step.what );
+	}
+	WriteBytes( availFile, original );
+#endif
+
+	fprintf( stdout, "{\"check\":\"memcheck\",\"failures\":%u}\n", failures );
+	return failures == 0;
+}
+
+struct Check
+{
+	const char* mode;
+	bool ( *run )();
+};
+
+const Check kChecks[] =
+{
+	{ "-archcheck", CheckArchitectureDecode },
+	{ "-presetcheck", CheckPresetRules },
+	{ "-countercheck", CheckCounterDiscovery },
+	{ "-registrycheck", CheckDriverVersionCache },
+	{ "-replaycheck", CheckReplayRoundTrip },
+	{ "-cachecheck", CheckDetectionCache },
+	{ "-uploadcheck", CheckUploadAdvice },
+	{ "-memcheck", CheckMemoryBudget },
+	{ "-scorecheck", CheckThroughputScore },
+#ifdef __linux__
+	{ "-sysfscheck", CheckSysfsAdapters },
+	{ "-freqcheck", CheckFrequencySampler },
+	{ "-powercheck", CheckPowerSampler },
+	{ "-cpucheck", CheckCPUSysfs },
+#endif
+};
+
+}
+
+/*******************************************************************************
+ * main
+ *
+ *     GPUDetectBench [-samples n] [-ops n] [-cfg file]
+ *     GPUDetectBench -check | -archcheck | -presetcheck | -countercheck | -registrycheck | -replaycheck | -cachecheck | -uploadcheck | -memcheck | -scorecheck | -sysfscheck | -freqcheck | -powercheck | -cpucheck
+ *     GPUDetectBench -bigcfg [lines]
+ *     GPUDetectBench -parallel [latency_ms ...]
+ *     GPUDetectBench -counters [counter_count]
+ *     GPUDetectBench -registry [stale_key_count]
+ *     GPUDetectBench -replay file [iterations] [-latency]
+ *
+ ******************************************************************************/
+int main( int argc, char** argv )
+{
+	if( argc >= 2 && strcmp( argv[ 1 ], "-bigcfg" ) == 0 )
+	{
+		return BenchLargeCfg( argc - 2, argv + 2 );
+	}
+
+	if( argc >= 2 && strcmp( argv[ 1 ], "-parallel" ) == 0 )
+	{
+		return BenchParallelDetection( argc - 2, argv + 2 );
+	}
+
+	if( argc >= 2 && strcmp( argv[ 1 ], "-counters" ) == 0 )
+	{
+		return BenchCounterDiscovery( argc - 2, argv + 2 );
+	}
+
+	if( argc >= 2 && strcmp( argv[ 1 ], "-registry" ) == 0 )
+	{
+		return BenchDriverVersionIndex( argc - 2, argv + 2 );
+	}
+
+	if( argc >= 2 && strcmp( argv[ 1 ], "-replay" ) == 0 )
+	{
+		return BenchReplay( argc - 2, argv + 2 );
+	}
+
+	if( argc == 2 )
+	{
+		bool passed = true;
+		bool found = false;
+		for( const Check& check : kChecks )
+		{
+			if( strcmp( argv[ 1 ], "-check" ) == 0 || strcmp( argv[ 1 ], check.mode ) == 0 )
+			{
+				found = true;
+				passed = check.run() && passed;
+			}
+		}
+		if( found )
+		{
+			return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	Options options;
+	for( int i = 1; i < argc; ++i )
+	{
+		if( strcmp( argv[ i ], "-samples" ) == 0 && i + 1 < argc && IsNumber( argv[ i + 1 ] ) && atoi( argv[ i + 1 ] ) > 0 )
+		{
+			options.samples = atoi( argv[ ++i ] );
+		}
+		else if( strcmp( argv[ i ], "-ops" ) == 0 && i + 1 < argc && IsNumber( argv[ i + 1 ] ) && atoi( argv[ i + 1 ] ) > 0 )
+		{
+			options.opsPerSample = atoi( argv[ ++i ] );
+		}
+		else if( strcmp( argv[ i ], "-cfg" ) == 0 && i + 1 < argc )
+		{
+			options.cfgFileName = argv[ ++i ];
+		}
+		else
+		{
+			fprintf( stderr, "Usage: GPUDetectBench [-samples n] [-ops n] [-cfg file]\n" );
+			fprintf( stderr, "       GPUDetectBench -check | -archcheck | -presetcheck | -countercheck | -registrycheck | -replaycheck | -cachecheck | -uploadcheck | -memcheck | -scorecheck | -sysfscheck | -freqcheck | -powercheck | -cpucheck\n" );
+			fprintf( stderr, "       GPUDetectBench -bigcfg [lines]\n" );
+			fprintf( stderr, "       GPUDetectBench -parallel [latency_ms ...]\n" );
+			fprintf( stderr, "       GPUDetectBench -counters [counter_count]\n" );
+			fprintf( stderr, "       GPUDetectBench -registry [stale_key_count]\n" );
+			fprintf( stderr, "       GPUDetectBench -replay file [iterations] [-latency]\n" );
+			return EXIT_FAILURE;
+		}
+	}
+
+	InputSet cfgInputs = { "cfg", ReadCfgDevices( options.cfgFileName ) };
+	if( cfgInputs.devices.empty() )
+	{
+		fprintf( stderr, "Error: no devices could be read from %s.\n", options.cfgFileName );
+		return EXIT_FAILURE;
+	}
+
+	const InputSet randomInputs = { "random", MakeRandomDevices( 4096 ) };
+	const InputSet adversarialInputs = { "adversarial", MakeAdversarialDevices( cfgInputs.devices ) };
+
+	RunBenchmarks( cfgInputs, options );
+	RunBenchmarks( randomInputs, options );
+	RunBenchmarks( adversarialInputs, options );
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,538 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#include <intrin.h>
+
+#endif // _WIN32
+
+#ifdef __linux__
+#include <dirent.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <cpuid.h>
+#endif
+#endif // __linux__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "GPUDetect.h"
+#ifdef __linux__
+#include "GPUDetectSysfs.h"
+#endif
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+#if defined( _M_X64 ) || defined( _M_IX86 ) || defined( __x86_64__ ) || defined( __i386__ )
+#define GPUDETECT_HAS_CPUID
+
+// registers[] is EAX, EBX, ECX, EDX
+void Cpuid( uint32_t leaf, uint32_t subleaf, uint32_t registers[ 4 ] )
+{
+#ifdef _WIN32
+	int values[ 4 ] = {};
+	__cpuidex( values, (int) leaf, (int) subleaf );
+	for( int i = 0; i < 4; ++i )
+	{
+		registers[ i ] = (uint32_t) values[ i ];
+	}
+#else
+	__cpuid_count( leaf, subleaf, registers[ 0 ], registers[ 1 ], registers[ 2 ], registers[ 3 ] );
+#endif
+}
+
+uint64_t ReadXCR0()
+{
+#ifdef _WIN32
+	return _xgetbv( 0 );
+#else
+	// Spelled out so that the file builds without -mxsave
+	uint32_t eax = 0;
+	uint32_t edx = 0;
+	__asm__ volatile( "xgetbv" : "=a"( eax ), "=d"( edx ) : "c"( 0 ) );
+	return ( (uint64_t) edx << 32 ) | eax;
+#endif
+}
+
+bool HasBit( uint32_t value, unsigned int bit )
+{
+	return ( value >> bit ) & 1;
+}
+
+// The register state the OS has to save for each width, in XCR0
+const uint64_t kXCR0Ymm = 0x06;   // SSE and AVX
+const uint64_t kXCR0Zmm = 0xE6;   // and opmask, ZMM0-15 upper halves, ZMM16-31
+
+void ReadCpuidFeatures( CPUData* const cpuData )
+{
+	uint32_t registers[ 4 ] = {};
+	Cpuid( 0, 0, registers );
+	const uint32_t maxLeaf = registers[ 0 ];
+
+	// The vendor string is in EBX, EDX, ECX order
+	memcpy( cpuData->vendor + 0, &registers[ 1 ], 4 );
+	memcpy( cpuData->vendor + 4, &registers[ 3 ], 4 );
+	memcpy( cpuData->vendor + 8, &registers[ 2 ], 4 );
+	cpuData->vendor[ 12 ] = '\0';
+
+	if( maxLeaf < 1 )
+	{
+		return;
+	}
+
+	Cpuid( 1, 0, registers );
+	const uint32_t leaf1Ecx = registers[ 2 ];
+	if( HasBit( leaf1Ecx, 20 ) )
+	{
+		cpuData->simdFeatures |= CPUData::SIMD_SSE4_2;
+	}
+
+	// Wider registers are only usable if the OS saves them on a context switch
+	const uint64_t xcr0 = HasBit( leaf1Ecx, 27 ) ? ReadXCR0() : 0;
+	const bool osYmm = ( xcr0 & kXCR0Ymm ) == kXCR0Ymm;
+	const bool osZmm = ( xcr0 & kXCR0Zmm ) == kXCR0Zmm;
+	if( !osYmm )
+	{
+		return;
+	}
+
+	if( HasBit( leaf1Ecx, 28 ) )
+	{
+		cpuData->simdFeatures |= CPUData::SIMD_AVX;
+	}
+	if( HasBit( leaf1Ecx, 12 ) )
+	{
+		cpuData->simdFeatures |= CPUData::SIMD_FMA;
+	}
+
+	if( maxLeaf < 7 )
+	{
+		return;
+	}
+
+	Cpuid( 7, 0, registers );
+	const uint32_t maxLeaf7Subleaf = registers[ 0 ];
+	const uint32_t leaf7Ebx = registers[ 1 ];
+	const uint32_t leaf7Ecx = registers[ 2 ];
+	if( HasBit( leaf7Ebx, 5 ) )
+	{
+		cpuData->simdFeatures |= CPUData::SIMD_AVX2;
+	}
+
+	// F, DQ, CD, BW and VL
+	const uint32_t avx512Mask = ( 1u << 16 ) | ( 1u << 17 ) | ( 1u << 28 ) | ( 1u << 30 ) | ( 1u << 31 );
+	if( osZmm && ( leaf7Ebx & avx512Mask ) == avx512Mask )
+	{
+		cpuData->simdFeatures |= CPUData::SIMD_AVX512;
+		if( HasBit( leaf7Ecx, 11 ) )
+		{
+			cpuData->simdFeatures |= CPUData::SIMD_AVX512_VNNI;
+		}
+	}
+
+	if( maxLeaf7Subleaf >= 1 )
+	{
+		Cpuid( 7, 1, registers );
+		if( HasBit( registers[ 0 ], 4 ) )
+		{
+			cpuData->simdFeatures |= CPUData::SIMD_AVX_VNNI;
+		}
+	}
+}
+
+//
+// Intel reports its caches in leaf 4, AMD in 0x8000001D, in the same layout.
+// Used where the OS does not report them.
+//
+void ReadCpuidCaches( CPUData* const cpuData )
+{
+	uint32_t registers[ 4 ] = {};
+	uint32_t leaf = 0;
+	if( strcmp( cpuData->vendor, "GenuineIntel" ) == 0 )
+	{
+		Cpuid( 0, 0, registers );
+		leaf = registers[ 0 ] >= 4 ? 4 : 0;
+	}
+	else if( strcmp( cpuData->vendor, "AuthenticAMD" ) == 0 )
+	{
+		Cpuid( 0x80000000, 0, registers );
+		leaf = registers[ 0 ] >= 0x8000001D ? 0x8000001D : 0;
+	}
+	if( leaf == 0 )
+	{
+		return;
+	}
+
+	for( uint32_t subleaf = 0; subleaf < 16; ++subleaf )
+	{
+		Cpuid( leaf, subleaf, registers );
+		const uint32_t type = registers[ 0 ] & 0x1F;   // 1 data, 2 instruction, 3 unified
+		if( type == 0 )
+		{
+			break;
+		}
+
+		const uint32_t level = ( registers[ 0 ] >> 5 ) & 0x7;
+		const uint64_t ways = ( ( registers[ 1 ] >> 22 ) & 0x3FF ) + 1;
+		const uint64_t partitions = ( ( registers[ 1 ] >> 12 ) & 0x3FF ) + 1;
+		const uint64_t lineSize = ( registers[ 1 ] & 0xFFF ) + 1;
+		const uint64_t sets = (uint64_t) registers[ 2 ] + 1;
+		const unsigned int sizeKB = (unsigned int) ( ways * partitions * lineSize * sets / 1024 );
+
+		if( level == 1 && type == 1 )
+		{
+			cpuData->l1DataCacheKB = sizeKB;
+		}
+		else if( level == 2 && type != 2 )
+		{
+			cpuData->l2CacheKB = sizeKB;
+		}
+		else if( level == 3 && type != 2 )
+		{
+			cpuData->l3CacheKB = sizeKB;
+		}
+	}
+}
+
+#endif // GPUDETECT_HAS_CPUID
+
+#ifdef _WIN32
+
+int InitCPUWindowsInfo( CPUData* const cpuData )
+{
+	DWORD length = 0;
+	if( GetLogicalProcessorInformationEx( RelationAll, nullptr, &length ) ||
+		GetLastError() != ERROR_INSUFFICIENT_BUFFER )
+	{
+		return GPUDETECT_ERROR_GENERIC;
+	}
+
+	std::vector< char > buffer( length );
+	if( !GetLogicalProcessorInformationEx( RelationAll, (PSYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX) buffer.data(), &length ) )
+	{
+		return GPUDETECT_ERROR_GENERIC;
+	}
+
+	unsigned int logicalCoreCount = 0;
+	unsigned int physicalCoreCount = 0;
+	for( DWORD offset = 0; offset < length; )
+	{
+		const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* info = (const SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*) ( buffer.data() + offset );
+		if( info->Relationship == RelationProcessorCore )
+		{
+			++physicalCoreCount;
+			for( WORD group = 0; group < info->Processor.GroupCount; ++group )
+			{
+				for( KAFFINITY mask = info->Processor.GroupMask[ group ].Mask; mask != 0; mask &= mask - 1 )
+				{
+					++logicalCoreCount;
+				}
+			}
+		}
+		else if( info->Relationship == RelationCache )
+		{
+			// The first cache of each level is the one of the first core
+			const CACHE_RELATIONSHIP& cache = info->Cache;
+			const unsigned int sizeKB = cache.CacheSize / 1024;
+			if( cache.Level == 1 && cache.Type == CacheData && cpuData->l1DataCacheKB == 0 )
+			{
+				cpuData->l1DataCacheKB = sizeKB;
+			}
+			else if( cache.Level == 2 && cache.Type != CacheInstruction && cpuData->l2CacheKB == 0 )
+			{
+				cpuData->l2CacheKB = sizeKB;
+			}
+			else if( cache.Level == 3 && cache.Type != CacheInstruction && cpuData->l3CacheKB == 0 )
+			{
+				cpuData->l3CacheKB = sizeKB;
+			}
+		}
+		offset += info->Size;
+	}
+
+	cpuData->logicalCoreCount = logicalCoreCount;
+	cpuData->physicalCoreCount = physicalCoreCount;
+	return EXIT_SUCCESS;
+}
+
+#endif // _WIN32
+
+#ifdef __linux__
+
+// Sizes are written as "48K", or rarely "1M"
+bool ReadSysfsSizeKB( const char* path, unsigned int* sizeKB )
+{
+	char buffer[ 32 ];
+	if( ReadSysfsFile( path, buffer, sizeof( buffer ) ) <= 0 )
+	{
+		return false;
+	}
+
+	char* end = nullptr;
+	const unsigned long value = strtoul( buffer, &end, 10 );
+	if( end == buffer )
+	{
+		return false;
+	}
+
+	switch( *end )
+	{
+		case 'K': *sizeKB = (unsigned int) value; break;
+		case 'M': *sizeKB = (unsigned int) value * 1024; break;
+		case 'G': *sizeKB = (unsigned int) value * 1024 * 1024; break;
+		default:  *sizeKB = (unsigned int) ( value / 1024 ); break;
+	}
+	return true;
+}
+
+// Returns EXIT_SUCCESS, or GPUDETECT_ERROR_SYSFS_READ if a path does not fit
+int ReadSysfsCaches( const char* cpuRoot, int cpuNumber, CPUData* const cpuData )
+{
+	char path[ kMaxSysfsPath ];
+	for( int index = 0; index < 16; ++index )
+	{
+		uint64_t level = 0;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/cache/index%d/level", cpuRoot, cpuNumber, index ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		if( !ReadSysfsValue( path, 10, &level ) )
+		{
+			break;
+		}
+
+		char type[ 16 ];
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/cache/index%d/type", cpuRoot, cpuNumber, index ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		if( ReadSysfsFile( path, type, sizeof( type ) ) <= 0 )
+		{
+			continue;
+		}
+		const bool data = strncmp( type, "Data", 4 ) == 0;
+		const bool instruction = strncmp( type, "Instruction", 11 ) == 0;
+
+		unsigned int sizeKB = 0;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/cache/index%d/size", cpuRoot, cpuNumber, index ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		if( !ReadSysfsSizeKB( path, &sizeKB ) )
+		{
+			continue;
+		}
+
+		if( level == 1 && data )
+		{
+			cpuData->l1DataCacheKB = sizeKB;
+		}
+		else if( level == 2 && !instruction )
+		{
+			cpuData->l2CacheKB = sizeKB;
+		}
+		else if( level == 3 && !instruction )
+		{
+			cpuData->l3CacheKB = sizeKB;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif // __linux__
+
+}
+
+#ifdef __linux__
+
+int InitCPUSysfsInfo( CPUData* const cpuData, const char* sysfsRoot )
+{
+	if( cpuData == nullptr || sysfsRoot == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	char cpuRoot[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( cpuRoot, sizeof( cpuRoot ), "%s/devices/system/cpu", sysfsRoot ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	DIR* dir = ::opendir( cpuRoot );
+	if( dir == nullptr )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	std::vector< int > cpuNumbers;
+	while( const dirent* entry = ::readdir( dir ) )
+	{
+		int cpuNumber = 0;
+		char trailing = 0;
+		if( sscanf( entry->d_name, "cpu%d%c", &cpuNumber, &trailing ) == 1 && cpuNumber >= 0 )
+		{
+			cpuNumbers.push_back( cpuNumber );
+		}
+	}
+	::closedir( dir );
+
+	if( cpuNumbers.empty() )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	std::sort( cpuNumbers.begin(), cpuNumbers.end() );
+
+	// A physical core is a distinct core_id within a package; its SMT
+	// siblings share both
+	std::vector< std::pair< uint64_t, uint64_t > > cores;
+	unsigned int logicalCoreCount = 0;
+	int firstOnlineCpu = -1;
+	char path[ kMaxSysfsPath ];
+	for( int cpuNumber : cpuNumbers )
+	{
+		// cpu0 usually has no online file, as it cannot be taken offline
+		uint64_t online = 1;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/online", cpuRoot, cpuNumber ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		ReadSysfsValue( path, 10, &online );
+		if( online == 0 )
+		{
+			continue;
+		}
+
+		++logicalCoreCount;
+		if( firstOnlineCpu < 0 )
+		{
+			firstOnlineCpu = cpuNumber;
+		}
+
+		uint64_t packageId = 0;
+		uint64_t coreId = (uint64_t) cpuNumber;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/topology/physical_package_id", cpuRoot, cpuNumber ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		ReadSysfsValue( path, 10, &packageId );
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/cpu%d/topology/core_id", cpuRoot, cpuNumber ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		ReadSysfsValue( path, 10, &coreId );
+		cores.emplace_back( packageId, coreId );
+	}
+
+	std::sort( cores.begin(), cores.end() );
+	cores.erase( std::unique( cores.begin(), cores.end() ), cores.end() );
+
+	cpuData->logicalCoreCount = logicalCoreCount;
+	cpuData->physicalCoreCount = (unsigned int) cores.size();
+
+	if( firstOnlineCpu >= 0 )
+	{
+		return ReadSysfsCaches( cpuRoot, firstOnlineCpu, cpuData );
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif // __linux__
+
+int InitCPUData( CPUData* const cpuData )
+{
+	if( cpuData == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*cpuData = {};
+
+#ifdef GPUDETECT_HAS_CPUID
+	ReadCpuidFeatures( cpuData );
+	ReadCpuidCaches( cpuData );
+#endif
+
+#ifdef _WIN32
+	return InitCPUWindowsInfo( cpuData );
+#elif defined( __linux__ )
+	return InitCPUSysfsInfo( cpuData, "/sys" );
+#else
+	return EXIT_SUCCESS;
+#endif
+}
+
+SimdTier GetSimdTier( const CPUData* const cpuData )
+{
+	if( cpuData == nullptr )
+	{
+		return SIMD_TIER_SCALAR;
+	}
+
+	const uint32_t features = cpuData->simdFeatures;
+	const uint32_t avx2 = CPUData::SIMD_AVX | CPUData::SIMD_AVX2 | CPUData::SIMD_FMA;
+	if( ( features & avx2 ) == avx2 )
+	{
+		return ( features & CPUData::SIMD_AVX512 ) ? SIMD_TIER_AVX512 : SIMD_TIER_AVX2;
+	}
+	if( features & CPUData::SIMD_SSE4_2 )
+	{
+		return SIMD_TIER_SSE4_2;
+	}
+	return SIMD_TIER_SCALAR;
+}
+
+const char* GetSimdTierName( SimdTier tier )
+{
+	switch( tier )
+	{
+		case SIMD_TIER_SCALAR: return "Scalar";
+		case SIMD_TIER_SSE4_2: return "SSE4.2";
+		case SIMD_TIER_AVX2:   return "AVX2";
+		case SIMD_TIER_AVX512: return "AVX-512";
+	}
+	return "Unknown";
+}
+
+}
@@ -0,0 +1,416 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#endif // _WIN32
+
+#ifdef __linux__
+#include <sys/utsname.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "GPUDetect.h"
+#include "GPUDetectBackend.h"
+#ifdef __linux__
+#include "GPUDetectSysfs.h"
+#endif
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+//
+// Cache file layout, in native byte order:
+//
+//     CacheHeader
+//     CacheEntry[ header.entryCount ]
+//     uint32_t checksum    FNV-1a of everything above
+//
+// Any mismatch (magic, version, GPUData size, length or checksum) makes the
+// whole file a miss; it is rewritten after the next full detection.
+//
+const uint32_t kCacheMagic = 0x43445047; // "GPDC"
+
+// Bump when the meaning of a GPUData field or of the detection changes
+// without changing sizeof( GPUData )
+const uint32_t kCacheFormatVersion = 1;
+
+// Adapters plus a few stale entries from other drivers or boots
+const uint32_t kMaxCacheEntries = 16;
+
+struct CacheHeader
+{
+	uint32_t magic;
+	uint32_t formatVersion;
+	uint32_t gpuDataSize;
+	uint32_t entryCount;
+};
+
+// What must not change for a cached GPUData to still be valid. All of it
+// can be read without creating a device.
+struct AdapterFingerprint
+{
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t luidLowPart;
+	int32_t luidHighPart;
+	uint64_t driverVersion;  // the raw DriverVersion QWORD on Windows, GetDriverIdentity on Linux
+};
+
+struct CacheEntry
+{
+	AdapterFingerprint fingerprint;
+	int32_t returnCode;
+	GPUData data;
+};
+
+uint32_t Fnv1a( const void* data, size_t size, uint32_t hash = 2166136261u )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	for( size_t i = 0; i < size; ++i )
+	{
+		hash ^= bytes[ i ];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+bool SameAdapter( const AdapterFingerprint& a, const AdapterFingerprint& b )
+{
+	return a.vendorID == b.vendorID && a.deviceID == b.deviceID &&
+		a.luidLowPart == b.luidLowPart && a.luidHighPart == b.luidHighPart;
+}
+
+bool SameFingerprint( const AdapterFingerprint& a, const AdapterFingerprint& b )
+{
+	return SameAdapter( a, b ) && a.driverVersion == b.driverVersion;
+}
+
+// Returns the entries of the cache file, or none if it is missing or invalid
+std::vector< CacheEntry > ReadCacheFile( const char* cacheFileName )
+{
+	std::vector< CacheEntry > entries;
+
+	FILE* file = fopen( cacheFileName, "rb" );
+	if( file == nullptr )
+	{
+		return entries;
+	}
+
+	CacheHeader header = {};
+	bool valid = fread( &header, sizeof( header ), 1, file ) == 1 &&
+		header.magic == kCacheMagic &&
+		header.formatVersion == kCacheFormatVersion &&
+		header.gpuDataSize == sizeof( GPUData ) &&
+		header.entryCount <= kMaxCacheEntries;
+
+	if( valid )
+	{
+		entries.resize( header.entryCount );
+
+		uint32_t checksum = 0;
+		valid = ( header.entryCount == 0 || fread( entries.data(), sizeof( CacheEntry ), header.entryCount, file ) == header.entryCount ) &&
+			fread( &checksum, sizeof( checksum ), 1, file ) == 1 &&
+			fgetc( file ) == EOF &&
+			checksum == Fnv1a( entries.data(), entries.size() * sizeof( CacheEntry ), Fnv1a( &header, sizeof( header ) ) );
+	}
+
+	fclose( file );
+
+	if( !valid )
+	{
+		entries.clear();
+	}
+	return entries;
+}
+
+// Writes to a temporary file first, so a reader never sees a partial file
+bool WriteCacheFile( const char* cacheFileName, const std::vector< CacheEntry >& entries )
+{
+	CacheHeader header = {};
+	header.magic = kCacheMagic;
+	header.formatVersion = kCacheFormatVersion;
+	header.gpuDataSize = sizeof( GPUData );
+	header.entryCount = (uint32_t) entries.size();
+
+	const uint32_t checksum = Fnv1a( entries.data(), entries.size() * sizeof( CacheEntry ), Fnv1a( &header, sizeof( header ) ) );
+
+	// Unique to the process and the call, so two writers never share a
+	// temporary file; the last rename wins
+	static std::atomic< unsigned int > s_tempFileCount( 0 );
+#ifdef _WIN32
+	const unsigned long processID = ::GetCurrentProcessId();
+#else
+	const unsigned long processID = (unsigned long) getpid();
+#endif
+	const std::string tempFileName = std::string( cacheFileName ) + "." + std::to_string( processID ) + "." + std::to_string( s_tempFileCount++ ) + ".tmp";
+	FILE* file = fopen( tempFileName.c_str(), "wb" );
+	if( file == nullptr )
+	{
+		return false;
+	}
+
+	bool written = fwrite( &header, sizeof( header ), 1, file ) == 1 &&
+		( entries.empty() || fwrite( entries.data(), sizeof( CacheEntry ), entries.size(), file ) == entries.size() ) &&
+		fwrite( &checksum, sizeof( checksum ), 1, file ) == 1;
+	written = fclose( file ) == 0 && written;
+
+#ifdef _WIN32
+	written = written && ::MoveFileExA( tempFileName.c_str(), cacheFileName, MOVEFILE_REPLACE_EXISTING ) != FALSE;
+#else
+	written = written && rename( tempFileName.c_str(), cacheFileName ) == 0;
+#endif
+
+	if( !written )
+	{
+		remove( tempFileName.c_str() );
+	}
+	return written;
+}
+
+void StoreCacheEntry( const char* cacheFileName, const CacheEntry& entry )
+{
+	std::vector< CacheEntry > entries;
+	entries.reserve( kMaxCacheEntries );
+	entries.push_back( entry );
+
+	// Keep the other adapters, most recent first, and drop this adapter's
+	// entries for older drivers
+	for( const CacheEntry& oldEntry : ReadCacheFile( cacheFileName ) )
+	{
+		if( !SameAdapter( oldEntry.fingerprint, entry.fingerprint ) && entries.size() < kMaxCacheEntries )
+		{
+			entries.push_back( oldEntry );
+		}
+	}
+
+	if( !WriteCacheFile( cacheFileName, entries ) )
+	{
+		fprintf( stderr, "Error: could not write the detection cache %s.\n", cacheFileName );
+	}
+}
+
+// Fills the adapter-level fields and the driver version, without a device
+#ifdef _WIN32
+int GetAdapterFingerprint( GPUData* const gpuData, Context* context, int adapterIndex, uint64_t* driverVersion )
+{
+	int returnCode = InitAdapterInfo( gpuData, context, adapterIndex );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	returnCode = InitDxDriverVersion( gpuData );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	*driverVersion = 0;
+	for( int i = 0; i < 4; ++i )
+	{
+		*driverVersion = ( *driverVersion << 16 ) | gpuData->dxDriverVersion[ i ];
+	}
+	return EXIT_SUCCESS;
+}
+#else
+//
+// sysfs has no driver version, so the kernel release stands in for it in
+// the high half, and the srcversion of the driver's module, which changes
+// whenever the module is rebuilt, in the low half. A driver built into the
+// kernel has no srcversion, and changes with the release.
+//
+uint64_t GetDriverIdentity( int adapterIndex )
+{
+	uint64_t identity = 0;
+
+	utsname name = {};
+	if( uname( &name ) == 0 )
+	{
+		identity = (uint64_t) Fnv1a( name.release, strlen( name.release ) ) << 32;
+	}
+
+	int cardNumber = 0;
+	char path[ kMaxSysfsPath ];
+	char driverLink[ kMaxSysfsPath ];
+	if( FindSysfsCard( "/sys", adapterIndex, &cardNumber ) != EXIT_SUCCESS ||
+		!FormatSysfsPath( path, sizeof( path ), "/sys/class/drm/card%d/device/driver", cardNumber ) )
+	{
+		return identity;
+	}
+
+	const ssize_t linkLength = readlink( path, driverLink, sizeof( driverLink ) - 1 );
+	if( linkLength <= 0 )
+	{
+		return identity;
+	}
+	driverLink[ linkLength ] = '\0';
+
+	const char* slash = strrchr( driverLink, '/' );
+	const char* driver = slash != nullptr ? slash + 1 : driverLink;
+
+	char srcversion[ 64 ];
+	const int srcversionLength = FormatSysfsPath( path, sizeof( path ), "/sys/module/%s/srcversion", driver )
+		? ReadSysfsFile( path, srcversion, sizeof( srcversion ) )
+		: -1;
+	if( srcversionLength > 0 )
+	{
+		identity |= Fnv1a( srcversion, srcversionLength );
+	}
+	return identity;
+}
+
+int GetAdapterFingerprint( GPUData* const gpuData, int adapterIndex, uint64_t* driverVersion )
+{
+	const int returnCode = InitAdapterInfo( gpuData, adapterIndex );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	*driverVersion = GetDriverIdentity( adapterIndex );
+	return EXIT_SUCCESS;
+}
+#endif
+
+// Returns the cached result for the fingerprint, or runs detect and caches
+// its result
+template< typename GetFingerprint, typename Detect >
+int InitAllCached( GPUData* const gpuData, const char* cacheFileName, GetFingerprint getFingerprint, Detect detect )
+{
+	CacheEntry entry = {};
+	const int fingerprintReturnCode = getFingerprint( &entry.data, &entry.fingerprint.driverVersion );
+	if( fingerprintReturnCode == EXIT_SUCCESS )
+	{
+		entry.fingerprint.vendorID = entry.data.vendorID;
+		entry.fingerprint.deviceID = entry.data.deviceID;
+		entry.fingerprint.luidLowPart = entry.data.adapterLUID.LowPart;
+		entry.fingerprint.luidHighPart = entry.data.adapterLUID.HighPart;
+
+		for( const CacheEntry& cached : ReadCacheFile( cacheFileName ) )
+		{
+			if( SameFingerprint( cached.fingerprint, entry.fingerprint ) )
+			{
+				*gpuData = cached.data;
+				return cached.returnCode;
+			}
+		}
+	}
+
+	entry.data = {};
+	const int returnCode = detect( &entry.data );
+	*gpuData = entry.data;
+
+	// Only store complete results: GPUDETECT_ERROR_NOT_SUPPORTED is what
+	// non-Intel adapters always return, other errors may be transient
+	if( fingerprintReturnCode == EXIT_SUCCESS && ( returnCode == EXIT_SUCCESS || returnCode == GPUDETECT_ERROR_NOT_SUPPORTED ) )
+	{
+		entry.returnCode = returnCode;
+		StoreCacheEntry( cacheFileName, entry );
+	}
+
+	return returnCode;
+}
+
+}
+
+#ifdef _WIN32
+int InitAllCached( GPUData* const gpuData, int adapterIndex, const char* cacheFileName )
+{
+	if( gpuData == nullptr || adapterIndex < 0 || cacheFileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	Context context;
+	return InitAllCached( gpuData, &context, adapterIndex, cacheFileName );
+}
+
+int InitAllCached( GPUData* const gpuData, Context* context, int adapterIndex, const char* cacheFileName )
+{
+	if( gpuData == nullptr || context == nullptr || adapterIndex < 0 || cacheFileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	return InitAllCached(
+		gpuData,
+		cacheFileName,
+		[ = ]( GPUData* data, uint64_t* driverVersion ) { return GetAdapterFingerprint( data, context, adapterIndex, driverVersion ); },
+		[ = ]( GPUData* data ) { return InitAll( data, context, adapterIndex ); } );
+}
+#else
+int InitAllCached( GPUData* const gpuData, int adapterIndex, const char* cacheFileName )
+{
+	if( gpuData == nullptr || adapterIndex < 0 || cacheFileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	return InitAllCached(
+		gpuData,
+		cacheFileName,
+		[ = ]( GPUData* data, uint64_t* driverVersion ) { return GetAdapterFingerprint( data, adapterIndex, driverVersion ); },
+		[ = ]( GPUData* data ) { return InitAll( data, adapterIndex ); } );
+}
+#endif
+
+int InitAllCached( GPUData* const gpuData, ICacheSource* source, const char* cacheFileName )
+{
+	if( gpuData == nullptr || source == nullptr || cacheFileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	return InitAllCached(
+		gpuData,
+		cacheFileName,
+		[ = ]( GPUData* data, uint64_t* driverVersion ) { return source->GetAdapterFingerprint( data, driverVersion ); },
+		[ = ]( GPUData* data ) { return source->InitAll( data ); } );
+}
+
+}
@@ -0,0 +1,310 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GPUDetect.h"
+#include "GPUDetectSysfs.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+struct FrequencyFiles
+{
+	const char* cur;
+	const char* act;
+};
+
+// Relative to class/drm/cardN, in the order they are tried
+const FrequencyFiles kFrequencyFiles[] =
+{
+	{ "gt_cur_freq_mhz", "gt_act_freq_mhz" },                                // i915
+	{ "device/tile0/gt0/freq0/cur_freq", "device/tile0/gt0/freq0/act_freq" }, // xe
+};
+
+}
+
+struct FrequencySampler::Impl
+{
+	explicit Impl( unsigned int windowSize )
+		: window( std::max( windowSize, 1u ) )
+	{
+	}
+
+	~Impl()
+	{
+		Close();
+	}
+
+	void Close()
+	{
+		for( int* fd : { &curFd, &actFd } )
+		{
+			if( *fd >= 0 )
+			{
+				::close( *fd );
+				*fd = -1;
+			}
+		}
+	}
+
+	// Requires mutex
+	void ResetStats()
+	{
+		stats = {};
+		windowNext = 0;
+		windowCurSum = 0;
+		windowActSum = 0;
+		hasPreviousSample = false;
+	}
+
+	struct WindowSample
+	{
+		unsigned int curMHz;
+		unsigned int actMHz;
+	};
+
+	int curFd = -1;
+	int actFd = -1;
+
+	mutable std::mutex mutex;
+	FrequencyStats stats = {};
+	std::vector< WindowSample > window;
+	size_t windowNext = 0;
+	uint64_t windowCurSum = 0;
+	uint64_t windowActSum = 0;
+	bool hasPreviousSample = false;
+	std::chrono::steady_clock::time_point previousSampleTime;
+
+	std::thread thread;
+	std::condition_variable stopCondition;
+	bool stopRequested = false;
+};
+
+FrequencySampler::FrequencySampler( unsigned int windowSize )
+	: m_impl( new Impl( windowSize ) )
+{
+}
+
+FrequencySampler::~FrequencySampler()
+{
+	Stop();
+	delete m_impl;
+}
+
+int FrequencySampler::Open( int adapterIndex, const char* sysfsRoot )
+{
+	if( adapterIndex < 0 || sysfsRoot == nullptr || m_impl->thread.joinable() )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	m_impl->Close();
+	Reset();
+
+	int cardNumber = 0;
+	const int returnCode = FindSysfsCard( sysfsRoot, adapterIndex, &cardNumber );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	for( const FrequencyFiles& files : kFrequencyFiles )
+	{
+		char path[ kMaxSysfsPath ];
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/%s", sysfsRoot, cardNumber, files.cur ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		const int curFd = ::open( path, O_RDONLY | O_CLOEXEC );
+		if( curFd < 0 )
+		{
+			continue;
+		}
+
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/%s", sysfsRoot, cardNumber, files.act ) )
+		{
+			::close( curFd );
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		const int actFd = ::open( path, O_RDONLY | O_CLOEXEC );
+		if( actFd < 0 )
+		{
+			::close( curFd );
+			continue;
+		}
+
+		m_impl->curFd = curFd;
+		m_impl->actFd = actFd;
+		return EXIT_SUCCESS;
+	}
+
+	return GPUDETECT_ERROR_NOT_SUPPORTED;
+}
+
+int FrequencySampler::Sample()
+{
+	if( m_impl->curFd < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	uint64_t cur = 0;
+	uint64_t act = 0;
+	if( !RereadSysfsValue( m_impl->curFd, &cur ) || !RereadSysfsValue( m_impl->actFd, &act ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	const unsigned int curMHz = (unsigned int) cur;
+	const unsigned int actMHz = (unsigned int) act;
+	const auto now = std::chrono::steady_clock::now();
+
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	FrequencyStats& stats = m_impl->stats;
+
+	// The time since the previous sample is attributed to the frequency it saw
+	if( m_impl->hasPreviousSample )
+	{
+		const unsigned int bucket = std::min( stats.lastActMHz / FrequencyStats::HISTOGRAM_BUCKET_MHZ, (unsigned int) FrequencyStats::HISTOGRAM_BUCKET_COUNT - 1 );
+		stats.timeAtFrequencyUs[ bucket ] += std::chrono::duration_cast< std::chrono::microseconds >( now - m_impl->previousSampleTime ).count();
+	}
+	m_impl->hasPreviousSample = true;
+	m_impl->previousSampleTime = now;
+
+	++stats.sampleCount;
+	stats.lastCurMHz = curMHz;
+	stats.lastActMHz = actMHz;
+
+	// The window is a ring; its sums are kept up to date, its min and max are
+	// found when the stats are read
+	Impl::WindowSample& slot = m_impl->window[ m_impl->windowNext ];
+	if( stats.windowSampleCount == m_impl->window.size() )
+	{
+		m_impl->windowCurSum -= slot.curMHz;
+		m_impl->windowActSum -= slot.actMHz;
+	}
+	else
+	{
+		++stats.windowSampleCount;
+	}
+	slot.curMHz = curMHz;
+	slot.actMHz = actMHz;
+	m_impl->windowCurSum += curMHz;
+	m_impl->windowActSum += actMHz;
+	m_impl->windowNext = ( m_impl->windowNext + 1 ) % m_impl->window.size();
+
+	return EXIT_SUCCESS;
+}
+
+int FrequencySampler::Start( unsigned int intervalMs )
+{
+	if( m_impl->curFd < 0 || m_impl->thread.joinable() || intervalMs == 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	m_impl->stopRequested = false;
+	m_impl->thread = std::thread( [ this, intervalMs ]()
+	{
+		const auto interval = std::chrono::milliseconds( intervalMs );
+		auto nextSample = std::chrono::steady_clock::now();
+
+		std::unique_lock< std::mutex > lock( m_impl->mutex );
+		while( !m_impl->stopRequested )
+		{
+			lock.unlock();
+			Sample();
+			lock.lock();
+
+			// Sample on a fixed schedule, so the interval does not drift by
+			// the time a sample takes
+			nextSample += interval;
+			m_impl->stopCondition.wait_until( lock, nextSample, [ this ]() { return m_impl->stopRequested; } );
+		}
+	} );
+
+	return EXIT_SUCCESS;
+}
+
+void FrequencySampler::Stop()
+{
+	if( !m_impl->thread.joinable() )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > lock( m_impl->mutex );
+		m_impl->stopRequested = true;
+	}
+	m_impl->stopCondition.notify_all();
+	m_impl->thread.join();
+}
+
+void FrequencySampler::GetStats( FrequencyStats* const stats ) const
+{
+	if( stats == nullptr )
+	{
+		return;
+	}
+
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	*stats = m_impl->stats;
+
+	const unsigned int count = stats->windowSampleCount;
+	if( count == 0 )
+	{
+		return;
+	}
+
+	stats->curMinMHz = stats->actMinMHz = UINT32_MAX;
+	for( unsigned int i = 0; i < count; ++i )
+	{
+		const Impl::WindowSample& sample = m_impl->window[ i ];
+		stats->curMinMHz = std::min( stats->curMinMHz, sample.curMHz );
+		stats->curMaxMHz = std::max( stats->curMaxMHz, sample.curMHz );
+		stats->actMinMHz = std::min( stats->actMinMHz, sample.actMHz );
+		stats->actMaxMHz = std::max( stats->actMaxMHz, sample.actMHz );
+	}
+	stats->curAvgMHz = (unsigned int) ( m_impl->windowCurSum / count );
+	stats->actAvgMHz = (unsigned int) ( m_impl->windowActSum / count );
+}
+
+void FrequencySampler::Reset()
+{
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	m_impl->ResetStats();
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,425 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+
+#include <dxgi1_4.h>
+
+#endif // _WIN32
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#endif // __linux__
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "GPUDetect.h"
+#ifdef __linux__
+#include "GPUDetectSysfs.h"
+#endif
+
+
+namespace GPUDetect
+{
+
+#ifdef _WIN32
+
+int QueryMemoryBudget( IDXGIAdapter* adapter, MemoryBudget* const budget )
+{
+	if( adapter == nullptr || budget == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*budget = {};
+
+	IDXGIAdapter3* adapter3 = nullptr;
+	if( FAILED( adapter->QueryInterface( __uuidof( IDXGIAdapter3 ), (void**) &adapter3 ) ) )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	const struct
+	{
+		DXGI_MEMORY_SEGMENT_GROUP segmentGroup;
+		MemoryRegion::Type type;
+	} segmentGroups[] =
+	{
+		{ DXGI_MEMORY_SEGMENT_GROUP_LOCAL, MemoryRegion::REGION_LOCAL },
+		{ DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, MemoryRegion::REGION_SYSTEM },
+	};
+
+	int returnCode = EXIT_SUCCESS;
+	for( const auto& group : segmentGroups )
+	{
+		DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+		if( FAILED( adapter3->QueryVideoMemoryInfo( 0, group.segmentGroup, &info ) ) )
+		{
+			returnCode = GPUDETECT_ERROR_GENERIC;
+			break;
+		}
+
+		// UMA adapters report everything as local and nothing as non-local
+		if( info.Budget == 0 )
+		{
+			continue;
+		}
+
+		MemoryRegion& region = budget->regions[ budget->regionCount++ ];
+		region.type = group.type;
+		region.totalBytes = info.Budget;
+		region.usageAvailability = true;
+		region.usedBytes = info.CurrentUsage;
+		region.availableBytes = info.Budget > info.CurrentUsage ? info.Budget - info.CurrentUsage : 0;
+	}
+
+	adapter3->Release();
+	return returnCode;
+}
+
+#endif // _WIN32
+
+#ifdef __linux__
+
+namespace
+{
+
+//
+// DRM_IOCTL_XE_DEVICE_QUERY with DRM_XE_DEVICE_QUERY_MEM_REGIONS, from the
+// xe uapi (include/uapi/drm/xe_drm.h), which is not installed everywhere
+//
+struct XeDeviceQuery
+{
+	uint64_t extensions;
+	uint32_t query;
+	uint32_t size;
+	uint64_t data;
+	uint64_t reserved[ 2 ];
+};
+
+struct XeMemRegion
+{
+	uint16_t memClass;
+	uint16_t instance;
+	uint32_t minPageSize;
+	uint64_t totalSize;
+	uint64_t used;
+	uint64_t cpuVisibleSize;
+	uint64_t cpuVisibleUsed;
+	uint64_t reserved[ 6 ];
+};
+
+struct XeQueryMemRegions
+{
+	uint32_t numMemRegions;
+	uint32_t pad;
+	// XeMemRegion memRegions[ numMemRegions ] follow
+};
+
+static_assert( sizeof( XeDeviceQuery ) == 40, "struct size mismatch" );
+static_assert( sizeof( XeMemRegion ) == 88, "struct size mismatch" );
+
+const uint32_t kXeDeviceQueryMemRegions = 1;
+const uint16_t kXeMemRegionClassVram = 1;
+const unsigned long kXeIoctlDeviceQuery = _IOWR( 'd', 0x40 + 0x00, XeDeviceQuery );
+
+// Opens the render node of class/drm/cardN, or returns -1
+int OpenRenderNode( const char* sysfsRoot, int cardNumber )
+{
+	char path[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/device/drm", sysfsRoot, cardNumber ) )
+	{
+		return -1;
+	}
+
+	DIR* dir = ::opendir( path );
+	if( dir == nullptr )
+	{
+		return -1;
+	}
+
+	int fd = -1;
+	while( const dirent* entry = ::readdir( dir ) )
+	{
+		if( strncmp( entry->d_name, "renderD", 7 ) == 0 &&
+			FormatSysfsPath( path, sizeof( path ), "/dev/dri/%s", entry->d_name ) )
+		{
+			fd = ::open( path, O_RDWR | O_CLOEXEC );
+			break;
+		}
+	}
+	::closedir( dir );
+	return fd;
+}
+
+// Fills the usage of the VRAM regions of budget, in tile order, from the xe
+// memory region query. xe only reports usage to CAP_PERFMON; to other
+// processes used is always 0, which is then taken to mean no usage.
+void ReadXeMemoryUsage( const char* sysfsRoot, int cardNumber, MemoryBudget* const budget )
+{
+	const int fd = OpenRenderNode( sysfsRoot, cardNumber );
+	if( fd < 0 )
+	{
+		return;
+	}
+
+	// The first call returns the size of the answer
+	XeDeviceQuery query = {};
+	query.query = kXeDeviceQueryMemRegions;
+	std::vector< uint64_t > data;
+	if( ::ioctl( fd, kXeIoctlDeviceQuery, &query ) == 0 && query.size >= sizeof( XeQueryMemRegions ) )
+	{
+		data.resize( ( query.size + sizeof( uint64_t ) - 1 ) / sizeof( uint64_t ) );
+		query.data = (uint64_t) (uintptr_t) data.data();
+		if( ::ioctl( fd, kXeIoctlDeviceQuery, &query ) != 0 )
+		{
+			data.clear();
+		}
+	}
+	::close( fd );
+
+	if( data.empty() )
+	{
+		return;
+	}
+
+	const XeQueryMemRegions* regions = (const XeQueryMemRegions*) data.data();
+	const XeMemRegion* memRegions = (const XeMemRegion*) ( regions + 1 );
+	const size_t maxCount = ( query.size - sizeof( XeQueryMemRegions ) ) / sizeof( XeMemRegion );
+
+	unsigned int regionIndex = 0;
+	for( size_t i = 0; i < regions->numMemRegions && i < maxCount && regionIndex < budget->regionCount; ++i )
+	{
+		const XeMemRegion& memRegion = memRegions[ i ];
+		if( memRegion.memClass != kXeMemRegionClassVram )
+		{
+			continue;
+		}
+
+		MemoryRegion& region = budget->regions[ regionIndex++ ];
+		if( memRegion.used != 0 && memRegion.used <= region.totalBytes )
+		{
+			region.usageAvailability = true;
+			region.usedBytes = memRegion.used;
+			region.availableBytes = region.totalBytes - memRegion.used;
+		}
+	}
+}
+
+}
+
+int QueryMemoryBudget( int adapterIndex, const char* sysfsRoot, MemoryBudget* const budget )
+{
+	if( adapterIndex < 0 || sysfsRoot == nullptr || budget == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*budget = {};
+
+	int cardNumber = 0;
+	const int returnCode = FindSysfsCard( sysfsRoot, adapterIndex, &cardNumber );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	char path[ kMaxSysfsPath ];
+
+	// i915 reports all local memory as one region
+	uint64_t totalBytes = 0;
+	uint64_t availableBytes = 0;
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/lmem_total_bytes", sysfsRoot, cardNumber ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	if( ReadSysfsValue( path, 10, &totalBytes ) && totalBytes != 0 )
+	{
+		MemoryRegion& region = budget->regions[ budget->regionCount++ ];
+		region.type = MemoryRegion::REGION_LOCAL;
+		region.totalBytes = totalBytes;
+
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/lmem_avail_bytes", sysfsRoot, cardNumber ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		if( ReadSysfsValue( path, 10, &availableBytes ) && availableBytes <= totalBytes )
+		{
+			region.usageAvailability = true;
+			region.availableBytes = availableBytes;
+			region.usedBytes = totalBytes - availableBytes;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// xe has one VRAM region per tile
+	for( unsigned int tile = 0; tile < MemoryBudget::MAX_REGIONS; ++tile )
+	{
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/device/tile%u/physical_vram_size_bytes", sysfsRoot, cardNumber, tile ) )
+		{
+			return GPUDETECT_ERROR_SYSFS_READ;
+		}
+		if( !ReadSysfsValue( path, 0, &totalBytes ) )
+		{
+			break;
+		}
+		if( totalBytes == 0 )
+		{
+			continue;
+		}
+
+		MemoryRegion& region = budget->regions[ budget->regionCount++ ];
+		region.type = MemoryRegion::REGION_LOCAL;
+		region.instance = tile;
+		region.totalBytes = totalBytes;
+	}
+
+	if( budget->regionCount == 0 )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	// sysfs has no usage for xe. The device node under /dev belongs to the
+	// real sysfs only, so a fake tree does not query it.
+	if( strcmp( sysfsRoot, "/sys" ) == 0 )
+	{
+		ReadXeMemoryUsage( sysfsRoot, cardNumber, budget );
+	}
+	return EXIT_SUCCESS;
+}
+
+#endif // __linux__
+
+MemoryBudgetMonitor::MemoryBudgetMonitor( Callback callback, void* context )
+	: m_callback( callback )
+	, m_context( context )
+	, m_thresholds()
+	, m_thresholdCount( 0 )
+	, m_levels()
+{
+}
+
+int MemoryBudgetMonitor::SetThresholds( const float* thresholds, unsigned int thresholdCount )
+{
+	if( thresholdCount > MAX_THRESHOLDS || ( thresholds == nullptr && thresholdCount > 0 ) )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	for( unsigned int i = 0; i < thresholdCount; ++i )
+	{
+		const float previous = i == 0 ? 0.0f : thresholds[ i - 1 ];
+		if( !( thresholds[ i ] > previous && thresholds[ i ] <= 1.0f ) )
+		{
+			return GPUDETECT_ERROR_BAD_DATA;
+		}
+	}
+
+	for( unsigned int i = 0; i < thresholdCount; ++i )
+	{
+		m_thresholds[ i ] = thresholds[ i ];
+	}
+	m_thresholdCount = thresholdCount;
+
+	for( unsigned int& level : m_levels )
+	{
+		level = 0;
+	}
+	return EXIT_SUCCESS;
+}
+
+void MemoryBudgetMonitor::Update( const MemoryBudget& budget )
+{
+	for( unsigned int regionIndex = 0; regionIndex < budget.regionCount && regionIndex < MemoryBudget::MAX_REGIONS; ++regionIndex )
+	{
+		const MemoryRegion& region = budget.regions[ regionIndex ];
+		if( !region.usageAvailability || region.totalBytes == 0 )
+		{
+			continue;
+		}
+
+		unsigned int level = 0;
+		while( level < m_thresholdCount &&
+			region.usedBytes >= (uint64_t) ( (double) m_thresholds[ level ] * region.totalBytes ) )
+		{
+			++level;
+		}
+
+		unsigned int& previousLevel = m_levels[ regionIndex ];
+		if( level == previousLevel )
+		{
+			continue;
+		}
+
+		Event event = {};
+		event.regionIndex = regionIndex;
+		event.region = &region;
+		event.rising = level > previousLevel;
+
+		// Report the crossings nearest the old usage first
+		if( event.rising )
+		{
+			for( unsigned int i = previousLevel; i < level; ++i )
+			{
+				event.threshold = m_thresholds[ i ];
+				if( m_callback != nullptr )
+				{
+					m_callback( event, m_context );
+				}
+			}
+		}
+		else
+		{
+			for( unsigned int i = previousLevel; i > level; --i )
+			{
+				event.threshold = m_thresholds[ i - 1 ];
+				if( m_callback != nullptr )
+				{
+					m_callback( event, m_context );
+				}
+			}
+		}
+		previousLevel = level;
+	}
+}
+
+}
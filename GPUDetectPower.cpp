@@ -0,0 +1,412 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "GPUDetect.h"
+#include "GPUDetectSysfs.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+// At 1 sample per ms this still covers a 1 s window
+const size_t kMaxWindowSamples = 1024;
+
+// Opens an energy counter. Returns the file descriptor, or -1 with
+// returnCode set to GPUDETECT_ERROR_NOT_SUPPORTED if the file does not exist,
+// or GPUDETECT_ERROR_SYSFS_READ if it cannot be opened.
+int OpenCounter( const char* path, int* returnCode )
+{
+	const int fd = ::open( path, O_RDONLY | O_CLOEXEC );
+	if( fd < 0 )
+	{
+		*returnCode = ::access( path, F_OK ) == 0 ? GPUDETECT_ERROR_SYSFS_READ : GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+	return fd;
+}
+
+// Finds the lowest numbered energy*_input of the card's hwmon devices. i915
+// exposes energy1_input; xe exposes energy1_input for the card and
+// energy2_input for the package. Returns EXIT_SUCCESS,
+// GPUDETECT_ERROR_NOT_SUPPORTED if there is none, or
+// GPUDETECT_ERROR_SYSFS_READ if a path does not fit in kMaxSysfsPath.
+int FindHwmonEnergyInput( const char* sysfsRoot, int cardNumber, char* path, size_t pathSize )
+{
+	char hwmonPath[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( hwmonPath, sizeof( hwmonPath ), "%s/class/drm/card%d/device/hwmon", sysfsRoot, cardNumber ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	DIR* hwmonDir = opendir( hwmonPath );
+	if( hwmonDir == nullptr )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	int returnCode = EXIT_SUCCESS;
+	unsigned int bestIndex = UINT32_MAX;
+	while( const dirent* hwmon = readdir( hwmonDir ) )
+	{
+		if( strncmp( hwmon->d_name, "hwmon", 5 ) != 0 )
+		{
+			continue;
+		}
+
+		char devicePath[ kMaxSysfsPath ];
+		if( !FormatSysfsPath( devicePath, sizeof( devicePath ), "%s/%s", hwmonPath, hwmon->d_name ) )
+		{
+			returnCode = GPUDETECT_ERROR_SYSFS_READ;
+			break;
+		}
+
+		DIR* deviceDir = opendir( devicePath );
+		if( deviceDir == nullptr )
+		{
+			continue;
+		}
+
+		while( const dirent* entry = readdir( deviceDir ) )
+		{
+			unsigned int index = 0;
+			char suffix[ 8 ] = {};
+			if( sscanf( entry->d_name, "energy%u_%7s", &index, suffix ) == 2 &&
+				strcmp( suffix, "input" ) == 0 && index < bestIndex )
+			{
+				if( !FormatSysfsPath( path, pathSize, "%s/%s", devicePath, entry->d_name ) )
+				{
+					returnCode = GPUDETECT_ERROR_SYSFS_READ;
+					break;
+				}
+				bestIndex = index;
+			}
+		}
+		closedir( deviceDir );
+
+		if( returnCode != EXIT_SUCCESS )
+		{
+			break;
+		}
+	}
+	closedir( hwmonDir );
+
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+	return bestIndex != UINT32_MAX ? EXIT_SUCCESS : GPUDETECT_ERROR_NOT_SUPPORTED;
+}
+
+}
+
+struct PowerSampler::Impl
+{
+	explicit Impl( unsigned int windowMs )
+		: windowUs( std::max( windowMs, 1u ) * 1000ull )
+		, window( kMaxWindowSamples )
+	{
+	}
+
+	~Impl()
+	{
+		Close();
+	}
+
+	void Close()
+	{
+		if( energyFd >= 0 )
+		{
+			::close( energyFd );
+			energyFd = -1;
+		}
+		source = PowerStats::SOURCE_NONE;
+	}
+
+	// Requires mutex
+	void ResetStats()
+	{
+		sampleCount = 0;
+		totalEnergyUj = 0;
+		windowFirst = 0;
+		windowCount = 0;
+	}
+
+	struct WindowSample
+	{
+		uint64_t timeUs;
+		uint64_t energyUj;   // totalEnergyUj when the sample was taken
+	};
+
+	const uint64_t windowUs;
+
+	int energyFd = -1;
+	PowerStats::Source source = PowerStats::SOURCE_NONE;
+	uint64_t maxEnergyRangeUj = 0;   // 0 if the counter does not wrap
+	unsigned int packageTDP = 0;
+
+	mutable std::mutex mutex;
+	uint64_t sampleCount = 0;
+	uint64_t totalEnergyUj = 0;
+	uint64_t lastCounterUj = 0;
+	std::vector< WindowSample > window;
+	size_t windowFirst = 0;
+	size_t windowCount = 0;
+
+	std::thread thread;
+	std::condition_variable stopCondition;
+	bool stopRequested = false;
+};
+
+PowerSampler::PowerSampler( unsigned int windowMs )
+	: m_impl( new Impl( windowMs ) )
+{
+}
+
+PowerSampler::~PowerSampler()
+{
+	Stop();
+	delete m_impl;
+}
+
+int PowerSampler::Open( int adapterIndex, const char* sysfsRoot, unsigned int packageTDP )
+{
+	if( adapterIndex < 0 || sysfsRoot == nullptr || m_impl->thread.joinable() )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	m_impl->Close();
+	Reset();
+	m_impl->packageTDP = packageTDP;
+
+	int cardNumber = 0;
+	int returnCode = FindSysfsCard( sysfsRoot, adapterIndex, &cardNumber );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	// The hwmon counter is 64 bits wide and does not wrap in practice
+	char path[ kMaxSysfsPath ];
+	returnCode = FindHwmonEnergyInput( sysfsRoot, cardNumber, path, sizeof( path ) );
+	if( returnCode == EXIT_SUCCESS )
+	{
+		m_impl->energyFd = OpenCounter( path, &returnCode );
+		if( m_impl->energyFd < 0 )
+		{
+			return returnCode;
+		}
+		m_impl->source = PowerStats::SOURCE_HWMON;
+		m_impl->maxEnergyRangeUj = 0;
+		return EXIT_SUCCESS;
+	}
+	if( returnCode != GPUDETECT_ERROR_NOT_SUPPORTED )
+	{
+		return returnCode;
+	}
+
+	// Integrated GPUs have no counter of their own, so fall back to the
+	// package they share with the CPU
+	char name[ 32 ];
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/powercap/intel-rapl:0/name", sysfsRoot ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	if( ReadSysfsFile( path, name, sizeof( name ) ) <= 0 || strncmp( name, "package", 7 ) != 0 )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	uint64_t maxEnergyRangeUj = 0;
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/powercap/intel-rapl:0/max_energy_range_uj", sysfsRoot ) ||
+		!ReadSysfsValue( path, 10, &maxEnergyRangeUj ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/powercap/intel-rapl:0/energy_uj", sysfsRoot ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	m_impl->energyFd = OpenCounter( path, &returnCode );
+	if( m_impl->energyFd < 0 )
+	{
+		return returnCode;
+	}
+	m_impl->source = PowerStats::SOURCE_RAPL_PACKAGE;
+	m_impl->maxEnergyRangeUj = maxEnergyRangeUj;
+	return EXIT_SUCCESS;
+}
+
+int PowerSampler::Sample()
+{
+	if( m_impl->energyFd < 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	uint64_t counterUj = 0;
+	if( !RereadSysfsValue( m_impl->energyFd, &counterUj ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	const uint64_t nowUs = std::chrono::duration_cast< std::chrono::microseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+
+	if( m_impl->sampleCount > 0 )
+	{
+		const uint64_t lastUj = m_impl->lastCounterUj;
+		if( counterUj >= lastUj )
+		{
+			m_impl->totalEnergyUj += counterUj - lastUj;
+		}
+		else if( m_impl->maxEnergyRangeUj > lastUj )
+		{
+			// RAPL counters wrap to 0 after max_energy_range_uj
+			m_impl->totalEnergyUj += m_impl->maxEnergyRangeUj - lastUj + counterUj;
+		}
+		// Otherwise the counter was reset, and the interval is lost
+	}
+	m_impl->lastCounterUj = counterUj;
+	++m_impl->sampleCount;
+
+	std::vector< Impl::WindowSample >& window = m_impl->window;
+	if( m_impl->windowCount == window.size() )
+	{
+		m_impl->windowFirst = ( m_impl->windowFirst + 1 ) % window.size();
+		--m_impl->windowCount;
+	}
+	window[ ( m_impl->windowFirst + m_impl->windowCount ) % window.size() ] = { nowUs, m_impl->totalEnergyUj };
+	++m_impl->windowCount;
+
+	// Keep the newest sample that is at least windowUs old as the start of the
+	// window, so the average covers the whole window
+	while( m_impl->windowCount > 2 &&
+		nowUs - window[ ( m_impl->windowFirst + 1 ) % window.size() ].timeUs >= m_impl->windowUs )
+	{
+		m_impl->windowFirst = ( m_impl->windowFirst + 1 ) % window.size();
+		--m_impl->windowCount;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int PowerSampler::Start( unsigned int intervalMs )
+{
+	if( m_impl->energyFd < 0 || m_impl->thread.joinable() || intervalMs == 0 )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	m_impl->stopRequested = false;
+	m_impl->thread = std::thread( [ this, intervalMs ]()
+	{
+		const auto interval = std::chrono::milliseconds( intervalMs );
+		auto nextSample = std::chrono::steady_clock::now();
+
+		std::unique_lock< std::mutex > lock( m_impl->mutex );
+		while( !m_impl->stopRequested )
+		{
+			lock.unlock();
+			Sample();
+			lock.lock();
+
+			nextSample += interval;
+			m_impl->stopCondition.wait_until( lock, nextSample, [ this ]() { return m_impl->stopRequested; } );
+		}
+	} );
+
+	return EXIT_SUCCESS;
+}
+
+void PowerSampler::Stop()
+{
+	if( !m_impl->thread.joinable() )
+	{
+		return;
+	}
+
+	{
+		std::lock_guard< std::mutex > lock( m_impl->mutex );
+		m_impl->stopRequested = true;
+	}
+	m_impl->stopCondition.notify_all();
+	m_impl->thread.join();
+}
+
+void PowerSampler::GetStats( PowerStats* const stats ) const
+{
+	if( stats == nullptr )
+	{
+		return;
+	}
+
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	*stats = {};
+	stats->source = m_impl->source;
+	stats->sampleCount = m_impl->sampleCount;
+	stats->totalEnergyUj = m_impl->totalEnergyUj;
+
+	if( m_impl->windowCount < 2 )
+	{
+		return;
+	}
+
+	const std::vector< Impl::WindowSample >& window = m_impl->window;
+	const Impl::WindowSample& first = window[ m_impl->windowFirst ];
+	const Impl::WindowSample& last = window[ ( m_impl->windowFirst + m_impl->windowCount - 1 ) % window.size() ];
+	stats->windowUs = last.timeUs - first.timeUs;
+	if( stats->windowUs == 0 )
+	{
+		return;
+	}
+
+	// uJ / us is W
+	stats->averageWatts = (float) ( last.energyUj - first.energyUj ) / stats->windowUs;
+	if( m_impl->packageTDP != 0 )
+	{
+		stats->fractionOfTDP = stats->averageWatts / m_impl->packageTDP;
+	}
+}
+
+void PowerSampler::Reset()
+{
+	std::lock_guard< std::mutex > lock( m_impl->mutex );
+	m_impl->ResetStats();
+}
+
+}
+
+#endif // __linux__
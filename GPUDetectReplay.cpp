@@ -0,0 +1,878 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#endif // _WIN32
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "GPUDetectBackend.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+//
+// Recording file layout, in little-endian byte order:
+//
+//     uint32_t magic
+//     uint32_t formatVersion
+//     uint32_t recordCount
+//     Record[ recordCount ]
+//     uint32_t checksum    FNV-1a of everything above
+//
+// Record:
+//     uint8_t  type        RecordType
+//     int32_t  a, b        the question's arguments, see RecordType
+//     uint16_t nameLength, char name[ nameLength ]
+//     int32_t  result
+//     uint32_t latencyUs   how long the recorded source took to answer
+//     uint32_t payloadLength, uint8_t payload[ payloadLength ]
+//
+// Strings from the platform (adapter descriptions) are stored as UTF-16 code
+// units, so a recording made on Windows replays on Linux.
+//
+const uint32_t kReplayMagic = 0x52445047; // "GPDR"
+const uint32_t kReplayFormatVersion = 1;
+
+enum RecordType : uint8_t
+{
+	RECORD_ADAPTER_COUNT = 1,         // result: count
+	RECORD_ADAPTER_DESC,              // a: adapter. payload: AdapterDesc
+	RECORD_DEVICE_CAPS,               // a: adapter, b: queryIntelExtension. payload: DeviceCaps
+	RECORD_COUNTER_SOURCE,            // a: adapter
+	RECORD_COUNTER_COUNT,             // a: adapter. result: count
+	RECORD_COUNTER_CHECK,             // a: adapter, b: counter. result: bool. payload: name, description
+	RECORD_COUNTER_DATA,              // a: adapter, b: counter. payload: the counter data
+	RECORD_REGISTRY_SUBKEY_COUNT,     // payload: count
+	RECORD_REGISTRY_QWORD,            // a: subkey, name: value name. result: bool. payload: value
+};
+
+typedef std::tuple< uint8_t, int32_t, int32_t, std::string > Question;
+
+struct Answer
+{
+	int32_t result;
+	uint32_t latencyUs;
+	std::vector< uint8_t > payload;
+};
+
+typedef std::map< Question, Answer > Answers;
+
+uint32_t Fnv1a( const void* data, size_t size, uint32_t hash = 2166136261u )
+{
+	const unsigned char* bytes = static_cast<const unsigned char*>( data );
+	for( size_t i = 0; i < size; ++i )
+	{
+		hash ^= bytes[ i ];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+//
+// Little-endian serialization of the payloads and of the file
+//
+class Writer
+{
+public:
+	void PutU8( uint8_t value )
+	{
+		m_bytes.push_back( value );
+	}
+
+	void PutU16( uint16_t value )
+	{
+		PutU8( (uint8_t) value );
+		PutU8( (uint8_t) ( value >> 8 ) );
+	}
+
+	void PutU32( uint32_t value )
+	{
+		PutU16( (uint16_t) value );
+		PutU16( (uint16_t) ( value >> 16 ) );
+	}
+
+	void PutU64( uint64_t value )
+	{
+		PutU32( (uint32_t) value );
+		PutU32( (uint32_t) ( value >> 32 ) );
+	}
+
+	void PutBytes( const void* data, size_t size )
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>( data );
+		m_bytes.insert( m_bytes.end(), bytes, bytes + size );
+	}
+
+	std::vector< uint8_t >& Bytes()
+	{
+		return m_bytes;
+	}
+
+private:
+	std::vector< uint8_t > m_bytes;
+};
+
+// Reads past the end fail and leave the reader failed
+class Reader
+{
+public:
+	Reader( const uint8_t* data, size_t size )
+		: m_data( data )
+		, m_size( size )
+	{
+	}
+
+	bool GetU8( uint8_t* value )
+	{
+		if( !Has( 1 ) )
+		{
+			return false;
+		}
+		*value = m_data[ m_offset++ ];
+		return true;
+	}
+
+	bool GetU16( uint16_t* value )
+	{
+		uint8_t low = 0, high = 0;
+		if( !GetU8( &low ) || !GetU8( &high ) )
+		{
+			return false;
+		}
+		*value = (uint16_t) ( low | ( high << 8 ) );
+		return true;
+	}
+
+	bool GetU32( uint32_t* value )
+	{
+		uint16_t low = 0, high = 0;
+		if( !GetU16( &low ) || !GetU16( &high ) )
+		{
+			return false;
+		}
+		*value = low | ( (uint32_t) high << 16 );
+		return true;
+	}
+
+	bool GetU64( uint64_t* value )
+	{
+		uint32_t low = 0, high = 0;
+		if( !GetU32( &low ) || !GetU32( &high ) )
+		{
+			return false;
+		}
+		*value = low | ( (uint64_t) high << 32 );
+		return true;
+	}
+
+	bool GetBytes( void* data, size_t size )
+	{
+		if( !Has( size ) )
+		{
+			return false;
+		}
+		if( size != 0 )
+		{
+			memcpy( data, m_data + m_offset, size );
+		}
+		m_offset += size;
+		return true;
+	}
+
+	bool AtEnd() const
+	{
+		return !m_failed && m_offset == m_size;
+	}
+
+private:
+	bool Has( size_t size )
+	{
+		m_failed = m_failed || size > m_size - m_offset;
+		return !m_failed;
+	}
+
+	const uint8_t* m_data;
+	size_t m_size;
+	size_t m_offset = 0;
+	bool m_failed = false;
+};
+
+std::vector< uint8_t > SerializeAdapterDesc( const AdapterDesc& desc )
+{
+	Writer writer;
+	writer.PutU32( desc.vendorID );
+	writer.PutU32( desc.deviceID );
+	writer.PutU32( desc.adapterLUID.LowPart );
+	writer.PutU32( (uint32_t) desc.adapterLUID.HighPart );
+	for( WCHAR c : desc.description )
+	{
+		writer.PutU16( (uint16_t) c );
+	}
+	writer.PutU64( desc.dedicatedVideoMemory );
+	writer.PutU64( desc.sharedSystemMemory );
+	return writer.Bytes();
+}
+
+bool DeserializeAdapterDesc( const std::vector< uint8_t >& payload, AdapterDesc* desc )
+{
+	Reader reader( payload.data(), payload.size() );
+
+	uint32_t lowPart = 0, highPart = 0;
+	bool valid = reader.GetU32( &desc->vendorID ) &&
+		reader.GetU32( &desc->deviceID ) &&
+		reader.GetU32( &lowPart ) &&
+		reader.GetU32( &highPart );
+	desc->adapterLUID.LowPart = lowPart;
+	desc->adapterLUID.HighPart = (int32_t) highPart;
+
+	for( WCHAR& c : desc->description )
+	{
+		uint16_t codeUnit = 0;
+		valid = valid && reader.GetU16( &codeUnit );
+		c = (WCHAR) codeUnit;
+	}
+
+	uint64_t dedicatedVideoMemory = 0, sharedSystemMemory = 0;
+	valid = valid && reader.GetU64( &dedicatedVideoMemory ) && reader.GetU64( &sharedSystemMemory );
+	desc->dedicatedVideoMemory = dedicatedVideoMemory;
+	desc->sharedSystemMemory = sharedSystemMemory;
+	return valid && reader.AtEnd();
+}
+
+std::vector< uint8_t > SerializeDeviceCaps( const DeviceCaps& caps )
+{
+	Writer writer;
+	writer.PutU32( (uint32_t) caps.isUMAArchitecture );
+	writer.PutU32( caps.extensionVersion );
+	writer.PutU64( caps.driverVersion );
+	return writer.Bytes();
+}
+
+bool DeserializeDeviceCaps( const std::vector< uint8_t >& payload, DeviceCaps* caps )
+{
+	Reader reader( payload.data(), payload.size() );
+
+	uint32_t isUMAArchitecture = 0;
+	const bool valid = reader.GetU32( &isUMAArchitecture ) &&
+		reader.GetU32( &caps->extensionVersion ) &&
+		reader.GetU64( &caps->driverVersion );
+	caps->isUMAArchitecture = (int32_t) isUMAArchitecture;
+	return valid && reader.AtEnd();
+}
+
+//
+// Records what each question took to answer
+//
+class Recorder
+{
+public:
+	explicit Recorder( Answers* answers )
+		: m_answers( answers )
+	{
+	}
+
+	void Start()
+	{
+		m_start = std::chrono::steady_clock::now();
+	}
+
+	void Record( RecordType type, int32_t a, int32_t b, const char* name, int32_t result, std::vector< uint8_t > payload = std::vector< uint8_t >() )
+	{
+		const auto elapsed = std::chrono::steady_clock::now() - m_start;
+
+		Answer& answer = ( *m_answers )[ Question( type, a, b, name ) ];
+		answer.result = result;
+		answer.latencyUs = (uint32_t) std::chrono::duration_cast< std::chrono::microseconds >( elapsed ).count();
+		answer.payload = std::move( payload );
+	}
+
+private:
+	Answers* m_answers;
+	std::chrono::steady_clock::time_point m_start;
+};
+
+//
+// Looks up recorded answers and waits for their recorded latency
+//
+class Player
+{
+public:
+	Player( const Answers* answers, bool simulateLatency )
+		: m_answers( answers )
+		, m_simulateLatency( simulateLatency )
+	{
+	}
+
+	const Answer* Find( RecordType type, int32_t a, int32_t b, const char* name = "" ) const
+	{
+		const auto it = m_answers->find( Question( type, a, b, name ) );
+		if( it == m_answers->end() )
+		{
+			return nullptr;
+		}
+
+		if( m_simulateLatency && it->second.latencyUs != 0 )
+		{
+			// Spin rather than sleep, since most answers take well under the
+			// scheduler's sleep granularity
+			const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds( it->second.latencyUs );
+			while( std::chrono::steady_clock::now() < end )
+			{
+				std::this_thread::yield();
+			}
+		}
+		return &it->second;
+	}
+
+private:
+	const Answers* m_answers;
+	bool m_simulateLatency;
+};
+
+class RecordingCounterSource : public ICounterSource
+{
+public:
+	RecordingCounterSource( ICounterSource* source, Answers* answers, int adapterIndex )
+		: m_source( source )
+		, m_recorder( answers )
+		, m_adapterIndex( adapterIndex )
+	{
+	}
+
+	int GetCounterCount() override
+	{
+		m_recorder.Start();
+		const int count = m_source->GetCounterCount();
+		m_recorder.Record( RECORD_COUNTER_COUNT, m_adapterIndex, 0, "", count );
+		return count;
+	}
+
+	bool CheckCounter( int counterIndex, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength ) override
+	{
+		//
+		// Always record the full strings, whatever buffers this caller passed,
+		// so a replay can answer any caller
+		//
+		char fullName[ 256 ] = {};
+		char fullDescription[ 1024 ] = {};
+		unsigned int fullNameLength = sizeof( fullName );
+		unsigned int fullDescriptionLength = sizeof( fullDescription );
+
+		m_recorder.Start();
+		const bool found = m_source->CheckCounter( counterIndex, fullName, &fullNameLength, fullDescription, &fullDescriptionLength );
+
+		Writer writer;
+		if( found )
+		{
+			fullName[ sizeof( fullName ) - 1 ] = '\0';
+			fullDescription[ sizeof( fullDescription ) - 1 ] = '\0';
+			const size_t nameSize = strlen( fullName ) + 1;
+			const size_t descriptionSize = strlen( fullDescription ) + 1;
+			writer.PutU32( (uint32_t) nameSize );
+			writer.PutBytes( fullName, nameSize );
+			writer.PutU32( (uint32_t) descriptionSize );
+			writer.PutBytes( fullDescription, descriptionSize );
+		}
+		m_recorder.Record( RECORD_COUNTER_CHECK, m_adapterIndex, counterIndex, "", found, std::move( writer.Bytes() ) );
+
+		return found && CopyCounterStrings( fullName, fullDescription, name, nameLength, description, descriptionLength );
+	}
+
+	int GetCounterData( int counterIndex, void* data, unsigned int dataSize ) override
+	{
+		m_recorder.Start();
+		const int returnCode = m_source->GetCounterData( counterIndex, data, dataSize );
+
+		std::vector< uint8_t > payload;
+		if( returnCode == EXIT_SUCCESS )
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>( data );
+			payload.assign( bytes, bytes + dataSize );
+		}
+		m_recorder.Record( RECORD_COUNTER_DATA, m_adapterIndex, counterIndex, "", returnCode, std::move( payload ) );
+		return returnCode;
+	}
+
+	// Copies the strings with the buffer semantics of ICounterSource::CheckCounter
+	static bool CopyCounterStrings( const char* fullName, const char* fullDescription, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength )
+	{
+		const unsigned int nameSize = (unsigned int) strlen( fullName ) + 1;
+		const unsigned int descriptionSize = (unsigned int) strlen( fullDescription ) + 1;
+
+		const bool fits = nameSize <= *nameLength && descriptionSize <= *descriptionLength;
+		if( fits )
+		{
+			memcpy( name, fullName, nameSize );
+			memcpy( description, fullDescription, descriptionSize );
+		}
+
+		*nameLength = nameSize;
+		*descriptionLength = descriptionSize;
+		return fits;
+	}
+
+private:
+	ICounterSource* m_source;
+	Recorder m_recorder;
+	int m_adapterIndex;
+};
+
+class ReplayCounterSource : public ICounterSource
+{
+public:
+	ReplayCounterSource( const Player* player, int adapterIndex )
+		: m_player( player )
+		, m_adapterIndex( adapterIndex )
+	{
+	}
+
+	int GetCounterCount() override
+	{
+		const Answer* answer = m_player->Find( RECORD_COUNTER_COUNT, m_adapterIndex, 0 );
+		return answer != nullptr ? answer->result : 0;
+	}
+
+	bool CheckCounter( int counterIndex, char* name, unsigned int* nameLength, char* description, unsigned int* descriptionLength ) override
+	{
+		const Answer* answer = m_player->Find( RECORD_COUNTER_CHECK, m_adapterIndex, counterIndex );
+		if( answer == nullptr || answer->result == 0 )
+		{
+			return false;
+		}
+
+		Reader reader( answer->payload.data(), answer->payload.size() );
+		uint32_t nameSize = 0;
+		uint32_t descriptionSize = 0;
+		std::vector< char > fullName, fullDescription;
+		const bool valid = reader.GetU32( &nameSize ) &&
+			( fullName.resize( nameSize ), reader.GetBytes( fullName.data(), nameSize ) ) &&
+			reader.GetU32( &descriptionSize ) &&
+			( fullDescription.resize( descriptionSize ), reader.GetBytes( fullDescription.data(), descriptionSize ) ) &&
+			reader.AtEnd() && nameSize > 0 && descriptionSize > 0 &&
+			fullName.back() == '\0' && fullDescription.back() == '\0';
+
+		return valid && RecordingCounterSource::CopyCounterStrings( fullName.data(), fullDescription.data(), name, nameLength, description, descriptionLength );
+	}
+
+	int GetCounterData( int counterIndex, void* data, unsigned int dataSize ) override
+	{
+		const Answer* answer = m_player->Find( RECORD_COUNTER_DATA, m_adapterIndex, counterIndex );
+		if( answer == nullptr || ( answer->result == EXIT_SUCCESS && answer->payload.size() < dataSize ) )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+
+		if( answer->result == EXIT_SUCCESS )
+		{
+			memcpy( data, answer->payload.data(), dataSize );
+		}
+		return answer->result;
+	}
+
+private:
+	const Player* m_player;
+	int m_adapterIndex;
+};
+
+class RecordingSources : public IAdapterSource, public IDeviceSource, public IRegistrySource
+{
+public:
+	RecordingSources( const BackendSources& sources, Answers* answers )
+		: m_sources( sources )
+		, m_answers( answers )
+		, m_recorder( answers )
+	{
+	}
+
+	int GetAdapterCount() override
+	{
+		m_recorder.Start();
+		const int count = m_sources.adapters->GetAdapterCount();
+		m_recorder.Record( RECORD_ADAPTER_COUNT, 0, 0, "", count );
+		return count;
+	}
+
+	int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) override
+	{
+		m_recorder.Start();
+		const int returnCode = m_sources.adapters->GetAdapterDesc( adapterIndex, desc );
+		m_recorder.Record( RECORD_ADAPTER_DESC, adapterIndex, 0, "", returnCode,
+			returnCode == EXIT_SUCCESS ? SerializeAdapterDesc( *desc ) : std::vector< uint8_t >() );
+		return returnCode;
+	}
+
+	int GetDeviceCaps( int adapterIndex, bool queryIntelExtension, DeviceCaps* caps ) override
+	{
+		m_recorder.Start();
+		const int returnCode = m_sources.devices->GetDeviceCaps( adapterIndex, queryIntelExtension, caps );
+		m_recorder.Record( RECORD_DEVICE_CAPS, adapterIndex, queryIntelExtension, "", returnCode,
+			returnCode == EXIT_SUCCESS ? SerializeDeviceCaps( *caps ) : std::vector< uint8_t >() );
+		return returnCode;
+	}
+
+	int GetCounterSource( int adapterIndex, ICounterSource** counters ) override
+	{
+		ICounterSource* source = nullptr;
+		m_recorder.Start();
+		const int returnCode = m_sources.devices->GetCounterSource( adapterIndex, &source );
+		m_recorder.Record( RECORD_COUNTER_SOURCE, adapterIndex, 0, "", returnCode );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			return returnCode;
+		}
+
+		std::unique_ptr< RecordingCounterSource >& counterSource = m_counterSources[ adapterIndex ];
+		if( !counterSource )
+		{
+			counterSource.reset( new RecordingCounterSource( source, m_answers, adapterIndex ) );
+		}
+		*counters = counterSource.get();
+		return EXIT_SUCCESS;
+	}
+
+	int GetSubKeyCount( int* count ) override
+	{
+		m_recorder.Start();
+		const int returnCode = m_sources.registry->GetSubKeyCount( count );
+
+		Writer writer;
+		if( returnCode == EXIT_SUCCESS )
+		{
+			writer.PutU32( (uint32_t) *count );
+		}
+		m_recorder.Record( RECORD_REGISTRY_SUBKEY_COUNT, 0, 0, "", returnCode, std::move( writer.Bytes() ) );
+		return returnCode;
+	}
+
+	bool GetQwordValue( int subKeyIndex, const char* valueName, uint64_t* value ) override
+	{
+		m_recorder.Start();
+		const bool found = m_sources.registry->GetQwordValue( subKeyIndex, valueName, value );
+
+		Writer writer;
+		if( found )
+		{
+			writer.PutU64( *value );
+		}
+		m_recorder.Record( RECORD_REGISTRY_QWORD, subKeyIndex, 0, valueName, found, std::move( writer.Bytes() ) );
+		return found;
+	}
+
+private:
+	BackendSources m_sources;
+	Answers* m_answers;
+	Recorder m_recorder;
+	std::map< int, std::unique_ptr< RecordingCounterSource > > m_counterSources;
+};
+
+class ReplaySources : public IAdapterSource, public IDeviceSource, public IRegistrySource
+{
+public:
+	ReplaySources( const Answers* answers, bool simulateLatency )
+		: m_player( answers, simulateLatency )
+	{
+	}
+
+	int GetAdapterCount() override
+	{
+		const Answer* answer = m_player.Find( RECORD_ADAPTER_COUNT, 0, 0 );
+		return answer != nullptr ? answer->result : 0;
+	}
+
+	int GetAdapterDesc( int adapterIndex, AdapterDesc* desc ) override
+	{
+		const Answer* answer = m_player.Find( RECORD_ADAPTER_DESC, adapterIndex, 0 );
+		if( answer == nullptr || ( answer->result == EXIT_SUCCESS && !DeserializeAdapterDesc( answer->payload, desc ) ) )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+		return answer->result;
+	}
+
+	int GetDeviceCaps( int adapterIndex, bool queryIntelExtension, DeviceCaps* caps ) override
+	{
+		const Answer* answer = m_player.Find( RECORD_DEVICE_CAPS, adapterIndex, queryIntelExtension );
+		if( answer == nullptr || ( answer->result == EXIT_SUCCESS && !DeserializeDeviceCaps( answer->payload, caps ) ) )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+		return answer->result;
+	}
+
+	int GetCounterSource( int adapterIndex, ICounterSource** counters ) override
+	{
+		const Answer* answer = m_player.Find( RECORD_COUNTER_SOURCE, adapterIndex, 0 );
+		if( answer == nullptr )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+		if( answer->result != EXIT_SUCCESS )
+		{
+			return answer->result;
+		}
+
+		std::unique_ptr< ReplayCounterSource >& counterSource = m_counterSources[ adapterIndex ];
+		if( !counterSource )
+		{
+			counterSource.reset( new ReplayCounterSource( &m_player, adapterIndex ) );
+		}
+		*counters = counterSource.get();
+		return EXIT_SUCCESS;
+	}
+
+	int GetSubKeyCount( int* count ) override
+	{
+		const Answer* answer = m_player.Find( RECORD_REGISTRY_SUBKEY_COUNT, 0, 0 );
+		if( answer == nullptr )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+		if( answer->result != EXIT_SUCCESS )
+		{
+			return answer->result;
+		}
+
+		Reader reader( answer->payload.data(), answer->payload.size() );
+		uint32_t subKeyCount = 0;
+		if( !reader.GetU32( &subKeyCount ) || !reader.AtEnd() )
+		{
+			return GPUDETECT_ERROR_REPLAY_MISSING_ANSWER;
+		}
+		*count = (int) subKeyCount;
+		return EXIT_SUCCESS;
+	}
+
+	bool GetQwordValue( int subKeyIndex, const char* valueName, uint64_t* value ) override
+	{
+		const Answer* answer = m_player.Find( RECORD_REGISTRY_QWORD, subKeyIndex, 0, valueName );
+		if( answer == nullptr || answer->result == 0 )
+		{
+			return false;
+		}
+
+		Reader reader( answer->payload.data(), answer->payload.size() );
+		return reader.GetU64( value ) && reader.AtEnd();
+	}
+
+private:
+	Player m_player;
+	std::map< int, std::unique_ptr< ReplayCounterSource > > m_counterSources;
+};
+
+}
+
+struct BackendRecording::Impl
+{
+	Answers answers;
+	std::unique_ptr< RecordingSources > recordingSources;
+	std::unique_ptr< ReplaySources > replaySources;
+	std::unique_ptr< DriverVersionCache > driverVersions;
+
+	BackendSources Wrap( IAdapterSource* adapters, IDeviceSource* devices, IRegistrySource* registry )
+	{
+		driverVersions.reset( new DriverVersionCache );
+
+		BackendSources sources = {};
+		sources.adapters = adapters;
+		sources.devices = devices;
+		sources.registry = registry;
+		sources.driverVersions = driverVersions.get();
+		return sources;
+	}
+};
+
+BackendRecording::BackendRecording()
+	: m_impl( new Impl )
+{
+}
+
+BackendRecording::~BackendRecording()
+{
+	delete m_impl;
+}
+
+BackendSources BackendRecording::Record( const BackendSources& sources )
+{
+	m_impl->replaySources.reset();
+	m_impl->answers.clear();
+	m_impl->recordingSources.reset( new RecordingSources( sources, &m_impl->answers ) );
+
+	RecordingSources* recording = m_impl->recordingSources.get();
+	return m_impl->Wrap( recording, recording, recording );
+}
+
+BackendSources BackendRecording::Replay( bool simulateLatency )
+{
+	m_impl->recordingSources.reset();
+	m_impl->replaySources.reset( new ReplaySources( &m_impl->answers, simulateLatency ) );
+
+	ReplaySources* replay = m_impl->replaySources.get();
+	return m_impl->Wrap( replay, replay, replay );
+}
+
+int BackendRecording::Save( const char* fileName ) const
+{
+	if( fileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	Writer writer;
+	writer.PutU32( kReplayMagic );
+	writer.PutU32( kReplayFormatVersion );
+	writer.PutU32( (uint32_t) m_impl->answers.size() );
+
+	for( const auto& entry : m_impl->answers )
+	{
+		const std::string& name = std::get< 3 >( entry.first );
+		writer.PutU8( std::get< 0 >( entry.first ) );
+		writer.PutU32( (uint32_t) std::get< 1 >( entry.first ) );
+		writer.PutU32( (uint32_t) std::get< 2 >( entry.first ) );
+		writer.PutU16( (uint16_t) name.size() );
+		writer.PutBytes( name.data(), name.size() );
+		writer.PutU32( (uint32_t) entry.second.result );
+		writer.PutU32( entry.second.latencyUs );
+		writer.PutU32( (uint32_t) entry.second.payload.size() );
+		writer.PutBytes( entry.second.payload.data(), entry.second.payload.size() );
+	}
+
+	writer.PutU32( Fnv1a( writer.Bytes().data(), writer.Bytes().size() ) );
+
+	FILE* file = fopen( fileName, "wb" );
+	if( file == nullptr )
+	{
+		return GPUDETECT_ERROR_REPLAY_FILE;
+	}
+
+	bool written = fwrite( writer.Bytes().data(), 1, writer.Bytes().size(), file ) == writer.Bytes().size();
+	written = fclose( file ) == 0 && written;
+	return written ? EXIT_SUCCESS : GPUDETECT_ERROR_REPLAY_FILE;
+}
+
+int BackendRecording::Load( const char* fileName )
+{
+	if( fileName == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	m_impl->recordingSources.reset();
+	m_impl->replaySources.reset();
+	m_impl->answers.clear();
+
+	FILE* file = fopen( fileName, "rb" );
+	if( file == nullptr )
+	{
+		return GPUDETECT_ERROR_REPLAY_FILE;
+	}
+
+	std::vector< uint8_t > bytes;
+	uint8_t buffer[ 4096 ];
+	size_t bytesRead = 0;
+	while( ( bytesRead = fread( buffer, 1, sizeof( buffer ), file ) ) > 0 )
+	{
+		bytes.insert( bytes.end(), buffer, buffer + bytesRead );
+	}
+	const bool readError = ferror( file ) != 0;
+	fclose( file );
+
+	if( readError || bytes.size() < sizeof( uint32_t ) )
+	{
+		return GPUDETECT_ERROR_REPLAY_FILE;
+	}
+
+	const size_t contentSize = bytes.size() - sizeof( uint32_t );
+	uint32_t checksum = 0;
+	Reader checksumReader( bytes.data() + contentSize, sizeof( uint32_t ) );
+	if( !checksumReader.GetU32( &checksum ) || checksum != Fnv1a( bytes.data(), contentSize ) )
+	{
+		return GPUDETECT_ERROR_REPLAY_FILE;
+	}
+
+	Reader reader( bytes.data(), contentSize );
+	uint32_t magic = 0, formatVersion = 0, recordCount = 0;
+	bool valid = reader.GetU32( &magic ) && magic == kReplayMagic &&
+		reader.GetU32( &formatVersion ) && formatVersion == kReplayFormatVersion &&
+		reader.GetU32( &recordCount );
+
+	for( uint32_t i = 0; valid && i < recordCount; ++i )
+	{
+		uint8_t type = 0;
+		uint32_t a = 0, b = 0, result = 0, payloadLength = 0;
+		uint16_t nameLength = 0;
+		std::string name;
+		Answer answer = {};
+
+		valid = reader.GetU8( &type ) &&
+			reader.GetU32( &a ) &&
+			reader.GetU32( &b ) &&
+			reader.GetU16( &nameLength ) &&
+			( name.resize( nameLength ), reader.GetBytes( &name[ 0 ], nameLength ) ) &&
+			reader.GetU32( &result ) &&
+			reader.GetU32( &answer.latencyUs ) &&
+			reader.GetU32( &payloadLength ) &&
+			payloadLength <= contentSize &&
+			( answer.payload.resize( payloadLength ), reader.GetBytes( answer.payload.data(), payloadLength ) );
+
+		answer.result = (int32_t) result;
+		m_impl->answers[ Question( type, (int32_t) a, (int32_t) b, name ) ] = std::move( answer );
+	}
+
+	if( !valid || !reader.AtEnd() )
+	{
+		m_impl->answers.clear();
+		return GPUDETECT_ERROR_REPLAY_FILE;
+	}
+	return EXIT_SUCCESS;
+}
+
+}
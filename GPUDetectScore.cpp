@@ -0,0 +1,218 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+
+#endif // _WIN32
+
+#include <cmath>
+#include <cstdlib>
+
+#include "GPUDetect.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+//
+// Typical figures of each architecture's common GT2 SKU, for GPUs that do
+// not report their counters
+//
+struct ArchitectureDefaults
+{
+	INTEL_GPU_ARCHITECTURE architecture;
+	unsigned int euCount;
+	unsigned int maxFrequency;   // MHz
+	unsigned int maxFillRate;    // pixels/clock
+};
+
+const ArchitectureDefaults kArchitectureDefaults[] =
+{
+	{ IGFX_SANDYBRIDGE,  12, 1100,   2 },
+	{ IGFX_IVYBRIDGE,    16, 1150,   4 },
+	{ IGFX_HASWELL,      20, 1200,   4 },
+	{ IGFX_VALLEYVIEW,    4,  792,   1 },
+	{ IGFX_BROADWELL,    24, 1000,   8 },
+	{ IGFX_CHERRYVIEW,   16,  600,   4 },
+	{ IGFX_SKYLAKE,      24, 1050,   8 },
+	{ IGFX_KABYLAKE,     24, 1100,   8 },
+	{ IGFX_COFFEELAKE,   24, 1200,   8 },
+	{ IGFX_WHISKEYLAKE,  24, 1150,   8 },
+	{ IGFX_COMETLAKE,    24, 1200,   8 },
+	{ IGFX_BROXTON,      18,  650,   4 },
+	{ IGFX_GEMINILAKE,   18,  750,   4 },
+	{ IGFX_ICELAKE,      64, 1100,  16 },
+	{ IGFX_ICELAKE_LP,   64, 1100,  16 },
+	{ IGFX_LAKEFIELD,    64,  500,  16 },
+	{ IGFX_TIGERLAKE_LP, 96, 1350,  24 },
+	{ IGFX_ROCKETLAKE,   32, 1300,   8 },
+	{ IGFX_ADL,          32, 1450,   8 },
+	{ IGFX_ADL_LP,       96, 1400,  24 },
+	{ IGFX_DG1,          80, 1650,  20 },
+	{ DGFX_ACM,         512, 2100, 128 },
+};
+
+const ArchitectureDefaults* FindArchitectureDefaults( INTEL_GPU_ARCHITECTURE architecture )
+{
+	for( const ArchitectureDefaults& defaults : kArchitectureDefaults )
+	{
+		if( defaults.architecture == architecture )
+		{
+			return &defaults;
+		}
+	}
+	return nullptr;
+}
+
+// Every EU since Gen7, and every Xe-HPG vector engine, does 8 FP32 FMAs a clock
+float GetFp32FlopsPerClockPerEU( IntelGraphicsGeneration generation )
+{
+	return generation == INTEL_GFX_GEN6 ? 8.0f : 16.0f;
+}
+
+// One 4 texel sampler per 8 EUs; Xe-HPG has one texture unit per vector engine
+float GetTexelsPerClockPerEU( IntelGraphicsGeneration generation )
+{
+	return generation == INTEL_DGFX_ACM ? 1.0f : 0.5f;
+}
+
+// Shared memory bandwidth of the usual dual channel or 128-bit memory of
+// each generation's platforms
+float GetSharedBandwidthGBs( IntelGraphicsGeneration generation )
+{
+	switch( generation )
+	{
+		case INTEL_GFX_GEN6:
+		case INTEL_GFX_GEN7:   return 21.3f;   // DDR3-1333
+		case INTEL_GFX_GEN7_5:
+		case INTEL_GFX_GEN8:   return 25.6f;   // DDR3-1600
+		case INTEL_GFX_GEN9:
+		case INTEL_GFX_GEN9_5: return 38.4f;   // DDR4-2400
+		case INTEL_GFX_GEN10:
+		case INTEL_GFX_GEN11:  return 59.7f;   // LPDDR4x-3733
+		default:               return 68.3f;   // LPDDR4x-4266
+	}
+}
+
+float GetDedicatedBandwidthGBs( INTEL_GPU_ARCHITECTURE architecture, unsigned int euCount )
+{
+	// DG1 has LPDDR4x; Alchemist's GDDR6 bus width scales with its size
+	return architecture == IGFX_DG1 ? 68.3f : euCount * 1.09f;
+}
+
+MemoryBandwidthClass GetBandwidthClass( float bandwidthGBs )
+{
+	if( bandwidthGBs < 50.0f )
+		return BANDWIDTH_LOW;
+	if( bandwidthGBs < 150.0f )
+		return BANDWIDTH_MEDIUM;
+	if( bandwidthGBs < 400.0f )
+		return BANDWIDTH_HIGH;
+	return BANDWIDTH_VERY_HIGH;
+}
+
+//
+// The reference GPU, Intel HD Graphics 620, and the weight of each figure in
+// the score. Compute counts most, as it bounds most modern frame costs.
+//
+const float kReferenceFp32Gflops = 24 * 16.0f * 1.05f;
+const float kReferenceTexelRate = 24 * 0.5f * 1.05f;
+const float kReferencePixelRate = 8 * 1.05f;
+const float kReferenceBandwidth = 38.4f;
+
+const float kFp32Weight = 0.4f;
+const float kTexelWeight = 0.2f;
+const float kPixelWeight = 0.2f;
+const float kBandwidthWeight = 0.2f;
+
+}
+
+int GetThroughputScore( const GPUData* const gpuData, ThroughputScore* const score )
+{
+	if( gpuData == nullptr || score == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*score = {};
+
+	INTEL_GPU_ARCHITECTURE architecture = gpuData->architecture;
+	if( architecture == IGFX_UNKNOWN && gpuData->vendorID == INTEL_VENDOR_ID )
+	{
+		architecture = GetIntelGPUArchitecture( gpuData->deviceID );
+	}
+	const ArchitectureDefaults* defaults = FindArchitectureDefaults( architecture );
+
+	unsigned int euCount = gpuData->advancedCounterDataAvailability ? gpuData->euCount : 0;
+	unsigned int maxFillRate = gpuData->advancedCounterDataAvailability ? gpuData->maxFillRate : 0;
+	unsigned int maxFrequency = gpuData->counterAvailability ? gpuData->maxFrequency : 0;
+
+	if( euCount == 0 || maxFillRate == 0 || maxFrequency == 0 )
+	{
+		if( defaults == nullptr )
+		{
+			return GPUDETECT_ERROR_NOT_SUPPORTED;
+		}
+
+		score->estimated = true;
+		euCount = euCount != 0 ? euCount : defaults->euCount;
+		maxFillRate = maxFillRate != 0 ? maxFillRate : defaults->maxFillRate;
+		maxFrequency = maxFrequency != 0 ? maxFrequency : defaults->maxFrequency;
+	}
+
+	const IntelGraphicsGeneration generation = GetIntelGraphicsGeneration( architecture );
+	const float clockGHz = maxFrequency / 1000.0f;
+
+	score->fp32Gflops = euCount * GetFp32FlopsPerClockPerEU( generation ) * clockGHz;
+	score->texelRateGtexels = euCount * GetTexelsPerClockPerEU( generation ) * clockGHz;
+	score->pixelRateGpixels = maxFillRate * clockGHz;
+	score->bandwidthGBs = gpuData->isUMAArchitecture
+		? GetSharedBandwidthGBs( generation )
+		: GetDedicatedBandwidthGBs( architecture, euCount );
+	score->bandwidthClass = GetBandwidthClass( score->bandwidthGBs );
+
+	score->score = std::exp(
+		kFp32Weight * std::log( score->fp32Gflops / kReferenceFp32Gflops ) +
+		kTexelWeight * std::log( score->texelRateGtexels / kReferenceTexelRate ) +
+		kPixelWeight * std::log( score->pixelRateGpixels / kReferencePixelRate ) +
+		kBandwidthWeight * std::log( score->bandwidthGBs / kReferenceBandwidth ) );
+
+	return EXIT_SUCCESS;
+}
+
+}
@@ -0,0 +1,506 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+
+#include "GPUDetectBackend.h"
+#include "GPUDetectSysfs.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+const int kMaxCards = 64;
+
+// Returns N for entries named "cardN", or -1 for anything else (connectors
+// such as "card0-DP-1", render nodes, "version", ...).
+int ParseCardNumber( const char* name )
+{
+	if( strncmp( name, "card", 4 ) != 0 || name[ 4 ] == '\0' )
+	{
+		return -1;
+	}
+
+	int number = 0;
+	for( const char* c = name + 4; *c != '\0'; ++c )
+	{
+		if( *c < '0' || *c > '9' )
+		{
+			return -1;
+		}
+		number = number * 10 + ( *c - '0' );
+	}
+	return number;
+}
+
+// Display-only drivers (simpledrm, BMC VGA, ...) create a card but no render
+// node, so they are not reported as adapters.
+bool HasRenderNode( const char* sysfsRoot, int cardNumber )
+{
+	char path[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/device/drm", sysfsRoot, cardNumber ) )
+	{
+		return false;
+	}
+
+	DIR* dir = ::opendir( path );
+	if( dir == nullptr )
+	{
+		return false;
+	}
+
+	bool found = false;
+	while( const dirent* entry = ::readdir( dir ) )
+	{
+		if( strncmp( entry->d_name, "renderD", 7 ) == 0 )
+		{
+			found = true;
+			break;
+		}
+	}
+
+	::closedir( dir );
+	return found;
+}
+
+// Copies the value of "KEY=value" from a uevent file into outValue.
+bool GetUeventValue( const char* uevent, const char* key, char* outValue, size_t outValueSize )
+{
+	const size_t keyLength = strlen( key );
+	for( const char* line = uevent; *line != '\0'; )
+	{
+		const char* lineEnd = strchr( line, '\n' );
+		if( lineEnd == nullptr )
+		{
+			lineEnd = line + strlen( line );
+		}
+
+		if( strncmp( line, key, keyLength ) == 0 && line[ keyLength ] == '=' )
+		{
+			const char* value = line + keyLength + 1;
+			const size_t valueLength = std::min( (size_t) ( lineEnd - value ), outValueSize - 1 );
+			memcpy( outValue, value, valueLength );
+			outValue[ valueLength ] = '\0';
+			return true;
+		}
+
+		line = *lineEnd == '\0' ? lineEnd : lineEnd + 1;
+	}
+	return false;
+}
+
+// Returns the size of the largest memory BAR. On discrete GPUs this is the
+// local memory aperture, which covers all of local memory when resizable BAR
+// is enabled.
+uint64_t GetLargestMemoryBarSize( const char* devicePath )
+{
+	char path[ kMaxSysfsPath ];
+	char buffer[ 4096 ];
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/resource", devicePath ) ||
+		ReadSysfsFile( path, buffer, sizeof( buffer ) ) <= 0 )
+	{
+		return 0;
+	}
+
+	const unsigned long long IORESOURCE_MEM = 0x200;
+
+	uint64_t largest = 0;
+	for( const char* line = buffer; *line != '\0'; )
+	{
+		unsigned long long start = 0;
+		unsigned long long end = 0;
+		unsigned long long flags = 0;
+		if( sscanf( line, "%llx %llx %llx", &start, &end, &flags ) == 3 &&
+			( flags & IORESOURCE_MEM ) != 0 && end > start )
+		{
+			largest = std::max( largest, (uint64_t) ( end - start + 1 ) );
+		}
+
+		const char* lineEnd = strchr( line, '\n' );
+		if( lineEnd == nullptr )
+		{
+			break;
+		}
+		line = lineEnd + 1;
+	}
+	return largest;
+}
+
+// Returns the size of local memory as the driver reports it: i915 as one
+// region, xe per tile. 0 if the driver reports neither.
+uint64_t GetLocalMemorySize( const char* sysfsRoot, int cardNumber )
+{
+	char path[ kMaxSysfsPath ];
+	uint64_t totalBytes = 0;
+	if( FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/lmem_total_bytes", sysfsRoot, cardNumber ) &&
+		ReadSysfsValue( path, 10, &totalBytes ) )
+	{
+		return totalBytes;
+	}
+
+	for( unsigned int tile = 0; ; ++tile )
+	{
+		uint64_t tileBytes = 0;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm/card%d/device/tile%u/physical_vram_size_bytes", sysfsRoot, cardNumber, tile ) ||
+			!ReadSysfsValue( path, 0, &tileBytes ) )
+		{
+			break;
+		}
+		totalBytes += tileBytes;
+	}
+	return totalBytes;
+}
+
+// Sysfs reads are independent per card, so InitAll is safe to call from
+// several threads at once
+class SysfsAdapterDetector : public IAdapterDetector
+{
+public:
+	int GetAdapterCount( int* count ) override
+	{
+		std::vector< GPUData > adapters;
+		const int returnCode = EnumerateAdapters( &adapters );
+		*count = (int) adapters.size();
+		return returnCode;
+	}
+
+	int InitAll( GPUData* const gpuData, int adapterIndex ) override
+	{
+		return GPUDetect::InitAll( gpuData, adapterIndex );
+	}
+};
+
+}
+
+bool FormatSysfsPath( char* path, size_t pathSize, const char* format, ... )
+{
+	va_list args;
+	va_start( args, format );
+	const int length = vsnprintf( path, pathSize, format, args );
+	va_end( args );
+	return length >= 0 && (size_t) length < pathSize;
+}
+
+int ReadSysfsFile( const char* path, char* buffer, size_t bufferSize )
+{
+	const int fd = ::open( path, O_RDONLY | O_CLOEXEC );
+	if( fd < 0 )
+	{
+		return -1;
+	}
+
+	const ssize_t bytesRead = ::read( fd, buffer, bufferSize - 1 );
+	::close( fd );
+	if( bytesRead < 0 )
+	{
+		return -1;
+	}
+
+	buffer[ bytesRead ] = '\0';
+	return (int) bytesRead;
+}
+
+bool ReadSysfsValue( const char* path, int base, uint64_t* value )
+{
+	char buffer[ 32 ];
+	if( ReadSysfsFile( path, buffer, sizeof( buffer ) ) <= 0 )
+	{
+		return false;
+	}
+
+	char* end = nullptr;
+	*value = strtoull( buffer, &end, base );
+	return end != buffer;
+}
+
+bool RereadSysfsValue( int fd, uint64_t* value )
+{
+	char buffer[ 24 ];
+	const ssize_t bytesRead = ::pread( fd, buffer, sizeof( buffer ), 0 );
+	if( bytesRead <= 0 )
+	{
+		return false;
+	}
+
+	// Parsed by hand, as this runs on every sample
+	uint64_t result = 0;
+	ssize_t i = 0;
+	for( ; i < bytesRead && buffer[ i ] >= '0' && buffer[ i ] <= '9'; ++i )
+	{
+		result = result * 10 + ( buffer[ i ] - '0' );
+	}
+	if( i == 0 )
+	{
+		return false;
+	}
+
+	*value = result;
+	return true;
+}
+
+int ListSysfsCards( const char* sysfsRoot, std::vector< int >* cardNumbers )
+{
+	char path[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/class/drm", sysfsRoot ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	DIR* dir = ::opendir( path );
+	if( dir == nullptr )
+	{
+		return GPUDETECT_ERROR_SYSFS_NO_DRM;
+	}
+
+	int cards[ kMaxCards ];
+	int numCards = 0;
+	while( const dirent* entry = ::readdir( dir ) )
+	{
+		const int number = ParseCardNumber( entry->d_name );
+		if( number >= 0 && numCards < kMaxCards )
+		{
+			cards[ numCards++ ] = number;
+		}
+	}
+	::closedir( dir );
+
+	// readdir order is arbitrary; adapters are reported in card order
+	std::sort( cards, cards + numCards );
+
+	cardNumbers->clear();
+	for( int i = 0; i < numCards; ++i )
+	{
+		if( HasRenderNode( sysfsRoot, cards[ i ] ) )
+		{
+			cardNumbers->push_back( cards[ i ] );
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+int FindSysfsCard( const char* sysfsRoot, int adapterIndex, int* cardNumber )
+{
+	std::vector< int > cardNumbers;
+	const int returnCode = ListSysfsCards( sysfsRoot, &cardNumbers );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	if( adapterIndex < 0 || adapterIndex >= (int) cardNumbers.size() )
+	{
+		return GPUDETECT_ERROR_SYSFS_NO_ADAPTER;
+	}
+
+	*cardNumber = cardNumbers[ adapterIndex ];
+	return EXIT_SUCCESS;
+}
+
+int InitSysfsInfo( GPUData* const gpuData, int adapterIndex, const char* sysfsRoot )
+{
+	if( gpuData == nullptr || adapterIndex < 0 || sysfsRoot == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	StageTimer timer( Timings::STAGE_SYSFS_READ );
+
+	int cardNumber = 0;
+	const int returnCode = FindSysfsCard( sysfsRoot, adapterIndex, &cardNumber );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	return InitSysfsCardInfo( gpuData, sysfsRoot, cardNumber );
+}
+
+int InitSysfsCardInfo( GPUData* const gpuData, const char* sysfsRoot, int cardNumber )
+{
+	char devicePath[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( devicePath, sizeof( devicePath ), "%s/class/drm/card%d/device", sysfsRoot, cardNumber ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	char path[ kMaxSysfsPath ];
+	uint64_t vendorID = 0;
+	uint64_t deviceID = 0;
+
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/vendor", devicePath ) ||
+		!ReadSysfsValue( path, 16, &vendorID ) ||
+		!FormatSysfsPath( path, sizeof( path ), "%s/device", devicePath ) ||
+		!ReadSysfsValue( path, 16, &deviceID ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+
+	gpuData->dxAdapterAvailability = true;
+
+	gpuData->vendorID = (unsigned int) vendorID;
+	gpuData->deviceID = (unsigned int) deviceID;
+
+	char uevent[ 512 ] = {};
+	if( !FormatSysfsPath( path, sizeof( path ), "%s/uevent", devicePath ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	ReadSysfsFile( path, uevent, sizeof( uevent ) );
+
+	char driver[ 32 ] = "unknown";
+	char slot[ 32 ] = "";
+	GetUeventValue( uevent, "DRIVER", driver, sizeof( driver ) );
+
+	unsigned int domain = 0, bus = 0, dev = 0, function = 0;
+	if( GetUeventValue( uevent, "PCI_SLOT_NAME", slot, sizeof( slot ) ) )
+	{
+		sscanf( slot, "%x:%x:%x.%x", &domain, &bus, &dev, &function );
+	}
+
+	gpuData->adapterLUID.HighPart = (int32_t) domain;
+	gpuData->adapterLUID.LowPart = ( bus << 8 ) | ( dev << 3 ) | function;
+
+	// There is no driver-provided marketing name in sysfs
+	swprintf( gpuData->description, sizeof( GPUData::description ) / sizeof( WCHAR ), L"%s (%s)", driver, slot );
+
+	// Intel integrated GPUs always sit on the root bus
+	gpuData->isUMAArchitecture = gpuData->vendorID == INTEL_VENDOR_ID && bus == 0;
+
+	if( gpuData->isUMAArchitecture )
+	{
+		// Matches what DXGI reports as SharedSystemMemory
+		gpuData->videoMemory = (uint64_t) sysconf( _SC_PHYS_PAGES ) * (uint64_t) sysconf( _SC_PAGESIZE ) / 2;
+	}
+	else
+	{
+		// amdgpu, then i915 and xe. The BAR is only a last resort, as without
+		// resizable BAR it is a 256 MB window into local memory.
+		uint64_t vramTotal = 0;
+		if( !FormatSysfsPath( path, sizeof( path ), "%s/mem_info_vram_total", devicePath ) ||
+			!ReadSysfsValue( path, 10, &vramTotal ) )
+		{
+			vramTotal = GetLocalMemorySize( sysfsRoot, cardNumber );
+		}
+		gpuData->videoMemory = vramTotal != 0 ? vramTotal : GetLargestMemoryBarSize( devicePath );
+	}
+
+	if( gpuData->vendorID == INTEL_VENDOR_ID )
+	{
+		gpuData->architecture = GetIntelGPUArchitecture( gpuData->deviceID );
+	}
+
+	return EXIT_SUCCESS;
+}
+
+int GetCpuVisibleLocalMemory( int adapterIndex, const char* sysfsRoot, uint64_t* bytes )
+{
+	if( adapterIndex < 0 || sysfsRoot == nullptr || bytes == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	int cardNumber = 0;
+	const int returnCode = FindSysfsCard( sysfsRoot, adapterIndex, &cardNumber );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	char devicePath[ kMaxSysfsPath ];
+	if( !FormatSysfsPath( devicePath, sizeof( devicePath ), "%s/class/drm/card%d/device", sysfsRoot, cardNumber ) )
+	{
+		return GPUDETECT_ERROR_SYSFS_READ;
+	}
+	*bytes = GetLargestMemoryBarSize( devicePath );
+	return EXIT_SUCCESS;
+}
+
+int InitAdapterInfo( GPUData* const gpuData, int adapterIndex )
+{
+	return InitSysfsInfo( gpuData, adapterIndex, "/sys" );
+}
+
+int InitExtensionInfo( GPUData* const gpuData, int adapterIndex )
+{
+	return InitSysfsInfo( gpuData, adapterIndex, "/sys" );
+}
+
+int InitAll( GPUData* const gpuData, int adapterIndex )
+{
+	// Counter and registry data have no sysfs equivalent
+	return InitExtensionInfo( gpuData, adapterIndex );
+}
+
+int EnumerateSysfsAdapters( const char* sysfsRoot, std::vector< GPUData >* gpuData )
+{
+	if( sysfsRoot == nullptr || gpuData == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	gpuData->clear();
+
+	// One scan of class/drm for all adapters, rather than one per index
+	std::vector< int > cardNumbers;
+	int returnCode = ListSysfsCards( sysfsRoot, &cardNumbers );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		return returnCode;
+	}
+
+	gpuData->resize( cardNumbers.size() );
+	for( size_t i = 0; i < cardNumbers.size(); ++i )
+	{
+		StageTimer timer( Timings::STAGE_SYSFS_READ );
+
+		returnCode = InitSysfsCardInfo( &( *gpuData )[ i ], sysfsRoot, cardNumbers[ i ] );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			gpuData->resize( i );
+			return returnCode;
+		}
+	}
+	return EXIT_SUCCESS;
+}
+
+int EnumerateAdapters( std::vector< GPUData >* gpuData )
+{
+	return EnumerateSysfsAdapters( "/sys", gpuData );
+}
+
+int InitAllAdapters( std::vector< GPUData >* gpuData, std::vector< int >* returnCodes, unsigned int maxThreads )
+{
+	SysfsAdapterDetector detector;
+	return InitAllAdapters( &detector, gpuData, returnCodes, maxThreads );
+}
+
+}
+
+#endif // __linux__
@@ -0,0 +1,112 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+
+#pragma once
+
+#ifdef __linux__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+
+//
+// Helpers shared by the Linux sysfs readers. Not part of the GPUDetect API.
+//
+namespace GPUDetect
+{
+	struct GPUData;
+
+	const size_t kMaxSysfsPath = 512;
+
+	/*******************************************************************************
+	 * FormatSysfsPath
+	 *
+	 *     snprintf for paths. Returns false if the path did not fit in path,
+	 *     as reading a truncated path would silently read the wrong file.
+	 *
+	 ******************************************************************************/
+	bool FormatSysfsPath( char* path, size_t pathSize, const char* format, ... );
+
+	/*******************************************************************************
+	 * ReadSysfsFile
+	 *
+	 *     Reads a small sysfs attribute into buffer and null-terminates it.
+	 *     Returns the number of bytes read, or -1 if the file could not be read.
+	 *
+	 ******************************************************************************/
+	int ReadSysfsFile( const char* path, char* buffer, size_t bufferSize );
+
+	/*******************************************************************************
+	 * ReadSysfsValue
+	 *
+	 *     Reads an attribute holding one integer in the given base. Returns
+	 *     false if it could not be read or parsed.
+	 *
+	 ******************************************************************************/
+	bool ReadSysfsValue( const char* path, int base, uint64_t* value );
+
+	/*******************************************************************************
+	 * RereadSysfsValue
+	 *
+	 *     Reads a decimal attribute from an already open file, from its start.
+	 *     sysfs regenerates the contents on every read at offset 0, so a file
+	 *     that is sampled repeatedly need not be reopened. Returns false if it
+	 *     could not be read or parsed.
+	 *
+	 ******************************************************************************/
+	bool RereadSysfsValue( int fd, uint64_t* value );
+
+	/*******************************************************************************
+	 * FindSysfsCard
+	 *
+	 *     Stores the N of the class/drm/cardN entry of the adapter at
+	 *     adapterIndex, counting as InitSysfsInfo does, in cardNumber. Returns
+	 *     EXIT_SUCCESS if found, otherwise returns an error code.
+	 *
+	 ******************************************************************************/
+	int FindSysfsCard( const char* sysfsRoot, int adapterIndex, int* cardNumber );
+
+	/*******************************************************************************
+	 * ListSysfsCards
+	 *
+	 *     Stores the N of every class/drm/cardN entry that is an adapter, in
+	 *     adapter index order, in cardNumbers. Returns EXIT_SUCCESS if no
+	 *     error was encountered, otherwise returns an error code.
+	 *
+	 ******************************************************************************/
+	int ListSysfsCards( const char* sysfsRoot, std::vector< int >* cardNumbers );
+
+	/*******************************************************************************
+	 * InitSysfsCardInfo
+	 *
+	 *     As InitSysfsInfo, for the adapter of class/drm/cardN.
+	 *
+	 ******************************************************************************/
+	int InitSysfsCardInfo( GPUData* const gpuData, const char* sysfsRoot, int cardNumber );
+
+	/*******************************************************************************
+	 * EnumerateSysfsAdapters
+	 *
+	 *     As EnumerateAdapters, under sysfsRoot, listing class/drm once.
+	 *
+	 ******************************************************************************/
+	int EnumerateSysfsAdapters( const char* sysfsRoot, std::vector< GPUData >* gpuData );
+}
+
+#endif // __linux__
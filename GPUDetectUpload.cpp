@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017-2020 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+
+#ifndef STRICT
+#define STRICT
+#endif
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+
+#ifndef VC_EXTRALEAN
+#define VC_EXTRALEAN
+#endif
+
+#include <windows.h>
+#include <dxgi.h>
+#include <d3d12.h>
+
+#endif // _WIN32
+
+#include <cstdlib>
+
+#include "GPUDetect.h"
+
+
+namespace GPUDetect
+{
+
+namespace
+{
+
+// Constant buffer offsets are in units of 16 constants
+const unsigned int kConstantBufferAlignment = 256;
+
+// Whole cache lines, so that the CPU never reads a line back to merge a write
+const unsigned int kCacheLineAlignment = 64;
+
+// Copy engine transfers out of a staging buffer
+const unsigned int kBufferCopyAlignment = 256;
+
+// Copies into a texture need their source rows at this placement
+const unsigned int kTexturePlacementAlignment = 512;
+
+// Directly accessed textures are mapped by whole pages
+const unsigned int kPageAlignment = 4096;
+
+}
+
+int GetUploadAdvice( const GPUData* const gpuData, uint64_t cpuVisibleLocalMemory, UploadResourceClass resourceClass, UploadAdvice* const advice )
+{
+	if( gpuData == nullptr || advice == nullptr || resourceClass < 0 || resourceClass >= UPLOAD_CLASS_COUNT )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	if( gpuData->isUMAArchitecture )
+	{
+		// The GPU reads system memory directly, so a staging copy only adds a
+		// second write of the same data
+		switch( resourceClass )
+		{
+			case UPLOAD_CLASS_CONSTANT_BUFFER: *advice = { UPLOAD_DIRECT_WRITE, kConstantBufferAlignment }; break;
+			case UPLOAD_CLASS_DYNAMIC_BUFFER:  *advice = { UPLOAD_DIRECT_WRITE, kCacheLineAlignment };      break;
+			case UPLOAD_CLASS_STATIC_BUFFER:   *advice = { UPLOAD_DIRECT_WRITE, kCacheLineAlignment };      break;
+			case UPLOAD_CLASS_TEXTURE:
+				// Textures are tiled, so without the extension they have to go
+				// through a copy that swizzles them
+				*advice = gpuData->intelExtensionAvailability
+					? UploadAdvice{ UPLOAD_DIRECT_ACCESS, kPageAlignment }
+					: UploadAdvice{ UPLOAD_STAGING_COPY, kTexturePlacementAlignment };
+				break;
+			default: break;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// With resizable BAR all of local memory is CPU-visible, and writing
+	// static data straight into it saves the copy. Otherwise the BAR is
+	// typically 256 MB, which is only enough for per-frame data.
+	const bool largeBar = gpuData->videoMemory != 0 && cpuVisibleLocalMemory >= gpuData->videoMemory;
+
+	switch( resourceClass )
+	{
+		case UPLOAD_CLASS_CONSTANT_BUFFER: *advice = { UPLOAD_BAR_WRITE, kConstantBufferAlignment }; break;
+		case UPLOAD_CLASS_DYNAMIC_BUFFER:  *advice = { UPLOAD_BAR_WRITE, kCacheLineAlignment };      break;
+		case UPLOAD_CLASS_STATIC_BUFFER:
+			*advice = largeBar
+				? UploadAdvice{ UPLOAD_BAR_WRITE, kCacheLineAlignment }
+				: UploadAdvice{ UPLOAD_STAGING_COPY, kBufferCopyAlignment };
+			break;
+		case UPLOAD_CLASS_TEXTURE:         *advice = { UPLOAD_STAGING_COPY, kTexturePlacementAlignment }; break;
+		default: break;
+	}
+	return EXIT_SUCCESS;
+}
+
+#ifdef _WIN32
+int GetCpuVisibleLocalMemory( IDXGIAdapter* adapter, uint64_t* bytes )
+{
+	if( adapter == nullptr || bytes == nullptr )
+	{
+		return GPUDETECT_ERROR_BAD_DATA;
+	}
+
+	*bytes = 0;
+
+	// Loaded on demand, as the rest of GPUDetect needs only D3D11
+	HMODULE d3d12Module = ::LoadLibraryA( "d3d12.dll" );
+	if( d3d12Module == nullptr )
+	{
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	const PFN_D3D12_CREATE_DEVICE createDevice = (PFN_D3D12_CREATE_DEVICE) ::GetProcAddress( d3d12Module, "D3D12CreateDevice" );
+	ID3D12Device* device = nullptr;
+	if( createDevice == nullptr || FAILED( createDevice( adapter, D3D_FEATURE_LEVEL_11_0, __uuidof( ID3D12Device ), (void**) &device ) ) )
+	{
+		::FreeLibrary( d3d12Module );
+		return GPUDETECT_ERROR_NOT_SUPPORTED;
+	}
+
+	// The OS only enables GPU upload heaps when all of local memory is
+	// CPU-visible, that is with resizable BAR
+	D3D12_FEATURE_DATA_D3D12_OPTIONS16 options16 = {};
+	const bool uploadHeaps = SUCCEEDED( device->CheckFeatureSupport( D3D12_FEATURE_D3D12_OPTIONS16, &options16, sizeof( options16 ) ) ) &&
+		options16.GPUUploadHeapSupported;
+
+	device->Release();
+	::FreeLibrary( d3d12Module );
+
+	DXGI_ADAPTER_DESC desc = {};
+	if( uploadHeaps && SUCCEEDED( adapter->GetDesc( &desc ) ) )
+	{
+		*bytes = desc.DedicatedVideoMemory;
+	}
+	return EXIT_SUCCESS;
+}
+#endif
+
+const char* GetUploadPathName( UploadPath path )
+{
+	switch( path )
+	{
+		case UPLOAD_DIRECT_WRITE:  return "DirectWrite";
+		case UPLOAD_DIRECT_ACCESS: return "DirectAccess";
+		case UPLOAD_BAR_WRITE:     return "BarWrite";
+		case UPLOAD_STAGING_COPY:  return "StagingCopy";
+	}
+	return "Unknown";
+}
+
+}
@@ -0,0 +1,271 @@
+################################################################################
+# Copyright 2017-2020 Intel Corporation
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+
+"""
+Compiles one or more preset .cfg files into a C++ header holding a perfect
+hash table of (vendorID, deviceID) -> PresetLevel, and the table of preset
+rules for devices the cfg does not list, so that GetDefaultFidelityPreset
+needs no file I/O or parsing at runtime.
+
+Usage: GeneratePresetTable.py output.h input.cfg [input.cfg ...]
+
+The table uses hash-and-displace: a key is first hashed into a bucket, and
+each bucket stores the displacement that sends all of its keys to free slots.
+The lookup in FidelityPreset.cpp must use the same Mix() function.
+
+Rules are written highest priority first, so the first rule that matches is
+the one that applies. Two rules may not share a priority.
+"""
+
+import os
+import sys
+
+PRESET_NAMES = {
+    "low": "Low",
+    "medium": "Medium",
+    "medium+": "MediumPlus",
+    "high": "High",
+}
+
+MASK32 = 0xFFFFFFFF
+
+# Condition name in the cfg -> (RULE_* flag, field of PresetRule, parser)
+RULE_CONDITIONS = {
+    "vendor": ("RULE_VENDOR", "vendorID", "hex"),
+    "arch": ("RULE_ARCHITECTURE", "architecture", "enum"),
+    "gen": ("RULE_GENERATION", "generation", "enum"),
+    "eucount": ("RULE_EU_COUNT", "euCount", "range"),
+    "maxfrequency": ("RULE_MAX_FREQUENCY", "maxFrequency", "range"),
+    "videomemory": ("RULE_VIDEO_MEMORY", "videoMemoryMB", "range"),
+    "driver": ("RULE_DRIVER_VERSION", "driverVersion", "driver"),
+}
+
+RULE_FIELD_DEFAULTS = [
+    ("vendorID", "0x0000"),
+    ("architecture", "IGFX_UNKNOWN"),
+    ("generation", "INTEL_GFX_GEN_UNKNOWN"),
+    ("euCount", "{ 0, 0 }"),
+    ("maxFrequency", "{ 0, 0 }"),
+    ("videoMemoryMB", "{ 0, 0 }"),
+    ("driverVersion", "{ 0, 0 }"),
+]
+
+
+def mix(x):
+    x &= MASK32
+    x ^= x >> 16
+    x = (x * 0x7FEB352D) & MASK32
+    x ^= x >> 15
+    x = (x * 0x846CA68B) & MASK32
+    x ^= x >> 16
+    return x
+
+
+def parse_driver_version(text):
+    # Revision.Build, the last two parts of the driver version
+    revision, build = text.split(".")
+    if int(build) > 0xFFFF:
+        raise ValueError(text)
+    return (int(revision) << 16) | int(build)
+
+
+def parse_range(text, parse_value):
+    low, high = text.split("-")
+    low = parse_value(low) if low else 0
+    high = parse_value(high) if high else MASK32
+    if low > high:
+        raise ValueError(text)
+    return "{ %d, %s }" % (low, "0xFFFFFFFF" if high == MASK32 else str(high))
+
+
+def parse_rule(path, line_number, fields, rules):
+    # Rule, Priority, Preset, Condition [Condition ...]
+    where = "%s(%d)" % (path, line_number)
+    if len(fields) != 4:
+        sys.exit("%s: a rule needs a priority, a preset and conditions" % where)
+
+    try:
+        priority = int(fields[1])
+    except ValueError:
+        sys.exit("%s: bad rule priority" % where)
+
+    preset = PRESET_NAMES.get(fields[2].lower())
+    if preset is None:
+        sys.exit("%s: unknown preset %s" % (where, fields[2]))
+
+    flags = []
+    values = {}
+    for condition in fields[3].split():
+        name, _, value = condition.partition("=")
+        if name.lower() not in RULE_CONDITIONS or not value:
+            sys.exit("%s: unknown condition %s" % (where, condition))
+
+        flag, field, kind = RULE_CONDITIONS[name.lower()]
+        try:
+            if kind == "hex":
+                values[field] = "0x%04X" % int(value, 16)
+            elif kind == "enum":
+                # The compiler checks the name against the enum
+                if not value.replace("_", "").isalnum():
+                    raise ValueError(value)
+                values[field] = value
+            elif kind == "range":
+                values[field] = parse_range(value, int)
+            else:
+                values[field] = parse_range(value, parse_driver_version)
+        except ValueError:
+            sys.exit("%s: bad value in %s" % (where, condition))
+        flags.append(flag)
+
+    if priority in rules:
+        sys.exit("%s: priority %d is already used at %s" % (where, priority, rules[priority][0]))
+    rules[priority] = (where, flags, values, preset)
+
+
+def parse_cfg(path, entries, rules):
+    with open(path, "r") as cfg:
+        for line_number, line in enumerate(cfg, 1):
+            fields = [f.strip() for f in line.split(";", 1)[0].split(",")]
+            if fields[0].lower() == "rule":
+                parse_rule(os.path.basename(path), line_number, fields, rules)
+                continue
+
+            if len(fields) < 3 or not all(fields[:3]):
+                continue  # blank or comment-only line
+
+            try:
+                vendor_id = int(fields[0], 16)
+                device_id = int(fields[1], 16)
+            except ValueError:
+                sys.exit("%s(%d): bad vendor or device id" % (path, line_number))
+
+            key = (vendor_id << 16) | device_id
+            preset = PRESET_NAMES.get(fields[2].split()[0].lower(), "NotCompatible")
+
+            # The runtime parser stops at the first match, so keep the first
+            entries.setdefault(key, preset)
+
+
+def next_pow2(n):
+    size = 1
+    while size < n:
+        size *= 2
+    return size
+
+
+def build_table(keys):
+    table_size = next_pow2(max(len(keys) * 5 // 4, 1))
+    bucket_count = next_pow2(max(len(keys) // 4, 1))
+
+    buckets = [[] for _ in range(bucket_count)]
+    for key in keys:
+        buckets[mix(key) & (bucket_count - 1)].append(key)
+
+    slots = [None] * table_size
+    displacements = [0] * bucket_count
+
+    # Place the largest buckets first while the table is still empty
+    for bucket in sorted(range(bucket_count), key=lambda b: -len(buckets[b])):
+        bucket_keys = buckets[bucket]
+        if not bucket_keys:
+            continue
+
+        displacement = 0
+        while True:
+            displacement += 1
+            targets = [mix(key ^ displacement) & (table_size - 1) for key in bucket_keys]
+            if len(set(targets)) == len(targets) and all(slots[t] is None for t in targets):
+                break
+
+        displacements[bucket] = displacement
+        for key, target in zip(bucket_keys, targets):
+            slots[target] = key
+
+    return slots, displacements
+
+
+def write_header(path, sources, entries, slots, displacements, rules):
+    lines = [
+        "// Generated by GeneratePresetTable.py from %s. Do not edit." % ", ".join(sources),
+        "",
+        "#pragma once",
+        "",
+        "",
+        "namespace GPUDetect",
+        "{",
+        "\tconst unsigned int kPresetTableSize = %d;" % len(slots),
+        "\tconst unsigned int kPresetBucketCount = %d;" % len(displacements),
+        "",
+        "\tconst uint32_t kPresetDisplacements[ kPresetBucketCount ] =",
+        "\t{",
+    ]
+    for i in range(0, len(displacements), 8):
+        lines.append("\t\t" + " ".join("%d," % d for d in displacements[i:i + 8]))
+    lines += [
+        "\t};",
+        "",
+        "\tconst PresetTableEntry kPresetTable[ kPresetTableSize ] =",
+        "\t{",
+    ]
+    for key in slots:
+        if key is None:
+            lines.append("\t\t{ 0x00000000, Undefined },")
+        else:
+            lines.append("\t\t{ 0x%08X, %s }," % (key, entries[key]))
+    lines += [
+        "\t};",
+        "",
+        "\tconst unsigned int kPresetRuleCount = %d;" % len(rules),
+        "",
+        "\t// Highest priority first",
+        "\tconst PresetRule kPresetRules[ %d ] =" % max(len(rules), 1),
+        "\t{",
+    ]
+    for priority in sorted(rules, reverse=True):
+        where, flags, values, preset = rules[priority]
+        fields = [" | ".join(flags) or "0"] + [values.get(field, default) for field, default in RULE_FIELD_DEFAULTS] + [preset]
+        lines.append("\t\t// Priority %d, %s" % (priority, where))
+        lines.append("\t\t{ %s }," % ", ".join(fields))
+    if not rules:
+        lines.append("\t\t{ 0, %s, Undefined }," % ", ".join(default for _, default in RULE_FIELD_DEFAULTS))
+    lines += [
+        "\t};",
+        "}",
+        "",
+    ]
+
+    with open(path, "w", newline="\n") as header:
+        header.write("\n".join(lines))
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit(__doc__)
+
+    output = sys.argv[1]
+    inputs = sys.argv[2:]
+
+    entries = {}
+    rules = {}
+    for cfg in inputs:
+        parse_cfg(cfg, entries, rules)
+
+    slots, displacements = build_table(sorted(entries))
+    write_header(output, [os.path.basename(cfg) for cfg in inputs], entries, slots, displacements, rules)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,565 @@
+// Generated by GeneratePresetTable.py from IntelGfx.cfg. Do not edit.
+
+#pragma once
+
+
+namespace GPUDetect
+{
+	const unsigned int kPresetTableSize = 512;
+	const unsigned int kPresetBucketCount = 128;
+
+	const uint32_t kPresetDisplacements[ kPresetBucketCount ] =
+	{
+		7, 2, 12, 2, 1, 0, 1, 5,
+		7, 4, 1, 1, 1, 4, 0, 1,
+		1, 0, 1, 1, 1, 1, 2, 12,
+		2, 2, 1, 1, 1, 0, 1, 1,
+		0, 1, 5, 2, 5, 2, 1, 1,
+		2, 3, 14, 7, 1, 10, 1, 1,
+		1, 1, 3, 2, 5, 3, 1, 1,
+		1, 3, 6, 1, 1, 4, 1, 2,
+		1, 1, 7, 1, 1, 7, 0, 1,
+		4, 3, 9, 2, 4, 1, 8, 1,
+		2, 0, 2, 3, 1, 5, 3, 6,
+		8, 6, 5, 1, 1, 11, 2, 11,
+		5, 1, 7, 2, 5, 6, 27, 3,
+		12, 3, 14, 14, 2, 4, 1, 2,
+		3, 18, 0, 30, 2, 0, 1, 1,
+		22, 1, 9, 14, 7, 1, 0, 6,
+	};
+
+	const PresetTableEntry kPresetTable[ kPresetTableSize ] =
+	{
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80862A03, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860412, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80861636, Low },
+		{ 0x80868A52, Medium },
+		{ 0x80860416, Low },
+		{ 0x80860A0B, Low },
+		{ 0x80863EA7, High },
+		{ 0x80860BD1, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860A12, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80869BA4, Low },
+		{ 0x80860D22, Low },
+		{ 0x80869BC5, Medium },
+		{ 0x80860D2A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086015A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80862E42, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869BCB, Medium },
+		{ 0x80860C06, Low },
+		{ 0x80868A56, Medium },
+		{ 0x80862A13, Low },
+		{ 0x80862E23, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860D0E, Low },
+		{ 0x80861927, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086040B, Low },
+		{ 0x8086A788, High },
+		{ 0x8086593D, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80868A71, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80861912, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086191A, Medium },
+		{ 0x80861606, Low },
+		{ 0x80861622, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80865915, Low },
+		{ 0x80865A51, Low },
+		{ 0x80868A5A, Medium },
+		{ 0x8086163D, Low },
+		{ 0x00000000, Undefined },
+		{ 0x808646A3, Medium },
+		{ 0x80869BC8, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80869A59, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086590B, Low },
+		{ 0x80868A5C, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860C22, Low },
+		{ 0x80865912, Medium },
+		{ 0x80862E22, Low },
+		{ 0x8086590A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x808687C0, Low },
+		{ 0x80860D26, Low },
+		{ 0x80865A4A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860903, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80865923, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860A0A, Low },
+		{ 0x80865921, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860D0A, Low },
+		{ 0x80865927, High },
+		{ 0x80865932, Low },
+		{ 0x8086591B, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80861616, Low },
+		{ 0x8086193A, Medium },
+		{ 0x80861902, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80861602, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863EA3, Medium },
+		{ 0x80864C8A, Medium },
+		{ 0x8086162D, Low },
+		{ 0x8086592A, Low },
+		{ 0x80860A1A, Low },
+		{ 0x808622B0, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860D16, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860C16, Low },
+		{ 0x80865A59, Low },
+		{ 0x80861632, Low },
+		{ 0x80869BF6, Low },
+		{ 0x8086041A, Low },
+		{ 0x8086190A, Medium },
+		{ 0x80863EA5, High },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860046, Low },
+		{ 0x80861926, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863E92, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860900, Medium },
+		{ 0x80860BD2, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860C02, Low },
+		{ 0x80869AC0, Medium },
+		{ 0x8086163B, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860A2A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860122, Low },
+		{ 0x8086193B, High },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x808656A5, High },
+		{ 0x80860A26, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860C12, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863E9A, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860C2A, Low },
+		{ 0x80868A57, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80865A40, Low },
+		{ 0x8086040E, Low },
+		{ 0x80860406, Low },
+		{ 0x80865A5C, Low },
+		{ 0x80861923, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086162B, Low },
+		{ 0x80860C0A, Low },
+		{ 0x80860BD3, Low },
+		{ 0x8086A780, High },
+		{ 0x80863EA8, High },
+		{ 0x00000000, Undefined },
+		{ 0x80860901, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80869BC4, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80860902, Medium },
+		{ 0x80869A70, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086163A, Low },
+		{ 0x80862E02, Low },
+		{ 0x80860422, Low },
+		{ 0x80860D2B, Low },
+		{ 0x8086042B, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869BAB, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860A02, Low },
+		{ 0x80860402, Low },
+		{ 0x80864690, High },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80864626, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80869A60, Medium },
+		{ 0x8086016A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860904, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80869A78, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80864688, High },
+		{ 0x80863EA4, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086161E, Low },
+		{ 0x80860D12, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860A1B, Low },
+		{ 0x80860116, Low },
+		{ 0x80869B41, Medium },
+		{ 0x80865A50, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086041B, Low },
+		{ 0x80860A22, Low },
+		{ 0x8086042E, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80865916, Medium },
+		{ 0x80862E12, Low },
+		{ 0x80860D2E, Low },
+		{ 0x80865917, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80869A7F, Medium },
+		{ 0x80860F30, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80862E92, Low },
+		{ 0x8086190B, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80861612, Low },
+		{ 0x80862E43, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80863E94, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869A68, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80860166, Low },
+		{ 0x80865A44, Low },
+		{ 0x80861916, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086161D, Low },
+		{ 0x80861921, Medium },
+		{ 0x80860A2B, Low },
+		{ 0x808622B2, Low },
+		{ 0x80868A58, Medium },
+		{ 0x80865A5A, Low },
+		{ 0x80862A02, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80861913, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80862E03, Low },
+		{ 0x80861906, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860D0B, Low },
+		{ 0x80865A52, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086041E, Low },
+		{ 0x80865926, High },
+		{ 0x80869BA5, Low },
+		{ 0x80865906, Low },
+		{ 0x8086160E, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086593B, Low },
+		{ 0x80860A1E, Low },
+		{ 0x80864692, High },
+		{ 0x80865A42, Low },
+		{ 0x00000000, Undefined },
+		{ 0x808622B1, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860126, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086161B, Low },
+		{ 0x80868A53, Medium },
+		{ 0x80862A12, Low },
+		{ 0x80863E98, Low },
+		{ 0x80865A49, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086191E, Medium },
+		{ 0x8086191B, Medium },
+		{ 0x80860BD4, Low },
+		{ 0x8086010A, Low },
+		{ 0x80862E93, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80869AC9, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80868A51, Medium },
+		{ 0x80869B21, Low },
+		{ 0x8086161A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086591D, Medium },
+		{ 0x80863EA9, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80868A50, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80860D06, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863E9B, Medium },
+		{ 0x80860A0E, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860426, Low },
+		{ 0x80860A2E, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80863E9C, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80864C8B, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80861626, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80862A42, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80864906, Medium },
+		{ 0x80864682, High },
+		{ 0x80865690, High },
+		{ 0x00000000, Undefined },
+		{ 0x8086468A, High },
+		{ 0x80868A5B, Medium },
+		{ 0x80864680, High },
+		{ 0x00000000, Undefined },
+		{ 0x80860A06, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860C26, Low },
+		{ 0x80865908, Low },
+		{ 0x80865A54, Low },
+		{ 0x80860D02, Low },
+		{ 0x8086192A, Medium },
+		{ 0x80869AD9, Medium },
+		{ 0x80868A59, Medium },
+		{ 0x80868A5D, Medium },
+		{ 0x80862E32, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80863E91, Medium },
+		{ 0x8086191D, Medium },
+		{ 0x8086162A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086163E, Low },
+		{ 0x8086591A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869A49, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80865913, Low },
+		{ 0x80863EA2, High },
+		{ 0x80869A40, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x80860A16, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869AF8, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086590E, Low },
+		{ 0x80862E33, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860BD0, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863185, Medium },
+		{ 0x8086042A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860D1E, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80865693, High },
+		{ 0x80869BC6, Low },
+		{ 0x80860D1B, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860D1A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086160B, Low },
+		{ 0x8086190E, Medium },
+		{ 0x808656A0, High },
+		{ 0x00000000, Undefined },
+		{ 0x80868A54, Medium },
+		{ 0x8086192B, Medium },
+		{ 0x8086162E, Low },
+		{ 0x80860102, Low },
+		{ 0x808656A1, High },
+		{ 0x80862982, Low },
+		{ 0x8086592B, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860F31, Low },
+		{ 0x80860C1A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869BE6, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863EA6, High },
+		{ 0x80869BAA, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80860106, Low },
+		{ 0x80869BC2, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80862A43, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80864907, Medium },
+		{ 0x80869BCC, Medium },
+		{ 0x80869BA8, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086160A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80860152, Low },
+		{ 0x80869BC0, Medium },
+		{ 0x8086591C, Low },
+		{ 0x80860162, Low },
+		{ 0x80860042, Low },
+		{ 0x80860156, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869BA2, Low },
+		{ 0x8086193D, High },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x808622B3, Low },
+		{ 0x80869BCA, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x8086160D, Low },
+		{ 0x80865A4C, Low },
+		{ 0x80865902, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863EA0, Medium },
+		{ 0x80864905, Medium },
+		{ 0x80863E93, Low },
+		{ 0x80863184, Medium },
+		{ 0x8086468B, High },
+		{ 0x00000000, Undefined },
+		{ 0x808646A6, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863E99, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x808687CA, Low },
+		{ 0x80864C90, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80863EA1, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80864693, High },
+		{ 0x80862E13, Low },
+		{ 0x80863E90, Low },
+		{ 0x00000000, Undefined },
+		{ 0x8086040A, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80865A41, Low },
+		{ 0x00000000, Undefined },
+		{ 0x80869BA0, Low },
+		{ 0x8086591E, Low },
+		{ 0x8086192D, Medium },
+		{ 0x80860112, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x8086593A, Low },
+		{ 0x80862983, Low },
+		{ 0x80863E96, Medium },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x80869BAC, Low },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+		{ 0x00000000, Undefined },
+	};
+
+	const unsigned int kPresetRuleCount = 6;
+
+	// Highest priority first
+	const PresetRule kPresetRules[ 6 ] =
+	{
+		// Priority 100, IntelGfx.cfg(359)
+		{ RULE_VENDOR | RULE_ARCHITECTURE, 0x8086, DGFX_ACM, INTEL_GFX_GEN_UNKNOWN, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, High },
+		// Priority 90, IntelGfx.cfg(362)
+		{ RULE_VENDOR | RULE_GENERATION | RULE_EU_COUNT, 0x8086, IGFX_UNKNOWN, INTEL_GFX_GEN12, { 96, 0xFFFFFFFF }, { 0, 0 }, { 0, 0 }, { 0, 0 }, High },
+		// Priority 80, IntelGfx.cfg(363)
+		{ RULE_VENDOR | RULE_GENERATION, 0x8086, IGFX_UNKNOWN, INTEL_GFX_GEN12, { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 }, Medium },
+		// Priority 70, IntelGfx.cfg(364)
+		{ RULE_VENDOR | RULE_GENERATION | RULE_EU_COUNT, 0x8086, IGFX_UNKNOWN, INTEL_GFX_GEN11, { 64, 0xFFFFFFFF }, { 0, 0 }, { 0, 0 }, { 0, 0 }, Medium },
+		// Priority 60, IntelGfx.cfg(367)
+		{ RULE_VENDOR | RULE_ARCHITECTURE | RULE_EU_COUNT, 0x8086, IGFX_UNKNOWN, INTEL_GFX_GEN_UNKNOWN, { 96, 0xFFFFFFFF }, { 0, 0 }, { 0, 0 }, { 0, 0 }, High },
+		// Priority 50, IntelGfx.cfg(368)
+		{ RULE_VENDOR | RULE_ARCHITECTURE | RULE_EU_COUNT, 0x8086, IGFX_UNKNOWN, INTEL_GFX_GEN_UNKNOWN, { 48, 0xFFFFFFFF }, { 0, 0 }, { 0, 0 }, { 0, 0 }, Medium },
+	};
+}
@@ -41,9 +41,12 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <vector>
 
 #include "GPUDetect.h"
+#include "GPUDetectBackend.h"
 
 
 // For parsing arguments
@@ -134,12 +137,127 @@ void printError( int errorCode )
 		fprintf( stderr, "Not supported\n" );
 		break;
 
+	case GPUDETECT_ERROR_REPLAY_FILE:
+		fprintf( stderr, "Recording could not be read or written\n" );
+		break;
+
+	case GPUDETECT_ERROR_REPLAY_MISSING_ANSWER:
+		fprintf( stderr, "Recording does not answer a query of the detection\n" );
+		break;
+
+	case GPUDETECT_ERROR_TRACE_WRITE:
+		fprintf( stderr, "Trace could not be written\n" );
+		break;
+
 	default:
 		fprintf( stderr, "Unknown error\n" );
 		break;
 	}
 }
 
+/*******************************************************************************
+ * recordDetection
+ *
+ *     Runs InitAll on every adapter through a recording of the DXGI backend
+ *     and saves the recording.
+ *
+ ******************************************************************************/
+int recordDetection( int argc, char** argv )
+{
+	if( argc != 1 )
+	{
+		fprintf( stderr, "Error: expected a recording file name.\n" );
+		return EXIT_FAILURE;
+	}
+
+	GPUDetect::Context context;
+	GPUDetect::DxgiBackend backend( &context );
+	GPUDetect::BackendRecording recording;
+	const GPUDetect::BackendSources sources = recording.Record( backend.GetSources() );
+
+	const int adapterCount = sources.adapters->GetAdapterCount();
+	for( int i = 0; i < adapterCount; ++i )
+	{
+		GPUDetect::GPUData gpuData = {};
+		const int returnCode = GPUDetect::InitAll( &gpuData, sources, i );
+		fprintf( stdout, "Adapter #%d: %S\n", i, gpuData.description );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			printError( returnCode );
+		}
+	}
+
+	const int returnCode = recording.Save( argv[ 0 ] );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		printError( returnCode );
+		return EXIT_FAILURE;
+	}
+
+	fprintf( stdout, "Recorded %d adapters to %s\n", adapterCount, argv[ 0 ] );
+	return EXIT_SUCCESS;
+}
+
+/*******************************************************************************
+ * traceDetection
+ *
+ *     Runs InitAll on every adapter with timings, prints how long each stage
+ *     took and writes them as a Chrome trace.
+ *
+ ******************************************************************************/
+int traceDetection( int argc, char** argv )
+{
+	if( argc != 1 )
+	{
+		fprintf( stderr, "Error: expected a trace file name.\n" );
+		return EXIT_FAILURE;
+	}
+
+	int adapterCount = 0;
+	{
+		GPUDetect::Context context;
+		const int returnCode = context.GetAdapterCount( &adapterCount );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			printError( returnCode );
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Each adapter gets its own context, so every stage runs and is timed
+	std::vector< GPUDetect::Timings > timings( adapterCount );
+	for( int i = 0; i < adapterCount; ++i )
+	{
+		GPUDetect::GPUData gpuData = {};
+		const int returnCode = GPUDetect::InitAll( &gpuData, i, &timings[ i ] );
+
+		fprintf( stdout, "Adapter #%d: %S\n", i, gpuData.description );
+		if( returnCode != EXIT_SUCCESS )
+		{
+			printError( returnCode );
+		}
+
+		for( int stage = 0; stage < GPUDetect::Timings::STAGE_COUNT; ++stage )
+		{
+			const GPUDetect::Timings::Interval& interval = timings[ i ].stages[ stage ];
+			if( interval.endNs != 0 )
+			{
+				fprintf( stdout, "  %-20s %10.1f us\n", GPUDetect::GetTimingsStageName( (GPUDetect::Timings::Stage) stage ), ( interval.endNs - interval.startNs ) / 1000.0 );
+			}
+		}
+	}
+
+	const int returnCode = GPUDetect::WriteChromeTrace( timings.data(), timings.size(), argv[ 0 ] );
+	if( returnCode != EXIT_SUCCESS )
+	{
+		printError( returnCode );
+		return EXIT_FAILURE;
+	}
+
+	fprintf( stdout, "Trace written to %s\n", argv[ 0 ] );
+	return EXIT_SUCCESS;
+}
+
 /*******************************************************************************
  * main
  *
@@ -155,9 +273,21 @@ int main( int argc, char** argv )
 
 	int adapterIndex = 0;
 
+	if( argc >= 2 && strcmp( argv[ 1 ], "-record" ) == 0 )
+	{
+		return recordDetection( argc - 2, argv + 2 );
+	}
+
+	if( argc >= 2 && strcmp( argv[ 1 ], "-trace" ) == 0 )
+	{
+		return traceDetection( argc - 2, argv + 2 );
+	}
+
 	if( argc == 1 )
 	{
 		fprintf( stdout, "Usage: GPUDetect adapter_index\n" );
+		fprintf( stdout, "       GPUDetect -record file\n" );
+		fprintf( stdout, "       GPUDetect -trace file\n" );
 		fprintf( stdout, "Defaulting to adapter_index = %d\n", adapterIndex );
 	}
 	else if( argc == 2 && isnumber( argv[ 1 ] ))
@@ -168,6 +298,8 @@ int main( int argc, char** argv )
 	else
 	{
 		fprintf( stdout, "Usage: GPUDetect adapter_index\n" );
+		fprintf( stdout, "       GPUDetect -record file\n" );
+		fprintf( stdout, "       GPUDetect -trace file\n" );
 		fprintf( stderr, "Error: unexpected arguments.\n" );
 		return EXIT_FAILURE;
 	}
@@ -207,6 +339,31 @@ int main( int argc, char** argv )
 		fprintf( stdout, "Description: %S\n", gpuData.description );
 		fprintf( stdout, "\n" );
 
+		//
+		// Recommended way to upload each class of resource
+		//
+		uint64_t cpuVisibleLocalMemory = 0;
+		if( !gpuData.isUMAArchitecture )
+		{
+			const int barReturnCode = GPUDetect::GetCpuVisibleLocalMemory( adapter, &cpuVisibleLocalMemory );
+			if( barReturnCode != EXIT_SUCCESS )
+			{
+				printError( barReturnCode );
+			}
+			fprintf( stdout, "CPU-visible Local Memory: %I64u MB\n", cpuVisibleLocalMemory / ( 1024 * 1024 ) );
+		}
+
+		const char* resourceClassNames[ GPUDetect::UPLOAD_CLASS_COUNT ] = { "Constant Buffer", "Dynamic Buffer", "Static Buffer", "Texture" };
+		for( int resourceClass = 0; resourceClass < GPUDetect::UPLOAD_CLASS_COUNT; ++resourceClass )
+		{
+			GPUDetect::UploadAdvice advice = {};
+			if( GPUDetect::GetUploadAdvice( &gpuData, cpuVisibleLocalMemory, (GPUDetect::UploadResourceClass) resourceClass, &advice ) == EXIT_SUCCESS )
+			{
+				fprintf( stdout, "%s Upload: %s, %u byte alignment\n", resourceClassNames[ resourceClass ], GPUDetect::GetUploadPathName( advice.path ), advice.alignment );
+			}
+		}
+		fprintf( stdout, "\n" );
+
 		//
 		//  Find and print driver version information
 		//
@@ -298,10 +455,46 @@ int main( int argc, char** argv )
 				fprintf( stdout, "GPU Min Frequency: %u MHz\n", gpuData.minFrequency );
 			}
 
+			//
+			// Without counter data the score falls back to typical figures
+			// of the architecture
+			//
+			GPUDetect::ThroughputScore score = {};
+			if( GPUDetect::GetThroughputScore( &gpuData, &score ) == EXIT_SUCCESS )
+			{
+				fprintf( stdout, "\nThroughput%s\n", score.estimated ? " (estimated from architecture)" : "" );
+				fprintf( stdout, "FP32:              %.0f GFLOPS\n", score.fp32Gflops );
+				fprintf( stdout, "Texel Rate:        %.1f GTexels/s\n", score.texelRateGtexels );
+				fprintf( stdout, "Pixel Rate:        %.1f GPixels/s\n", score.pixelRateGpixels );
+				fprintf( stdout, "Memory Bandwidth:  %.1f GB/s\n", score.bandwidthGBs );
+				fprintf( stdout, "Score:             %.2f\n", score.score );
+			}
+
 			fprintf( stdout, "\n" );
 		}
 	}
 
+	//
+	// Integrated GPUs share power and memory with the CPU, so its
+	// capabilities matter to the preset as well
+	//
+	GPUDetect::CPUData cpuData = {};
+	initReturnCode = GPUDetect::InitCPUData( &cpuData );
+	if( initReturnCode != EXIT_SUCCESS )
+	{
+		printError( initReturnCode );
+	}
+	else
+	{
+		fprintf( stdout, "CPU\n" );
+		fprintf( stdout, "-----------------------\n" );
+		fprintf( stdout, "Vendor:            %s\n", cpuData.vendor );
+		fprintf( stdout, "Cores:             %u physical, %u logical\n", cpuData.physicalCoreCount, cpuData.logicalCoreCount );
+		fprintf( stdout, "Caches:            L1D %u KB, L2 %u KB, L3 %u KB\n", cpuData.l1DataCacheKB, cpuData.l2CacheKB, cpuData.l3CacheKB );
+		fprintf( stdout, "AVX-VNNI:          %s\n", ( cpuData.simdFeatures & GPUDetect::CPUData::SIMD_AVX_VNNI ) ? "yes" : "no" );
+		fprintf( stdout, "SIMD Tier:         %s\n", GPUDetect::GetSimdTierName( GPUDetect::GetSimdTier( &cpuData ) ) );
+	}
+
 	device->Release();
 	adapter->Release();
 